@@ -0,0 +1,263 @@
+/**
+ *  \file cachebench_sofs15.c (implementation file)
+ *
+ *  \brief The SOFS15 buffercache replacement policy benchmark.
+ *
+ *  It compares the replacement policies of the buffercache on a workload where a small set of hot blocks, standing
+ *  for the superblock, the inode table and the table of references to free data clusters, and of hot clusters,
+ *  standing for the clusters of references and of directory entries, is accessed by every operation, while the data
+ *  clusters are read at random by most operations and as a long sequential stream by a few of them. The hot blocks
+ *  (including those of the hot clusters) which had to be read from the storage device are counted for each policy.
+ *
+ *  SINOPSIS:
+ *  <P><PRE>                cachebench_sofs15 [OPTIONS] supp-file
+ *
+ *                OPTIONS:
+ *                 -o num --- set number of operations (default: 2000)
+ *                 -k num --- set number of hot blocks (default: 32)
+ *                 -c num --- set number of hot clusters (default: 16)
+ *                 -e num --- set number of operations between streaming reads (default: 200)
+ *                 -S num --- set number of clusters of a streaming read (default: 1024)
+ *                 -h     --- print this help.</PRE>
+ *
+ *  \remarks The contents of the storage device is only read.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sofs_const.h"
+#include "sofs_buffercache.h"
+#include "sofs_rawstats.h"
+
+/** \brief seed of the pseudo-random sequence of data clusters, the same for every policy */
+#define SEED  (12345)
+
+/** \brief results of the benchmark for a replacement policy */
+typedef struct benchResult
+{
+    uint64_t hotAccesses;                        /* number of accesses to hot blocks, counted block by block */
+    uint64_t hotMisses;                          /* number of them which had to be read from the storage device */
+    uint64_t hotMissesAfterScan;                 /* number of misses in the operations following a streaming read */
+    uint64_t nAfterScan;                         /* number of operations following a streaming read */
+} BenchResult;
+
+/* Allusion to internal functions */
+
+static int runBench (char *devname, uint32_t pol, uint32_t nBlk, uint32_t nOps, uint32_t nHot, uint32_t nHotClust,
+                     uint32_t every, uint32_t nScan, BenchResult *p_res);
+static uint64_t blockReads (void);
+static void printUsage (char *cmd_name);
+static void printError (int errcode, char *cmd_name);
+
+/* The main function */
+
+int main (int argc, char *argv[])
+{
+  char *devname;                                 /* path to the storage device in the Linux file system */
+  uint32_t nOps = 2000;                          /* number of operations */
+  uint32_t nHot = 32;                            /* number of hot blocks */
+  uint32_t nHotClust = 16;                       /* number of hot clusters */
+  uint32_t every = 200;                          /* number of operations between streaming reads */
+  uint32_t nScan = 1024;                         /* number of clusters of a streaming read */
+  long val;                                      /* numeric value of an option */
+
+  /* process command line options */
+
+  int opt;                                       /* selected option */
+
+  do
+  { switch ((opt = getopt (argc, argv, "o:k:c:e:S:h")))
+    { case 'o':
+      case 'k':
+      case 'c':
+      case 'e':
+      case 'S': val = atol (optarg);
+                if (val <= 0)
+                   { fprintf (stderr, "%s: Non positive value of option -%c.\n", basename (argv[0]), opt);
+                     printUsage (basename (argv[0]));
+                     return EXIT_FAILURE;
+                   }
+                if (opt == 'o') nOps = (uint32_t) val;
+                else if (opt == 'k') nHot = (uint32_t) val;
+                else if (opt == 'c') nHotClust = (uint32_t) val;
+                else if (opt == 'e') every = (uint32_t) val;
+                else nScan = (uint32_t) val;
+                break;
+      case 'h': /* help mode */
+                printUsage (basename (argv[0]));
+                return EXIT_SUCCESS;
+      case '?': /* unknown option */
+                fprintf (stderr, "%s: Wrong option.\n", basename (argv[0]));
+                printUsage (basename (argv[0]));
+                return EXIT_FAILURE;
+    }
+  } while (opt != -1);
+  if ((argc - optind) != 1)                      /* check existence of mandatory argument: storage device name */
+     { fprintf (stderr, "%s: Wrong number of mandatory arguments.\n", basename (argv[0]));
+       printUsage (basename (argv[0]));
+       return EXIT_FAILURE;
+     }
+
+  /* check for storage device conformity */
+
+  struct stat st;                                /* file attributes */
+  uint32_t nBlk;                                 /* number of blocks of the storage device */
+
+  devname = argv[optind];
+  if (stat (devname, &st) == -1)                 /* get file attributes */
+     { printError (-errno, basename (argv[0]));
+       return EXIT_FAILURE;
+     }
+  if (st.st_size % BLOCK_SIZE != 0)              /* check file size: the storage device must have a size in bytes
+                                                    multiple of block size */
+     { fprintf (stderr, "%s: Bad size of support file.\n", basename (argv[0]));
+       return EXIT_FAILURE;
+     }
+  nBlk = st.st_size / BLOCK_SIZE;
+  if ((uint64_t) nHot + BLOCKS_PER_CLUSTER + ((uint64_t) nHotClust + nScan) * BLOCKS_PER_CLUSTER > nBlk)
+     { fprintf (stderr, "%s: Support file too small for the hot blocks and clusters and a streaming read.\n",
+                basename (argv[0]));
+       return EXIT_FAILURE;
+     }
+
+  /* run the benchmark for every replacement policy */
+
+  static const uint32_t pols[] = { CACHE_LRU, CACHE_2Q };
+  static const char *polName[] = { "LRU", "2Q" };
+  BenchResult res;                               /* results of the benchmark */
+  uint32_t i;
+  int status;                                    /* status of operation */
+
+  printf ("%"PRIu32" operations, %"PRIu32" hot blocks, %"PRIu32" hot clusters, a streaming read of %"PRIu32
+          " clusters every %"PRIu32" operations\n\n", nOps, nHot, nHotClust, nScan, every);
+  printf ("policy  hot accesses  hot misses  miss ratio  misses after a streaming read\n");
+  for (i = 0; i < sizeof (pols) / sizeof (pols[0]); i++)
+  { if ((status = runBench (devname, pols[i], nBlk, nOps, nHot, nHotClust, every, nScan, &res)) != 0)
+       { printError (status, basename (argv[0]));
+         return EXIT_FAILURE;
+       }
+    printf ("%-6s  %12"PRIu64"  %10"PRIu64"  %9.2f%%  %29.1f\n", polName[i], res.hotAccesses, res.hotMisses,
+            100.0 * res.hotMisses / res.hotAccesses,
+            (res.nAfterScan == 0) ? 0.0 : (double) res.hotMissesAfterScan / res.nAfterScan);
+  }
+
+  /* that's all */
+
+  return EXIT_SUCCESS;
+
+} /* end of main */
+
+/*
+ * run the benchmark for a replacement policy
+ *
+ * Every operation reads the hot blocks, which are the first ones of the storage device, and the hot clusters, which
+ * follow them, and then either a data cluster, chosen at random, or, every 'every' operations, a stream of successive
+ * data clusters, each streaming read going on where the previous one has stopped.
+ */
+
+static int runBench (char *devname, uint32_t pol, uint32_t nBlk, uint32_t nOps, uint32_t nHot, uint32_t nHotClust,
+                     uint32_t every, uint32_t nScan, BenchResult *p_res)
+{
+  unsigned char buffer[CLUSTER_SIZE];            /* buffer to store block/cluster contents */
+  unsigned char *stream;                         /* buffer to store the clusters of a streaming read */
+  uint32_t hot;                                  /* physical number of the first hot cluster */
+  uint32_t first;                                /* physical number of the first data cluster */
+  uint32_t nClust;                               /* number of data clusters */
+  uint32_t next = 0;                             /* index of the data cluster where the next streaming read starts */
+  uint32_t op, i;
+  uint64_t before, miss;                         /* number of blocks read from the storage device */
+  int stat;                                      /* status of operation */
+
+  memset (p_res, 0, sizeof (BenchResult));
+  hot = (nHot + BLOCKS_PER_CLUSTER - 1) / BLOCKS_PER_CLUSTER * BLOCKS_PER_CLUSTER;
+  first = hot + nHotClust * BLOCKS_PER_CLUSTER;
+  nClust = (nBlk - first) / BLOCKS_PER_CLUSTER;
+  if ((stream = malloc ((size_t) nScan * CLUSTER_SIZE)) == NULL) return -ENOMEM;
+  if ((stat = soOpenBufferCachePolicy (devname, BUF, pol)) != 0)
+     { free (stream);
+       return stat;
+     }
+  srand (SEED);
+
+  for (op = 0; op < nOps; op++)
+  { /* access the hot blocks and clusters */
+
+    before = blockReads ();
+    for (i = 0; i < nHot; i++)
+      if ((stat = soReadCacheBlock (i, buffer)) != 0) break;
+    for (i = 0; (stat == 0) && (i < nHotClust); i++)
+      stat = soReadCacheCluster (hot + i * BLOCKS_PER_CLUSTER, buffer);
+    if (stat != 0) break;
+    miss = blockReads () - before;
+    p_res->hotAccesses += nHot + nHotClust * BLOCKS_PER_CLUSTER;
+    p_res->hotMisses += miss;
+    if ((op > 0) && ((op - 1) % every == 0))
+       { p_res->hotMissesAfterScan += miss;
+         p_res->nAfterScan += 1;
+       }
+
+    /* access the data clusters */
+
+    if (op % every == 0)
+       { if (next + nScan > nClust) next = 0;
+         stat = soReadCacheClusters (first + next * BLOCKS_PER_CLUSTER, nScan, stream);
+         next += nScan;
+       }
+       else stat = soReadCacheClusters (first + (rand () % nClust) * BLOCKS_PER_CLUSTER, 1, buffer);
+    if (stat != 0) break;
+  }
+  free (stream);
+  if (stat != 0)
+     { soCloseBufferCache ();
+       return stat;
+     }
+
+  return soCloseBufferCache ();
+}
+
+/*
+ * get the number of blocks which were read from the storage device
+ */
+
+static uint64_t blockReads (void)
+{
+  SORawStats stats;                              /* statistics of the raw disk module */
+
+  soGetRawStats (&stats);
+
+  return stats.op[RAWOP_READ_BLOCK].nCalls + stats.op[RAWOP_READ_CLUSTER].nCalls * BLOCKS_PER_CLUSTER +
+         stats.op[RAWOP_READ_CLUSTERS].nBytes / BLOCK_SIZE;
+}
+
+/*
+ * print help message
+ */
+
+static void printUsage (char *cmd_name)
+{
+  printf ("Sinopsis: %s [OPTIONS] supp-file\n"
+          "  OPTIONS:\n"
+          "  -o num --- set number of operations (default: 2000)\n"
+          "  -k num --- set number of hot blocks (default: 32)\n"
+          "  -c num --- set number of hot clusters (default: 16)\n"
+          "  -e num --- set number of operations between streaming reads (default: 200)\n"
+          "  -S num --- set number of clusters of a streaming read (default: 1024)\n"
+          "  -h     --- print this help\n", cmd_name);
+}
+
+/*
+ * print error message
+ */
+
+static void printError (int errcode, char *cmd_name)
+{
+  fprintf(stderr, "%s: error #%d - %s.\n", cmd_name, -errcode, strerror (-errcode));
+}
@@ -0,0 +1,24 @@
+/**
+ *  \file cachebench_sofs15.h (interface file)
+ *
+ *  \brief The SOFS15 buffercache replacement policy benchmark.
+ *
+ *  It compares the replacement policies of the buffercache on a workload where a small set of hot blocks, standing
+ *  for the superblock, the inode table and the table of references to free data clusters, and of hot clusters,
+ *  standing for the clusters of references and of directory entries, is accessed by every operation, while the data
+ *  clusters are read at random by most operations and as a long sequential stream by a few of them. The hot blocks
+ *  (including those of the hot clusters) which had to be read from the storage device are counted for each policy.
+ *
+ *  SINOPSIS:
+ *  <P><PRE>                cachebench_sofs15 [OPTIONS] supp-file
+ *
+ *                OPTIONS:
+ *                 -o num --- set number of operations (default: 2000)
+ *                 -k num --- set number of hot blocks (default: 32)
+ *                 -c num --- set number of hot clusters (default: 16)
+ *                 -e num --- set number of operations between streaming reads (default: 200)
+ *                 -S num --- set number of clusters of a streaming read (default: 1024)
+ *                 -h     --- print this help.</PRE>
+ *
+ *  \remarks The contents of the storage device is only read.
+ */
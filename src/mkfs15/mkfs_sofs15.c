@@ -19,9 +19,18 @@
  *                 -n name --- set volume name (default: "SOFS15")
  *                 -i num  --- set number of inodes (default: N/8, where N = number of blocks)
  *                 -z      --- set zero mode (default: not zero)
+ *                 -s      --- set sparse mode (default: not sparse)
  *                 -q      --- set quiet mode (default: not quiet)
+ *                 -S unit,file[,file...] --- stripe the storage device over supp-file and the files which are given,
+ *                                            in stripe units of unit clusters (default: no striping)
  *                 -h      --- print this help.</PRE>
  *
+ *  The geometry of the storage device is fixed (see sofs_const.h): it is recorded in the superblock for reference only.
+ *
+ *  In sparse mode, the storage of all free data clusters is released from the supporting file, instead of being
+ *  written with zeros: their contents is read as zeros just the same, but the supporting file is kept sparse. If the
+ *  file system that holds the supporting file can not release storage, they are written with zeros instead.
+ *
  *  \author Artur Carneiro Pereira - September 2008
  *  \author Miguel Oliveira e Silva - September 2009
  *  \author António Rui Borges - September 2010 - August 2015
@@ -40,6 +49,7 @@
 #include <errno.h>
 
 #include "sofs_const.h"
+#include "sofs_rawdisk.h"
 #include "sofs_buffercache.h"
 #include "sofs_superblock.h"
 #include "sofs_inode.h"
@@ -53,7 +63,7 @@ static int fillInSuperBlock (SOSuperBlock *p_sb, uint32_t ntotal, uint32_t itota
 		                     uint32_t nclusttotal, unsigned char *name);
 static int fillInINT (SOSuperBlock *p_sb);
 static int fillInRootDir (SOSuperBlock *p_sb);
-static int fillInTRefFDC (SOSuperBlock *p_sb, int zero);
+static int fillInTRefFDC (SOSuperBlock *p_sb, int zero, int sparse);
 static int checkFSConsist (void);
 static void printUsage (char *cmd_name);
 static void printError (int errcode, char *cmd_name);
@@ -66,13 +76,18 @@ int main (int argc, char *argv[])
   uint32_t itotal = 0;                           /* total number of inodes, if kept, set value automatically */
   int quiet = 0;                                 /* quiet mode, if kept, set not quiet mode */
   int zero = 0;                                  /* zero mode, if kept, set not zero mode */
+  int sparse = 0;                                /* sparse mode, if kept, set not sparse mode */
+  const char *stripe_file[STRIPE_MAX_FILES];     /* supporting files the storage device is striped over */
+  uint32_t stripe_n = 0;                         /* number of supporting files besides supp-file, if kept, set not
+                                                    striped */
+  uint32_t stripe_unit = 0;                      /* stripe unit (number of clusters) */
 
   /* process command line options */
 
   int opt;                                       /* selected option */
 
   do
-  { switch ((opt = getopt (argc, argv, "n:i:qzh")))
+  { switch ((opt = getopt (argc, argv, "n:i:qzsS:h")))
     { case 'n': /* volume name */
                 name = optarg;
                 break;
@@ -91,6 +106,28 @@ int main (int argc, char *argv[])
                 zero = 1;                        /* set zero mode for processing: the information content of all free
                                                     data clusters are set to zero */
                 break;
+      case 's': /* sparse mode */
+                sparse = 1;                      /* set sparse mode for processing: the storage of all free data
+                                                    clusters is released from the supporting file */
+                break;
+      case 'S': /* supporting files the storage device is striped over */
+                { char *end;                     /* end of the stripe unit in the argument */
+                  char *file = NULL;             /* name of a supporting file */
+
+                  stripe_unit = (uint32_t) strtoul (optarg, &end, 10);
+                  stripe_n = 0;
+                  if ((end != optarg) && (*end == ','))
+                     for (file = strtok (end + 1, ","); (file != NULL) && (stripe_n < STRIPE_MAX_FILES - 1);
+                          file = strtok (NULL, ","))
+                       stripe_file[++stripe_n] = file;
+                  if ((file != NULL) || (stripe_n == 0) ||
+                      (soSetCacheStripes (stripe_n, stripe_file + 1, stripe_unit) != 0))
+                     { fprintf (stderr, "%s: Bad argument to S option.\n", basename (argv[0]));
+                       printUsage (basename (argv[0]));
+                       return EXIT_FAILURE;
+                     }
+                }
+                break;
       case 'h': /* help mode */
                 printUsage (basename (argv[0]));
                 return EXIT_SUCCESS;
@@ -116,8 +153,8 @@ int main (int argc, char *argv[])
      { printError (-errno, basename (argv[0]));
        return EXIT_FAILURE;
      }
-  if (st.st_size % BLOCK_SIZE != 0)              /* check file size: the storage device must have a size in bytes
-                                                    multiple of block size */
+  if ((stripe_n == 0) && (st.st_size % BLOCK_SIZE != 0))  /* check file size: the storage device must have a size
+                                                              in bytes multiple of block size */
      { fprintf (stderr, "%s: Bad size of support file.\n", basename (argv[0]));
        return EXIT_FAILURE;
      }
@@ -147,7 +184,17 @@ int main (int argc, char *argv[])
   uint32_t fcblktotal;                           /* number of blocks of the table of references to data clusters */
   uint32_t tmp;                                  /* temporary variable */
 
-  ntotal = st.st_size / BLOCK_SIZE;
+  if (stripe_n == 0)
+     ntotal = st.st_size / BLOCK_SIZE;
+     else { int status;                          /* status of operation */
+
+            stripe_file[0] = devname;            /* the stripes take as many blocks as fit in the smallest file */
+            if ((status = soOpenStripedDevice (stripe_n + 1, stripe_file, stripe_unit, &ntotal)) != 0)
+               { printError (status, basename (argv[0]));
+                 return EXIT_FAILURE;
+               }
+            soCloseDevice ();
+          }
   if (itotal == 0) itotal = ntotal >> 3;         /* use the default value */
   if ((itotal % IPB) == 0)
      iblktotal = itotal / IPB;
@@ -251,6 +298,7 @@ int main (int argc, char *argv[])
    * create the table of references to free data clusters as a static linear FIFO
    * zero fill the remaining data clusters if full formating was required:
    *   zero mode was selected
+   * release the storage of the remaining data clusters if sparse mode was selected
    */
 
   if (!quiet)
@@ -258,7 +306,7 @@ int main (int argc, char *argv[])
        fflush (stdout);                          /* make sure the message is printed now */
      }
 
-  if ((status = fillInTRefFDC (p_sb, zero)) != 0)
+  if ((status = fillInTRefFDC (p_sb, zero, sparse)) != 0)
      { printError (status, basename (argv[0]));
        soCloseBufferCache ();
        return EXIT_FAILURE;
@@ -266,11 +314,11 @@ int main (int argc, char *argv[])
 
   if (!quiet) printf ("done.\n");
 
-  /* magic number should now be set to the right value before writing the contents of the superblock to the storage
-     device */
+  /* the blocks of the table of inodes kept in internal storage are written back and the magic number should now be
+     set to the right value before writing the contents of the superblock to the storage device */
 
   p_sb->magic = MAGIC_NUMBER;
-  if ((status = soStoreSuperBlock ()) != 0)
+  if (((status = soFlushBlocksInT ()) != 0) || ((status = soStoreSuperBlock ()) != 0))
      return status;
 
   /* check the consistency of the file system metadata */
@@ -314,7 +362,10 @@ static void printUsage (char *cmd_name)
           "  -n name --- set volume name (default: \"SOFS15\")\n"
           "  -i num  --- set number of inodes (default: N/8, where N = number of blocks)\n"
           "  -z      --- set zero mode (default: not zero)\n"
+          "  -s      --- set sparse mode (default: not sparse)\n"
           "  -q      --- set quiet mode (default: not quiet)\n"
+          "  -S unit,file[,file...] --- stripe the storage device over supp-file and the files which are given,\n"
+          "                             in stripe units of unit clusters (default: no striping)\n"
           "  -h      --- print this help\n", cmd_name);
 }
 
@@ -377,6 +428,10 @@ static int fillInSuperBlock (SOSuperBlock *p_sb, uint32_t ntotal, uint32_t itota
   p_sb->dzone_total = nclusttotal; /* total number of data clusters */
   p_sb->dzone_free = nclusttotal-1; /* number of free data clusters */
 
+  /* GEOMETRY */
+  p_sb->block_size = BLOCK_SIZE; /* block size in bytes */
+  p_sb->blocks_per_cluster = BLOCKS_PER_CLUSTER; /* number of contiguous blocks in a cluster */
+
 
   /*Retrieval Cache*/
   p_sb->dzone_retriev.cache_idx=DZONE_CACHE_SIZE; /* retrieval cache of references to free data clusters */
@@ -389,7 +444,7 @@ static int fillInSuperBlock (SOSuperBlock *p_sb, uint32_t ntotal, uint32_t itota
           p_sb->dzone_insert.cache[i] = NULL_CLUSTER;
 
   /* RESERVED ZONE */ 
-  for (i = 0; i < BLOCK_SIZE - PARTITION_NAME_SIZE - 1 - 16 * sizeof(uint32_t) - 2 * sizeof(struct fCNode); i++)
+  for (i = 0; i < (int) sizeof (p_sb->reserved); i++)
           p_sb->reserved[i] = 0xee; // 0xEE was suggested by prof Borges
 
   int stat; // function return control
@@ -527,9 +582,11 @@ static int fillInRootDir (SOSuperBlock *p_sb)
    * create the table of references to free data clusters as a static circular FIFO
    * zero fill the remaining data clusters if full formating was required:
    *   zero mode was selected
+   * release the storage of the remaining data clusters if sparse mode was selected (it takes precedence, the
+   * contents is read as zeros all the same); if the storage can not be released, they are zero filled instead
    */
 
-static int fillInTRefFDC (SOSuperBlock *p_sb, int zero)
+static int fillInTRefFDC (SOSuperBlock *p_sb, int zero, int sparse)
 {
     int status;                     //  error variable  
     int32_t i, j;           
@@ -564,8 +621,15 @@ static int fillInTRefFDC (SOSuperBlock *p_sb, int zero)
         // store the block in the disk
         if((status = soStoreBlockFCT()) != 0) return status;
     }
-    // if zero erase data zone
-    if(zero)
+    // if sparse release the data zone, starting in the second data cluster
+    if(sparse && ((status = soDiscardCacheClusters(p_sb->dzone_start+BLOCKS_PER_CLUSTER, p_sb->dzone_total-1))
+                  != -EOPNOTSUPP))
+    {
+        if (status != 0)
+            return status;
+    }
+    // if zero, or sparse but the supporting file can not release storage, erase data zone
+    else if(zero || sparse)
     {
  
         // Run all data zone, starting in the second data cluster
@@ -12,6 +12,21 @@
  *                 -d       --- set debugging mode (default: no debugging)
  *                 -l depth --- set log depth (default: 0,0)
  *                 -L file  --- log file (default: stdout)
+ *                 -t       --- set discard mode: release the storage of freed data clusters (default: no discard)
+ *                 -w ratio,age,rate --- start the background flusher of the buffercache: high watermark of changed
+ *                                       blocks (percentage), maximum age of a change (ms) and maximum rate (blocks per
+ *                                       second), 0 meaning unlimited (default: no flusher)
+ *                 -r init,max       --- set the readahead of the buffercache: initial and maximum window (clusters)
+ *                                       (default: no readahead)
+ *                 -c size[,huge]    --- set the size of the buffercache, in bytes or with a K, M or G suffix, backed by
+ *                                       huge pages if so required (default: 512K)
+ *                 -m size           --- set the size of the metadata partition of the buffercache, where the clusters
+ *                                       of references are kept apart from data, in bytes or with a K, M or G suffix,
+ *                                       up to a quarter of the buffercache (default: no partition)
+ *                 -s slots          --- set the number of clusters of single indirect references, and of direct
+ *                                       references, kept apart from the buffercache (default: 8, at most 32)
+ *                 -S unit,file[,file...] --- stripe the storage device over supp-file and the files which are given,
+ *                                       in stripe units of unit clusters (default: no striping)
  *                 -h       --- print this help.</PRE>
  *
  *  \author Artur Carneiro Pereira - October 2005
@@ -22,7 +37,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <inttypes.h>
+#include <time.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <pthread.h>
@@ -33,7 +50,12 @@
 
 #include "sofs_probe.h"
 #include "sofs_const.h"
+#include "sofs_rawdisk.h"
+#include "sofs_buffercache.h"
+#include "sofs_superblock.h"
 #include "sofs_direntry.h"
+#include "sofs_basicoper.h"
+#include "sofs_ifuncs_4.h"
 #include "sofs_syscalls.h"
 
 /*
@@ -79,6 +101,12 @@ static int sofs_getxattr (const char *ePath, const char *name, char *value, size
 static int sofs_listxattr (const char *ePath, char *list, size_t size);
 static int sofs_removexattr (const char *ePath, const char *name);
 static void printUsage (char *cmd_name);
+static int syncFile (const char *ePath);
+static int setMountStat (uint32_t mstat);
+static int startSync (void);
+static void stopSync (void);
+static void *syncLoop (void *arg);
+static void dumpRefClustStats (void);
 
 /*
  *  Set of FUSE operations (required by the FUSE filesystem)
@@ -132,6 +160,30 @@ static struct fuse_operations fuse_operations = {.getattr     = sofs_getattr,
 
 static char *sofs_supp_file = NULL;
 
+/* Parameters of the background flusher of the buffercache (not started, if the ratio is zero) */
+
+static uint32_t flush_ratio = 0, flush_age = 0, flush_rate = 0;
+
+/* Windows of the readahead of the buffercache (no readahead, if the maximum window is zero) */
+
+static uint32_t ahead_init = 0, ahead_max = 0;
+
+/* Supporting files the storage device is striped over, the first one being the supporting file (not striped, if there
+   are no other files) and stripe unit (number of clusters) */
+
+static const char *stripe_file[STRIPE_MAX_FILES];
+static uint32_t stripe_n = 0, stripe_unit = 0;
+
+/* Periodic write-back of the superblock and of the blocks of the table of inodes kept apart from the buffercache, while
+   the file system is mounted: period (in seconds), thread which carries it out, flag signaling it is running and
+   condition signaled to stop it */
+
+#define SYNC_PERIOD  5
+
+static pthread_t sync_thread;
+static bool sync_on = false;
+static pthread_cond_t sync_stop = PTHREAD_COND_INITIALIZER;
+
 /* The main function */
 
 int main(int argc, char *argv[])
@@ -146,7 +198,7 @@ int main(int argc, char *argv[])
   int opt;                                       /* selected option */
 
   do
-  { switch ((opt = getopt (argc, argv, "l:L:dh")))
+  { switch ((opt = getopt (argc, argv, "l:L:dtw:r:c:m:s:S:h")))
     { case 'l': /* log depth */
                 if (sscanf (optarg, "%d,%d", &lower, &higher) != 2)
                    { fprintf (stderr, "%s: Bad argument to l option.\n", basename (argv[0]));
@@ -166,6 +218,90 @@ int main(int argc, char *argv[])
       case 'd': /* debugging mode */
                 debug_mode = 1;                  /* set debugging mode for processing: no FUSE messages are issued */
                 break;
+      case 't': /* discard mode */
+                soSetDiscardMode (true);         /* set discard mode for processing: the storage of the data clusters
+                                                    which are freed is released from the supporting file */
+                break;
+      case 'w': /* background flusher */
+                if ((sscanf (optarg, "%"SCNu32",%"SCNu32",%"SCNu32, &flush_ratio, &flush_age, &flush_rate) != 3) ||
+                    (flush_ratio == 0) || (flush_ratio > 100))
+                   { fprintf (stderr, "%s: Bad argument to w option.\n", basename (argv[0]));
+                     printUsage (basename (argv[0]));
+                     return EXIT_FAILURE;
+                   }
+                break;
+      case 'r': /* readahead */
+                if ((sscanf (optarg, "%"SCNu32",%"SCNu32, &ahead_init, &ahead_max) != 2) || (ahead_init == 0) ||
+                    (ahead_init > ahead_max) || (ahead_max > MAX_READAHEAD))
+                   { fprintf (stderr, "%s: Bad argument to r option.\n", basename (argv[0]));
+                     printUsage (basename (argv[0]));
+                     return EXIT_FAILURE;
+                   }
+                break;
+      case 'c': /* size of the buffercache */
+                { char *end;                     /* end of the size in the argument */
+                  uint64_t size = strtoull (optarg, &end, 10);         /* size of the buffercache */
+
+                  switch (*end)
+                  { case 'K': size <<= 10; end++; break;
+                    case 'M': size <<= 20; end++; break;
+                    case 'G': size <<= 30; end++; break;
+                  }
+                  if ((end == optarg) || ((*end != '\0') && (strcmp (end, ",huge") != 0)) ||
+                      (soSetBufferCacheSize (size, *end != '\0') != 0))
+                     { fprintf (stderr, "%s: Bad argument to c option.\n", basename (argv[0]));
+                       printUsage (basename (argv[0]));
+                       return EXIT_FAILURE;
+                     }
+                }
+                break;
+      case 'm': /* size of the metadata partition of the buffercache */
+                { char *end;                     /* end of the size in the argument */
+                  uint64_t size = strtoull (optarg, &end, 10);         /* size of the metadata partition */
+
+                  switch (*end)
+                  { case 'K': size <<= 10; end++; break;
+                    case 'M': size <<= 20; end++; break;
+                    case 'G': size <<= 30; end++; break;
+                  }
+                  if ((end == optarg) || (*end != '\0') || (soSetCacheMetaSize (size) != 0))
+                     { fprintf (stderr, "%s: Bad argument to m option.\n", basename (argv[0]));
+                       printUsage (basename (argv[0]));
+                       return EXIT_FAILURE;
+                     }
+                }
+                break;
+      case 's': /* number of clusters of references kept in internal storage */
+                { uint32_t n;                    /* number of clusters of each kind */
+
+                  if ((sscanf (optarg, "%"SCNu32, &n) != 1) || (soSetRefClustSlots (n) != 0))
+                     { fprintf (stderr, "%s: Bad argument to s option.\n", basename (argv[0]));
+                       printUsage (basename (argv[0]));
+                       return EXIT_FAILURE;
+                     }
+                }
+                break;
+      case 'S': /* supporting files the storage device is striped over */
+                { char *end;                     /* end of the stripe unit in the argument */
+                  char *file = NULL;             /* name of a supporting file */
+
+                  stripe_unit = (uint32_t) strtoul (optarg, &end, 10);
+                  stripe_n = 0;
+                  if ((end != optarg) && (*end == ','))
+                     { for (file = strtok (end + 1, ","); (file != NULL) && (stripe_n < STRIPE_MAX_FILES - 1);
+                            file = strtok (NULL, ","))
+                       { if ((stripe_file[stripe_n+1] = realpath (file, NULL)) == NULL) break;
+                         stripe_n++;
+                       }
+                     }
+                  if ((file != NULL) || (stripe_n == 0) ||
+                      (soSetCacheStripes (stripe_n, stripe_file + 1, stripe_unit) != 0))
+                     { fprintf (stderr, "%s: Bad argument to S option.\n", basename (argv[0]));
+                       printUsage (basename (argv[0]));
+                       return EXIT_FAILURE;
+                     }
+                }
+                break;
       case 'h': /* help mode */
                 printUsage (basename (argv[0]));
                 return EXIT_SUCCESS;
@@ -188,6 +324,20 @@ int main(int argc, char *argv[])
        return EXIT_FAILURE;
      }
 
+  /* check the storage device, namely the supporting files it is striped over */
+
+  uint32_t nblks;                                /* number of blocks of the storage device */
+  int stat;                                      /* status of operation */
+
+  stripe_file[0] = sofs_supp_file;
+  stat = (stripe_n == 0) ? soOpenDevice (sofs_supp_file, &nblks)
+                         : soOpenStripedDevice (stripe_n + 1, stripe_file, stripe_unit, &nblks);
+  if (stat == 0) soCloseDevice ();
+  if (stat != 0)
+     { fprintf (stderr, "%s: Checking the storage device - %s.\n", basename (argv[0]), strerror (-stat));
+       return EXIT_FAILURE;
+     }
+
   if (fl == NULL)
      fl = stdout;                                /* if the switch -L was not used, set output to stdout */
      else stderr = fl;                           /* if the switch -L was used, set stderr to log file */
@@ -217,9 +367,140 @@ static void printUsage (char *cmd_name)
           "  -d       --- set debugging mode (default: no debugging)\n"
           "  -l depth --- set log depth (default: 0,0)\n"
           "  -L file  --- log file (default: stdout)\n"
+          "  -t       --- set discard mode: release the storage of freed data clusters (default: no discard)\n"
+          "  -w ratio,age,rate --- start the background flusher of the buffercache: high watermark of changed\n"
+          "                        blocks (percentage), maximum age of a change (ms) and maximum rate (blocks per\n"
+          "                        second), 0 meaning unlimited (default: no flusher)\n"
+          "  -r init,max       --- set the readahead of the buffercache: initial and maximum window (clusters)\n"
+          "                        (default: no readahead)\n"
+          "  -c size[,huge]    --- set the size of the buffercache, in bytes or with a K, M or G suffix, backed by\n"
+          "                        huge pages if so required (default: 512K)\n"
+          "  -m size           --- set the size of the metadata partition of the buffercache, where the clusters of\n"
+          "                        references are kept apart from data, in bytes or with a K, M or G suffix, up to\n"
+          "                        a quarter of the buffercache (default: no partition)\n"
+          "  -s slots          --- set the number of clusters of single indirect references, and of direct\n"
+          "                        references, kept apart from the buffercache (default: 8, at most 32)\n"
+          "  -S unit,file[,file...] --- stripe the storage device over supp-file and the files which are given,\n"
+          "                        in stripe units of unit clusters (default: no striping)\n"
           "  -h       --- print this help\n", cmd_name);
 }
 
+/*
+ * synchronize the changes of a file: its data clusters, its clusters of references and its block of the table of
+ * inodes, besides the blocks shared with other files, are written, the changes of the other files being left in the
+ * buffercache (see soSetCacheOwner)
+ */
+
+static int syncFile (const char *ePath)
+{
+  uint32_t nInodeEnt;                            /* number of the inode associated to the file */
+  int stat;
+
+  if (pthread_mutex_lock (&accessCR) != 0)                           /* enter critical region */
+     return -ENOLCK;
+
+  if (((stat = soLoadSuperBlock ()) == 0) && ((stat = soGetDirEntryByPath (ePath, NULL, &nInodeEnt)) == 0) &&
+      ((stat = soFlushBlocksInT ()) == 0) && ((stat = soFlushSuperBlock ()) == 0))
+     stat = soSyncCacheOwner (nInodeEnt);
+
+  if (pthread_mutex_unlock (&accessCR) != 0)                         /* exit critical region */
+     return -ENOLCK;
+
+  return stat;
+}
+
+/*
+ * mark the file system as mounted (NPRU), so that the superblock is written back only when needed (see
+ * soStoreSuperBlock), or as properly unmounted (PRU), the superblock being written at once
+ */
+
+static int setMountStat (uint32_t mstat)
+{
+  SOSuperBlock *p_sb;                            /* pointer to the superblock */
+  int stat;
+
+  if ((stat = soLoadSuperBlock ()) != 0) return stat;
+  p_sb = soGetSuperBlock ();
+  p_sb->mstat = mstat;
+
+  return soStoreSuperBlock ();
+}
+
+/*
+ * start the periodic write-back of the superblock and of the blocks of the table of inodes kept apart from the
+ * buffercache, so that they are not kept changed in internal storage indefinitely (see soStoreSuperBlock)
+ */
+
+static int startSync (void)
+{
+  int stat;
+
+  sync_on = true;
+  if ((stat = pthread_create (&sync_thread, NULL, syncLoop, NULL)) != 0)
+     { sync_on = false;
+       return -stat;
+     }
+
+  return 0;
+}
+
+/*
+ * stop the periodic write-back, if it is running
+ */
+
+static void stopSync (void)
+{
+  if (!sync_on) return;
+
+  pthread_mutex_lock (&accessCR);                                    /* enter critical region */
+  sync_on = false;
+  pthread_cond_signal (&sync_stop);
+  pthread_mutex_unlock (&accessCR);                                  /* exit critical region */
+  pthread_join (sync_thread, NULL);
+}
+
+/*
+ * write back every SYNC_PERIOD seconds, within the critical region, the blocks of the table of inodes which were
+ * stored and the superblock, which is written before them, if it was stored (see soStoreSuperBlock)
+ */
+
+static void *syncLoop (void *arg)
+{
+  struct timespec deadline;                      /* time of the next write-back */
+
+  (void) arg;
+
+  pthread_mutex_lock (&accessCR);                                    /* enter critical region */
+  while (sync_on)
+  { clock_gettime (CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += SYNC_PERIOD;
+    while (sync_on && (pthread_cond_timedwait (&sync_stop, &accessCR, &deadline) != ETIMEDOUT));
+    if (sync_on && (soFlushBlocksInT () == 0))   /* a failure is reported by the next operation */
+       soFlushSuperBlock ();
+  }
+  pthread_mutex_unlock (&accessCR);                                  /* exit critical region */
+
+  return NULL;
+}
+
+/*
+ * print the statistics of the accesses to the clusters of references kept apart from the buffercache through the
+ * probing system, with depth 850, as the statistics of the buffercache and of the raw disk are
+ */
+
+static void dumpRefClustStats (void)
+{
+  char *text = NULL;                             /* the statistics printed as a string */
+  size_t len = 0;
+  FILE *fs;
+
+  if ((fs = open_memstream (&text, &len)) == NULL) return;
+  soPrintRefClustStats (fs);
+  fclose (fs);
+  if (len > 0) soProbe (850, "clusters of references statistics\n%s", text);
+  free (text);
+}
+
 /* Functions to be implemented */
 
 /**
@@ -242,6 +523,14 @@ static void *sofs_mount (struct fuse_conn_info* fci)
   int stat;
 
   if ((stat = soMountSOFS (sofs_supp_file)) != 0) return NULL;
+  if ((stat = setMountStat (NPRU)) != 0)         /* the superblock is written back from now on only when needed */
+     fprintf (stderr, "sofs_mount: Marking the file system as mounted - %s.\n", strerror (-stat));
+  if ((stat = startSync ()) != 0)
+     fprintf (stderr, "sofs_mount: Starting the periodic write-back of the superblock - %s.\n", strerror (-stat));
+  if ((flush_ratio != 0) && ((stat = soStartCacheFlusher (flush_ratio, flush_age, flush_rate)) != 0))
+     fprintf (stderr, "sofs_mount: Starting the flusher of the buffercache - %s.\n", strerror (-stat));
+  if ((ahead_max != 0) && ((stat = soSetCacheReadahead (ahead_init, ahead_max)) != 0))
+     fprintf (stderr, "sofs_mount: Setting the readahead of the buffercache - %s.\n", strerror (-stat));
   return sofs_supp_file;
 }
 
@@ -259,8 +548,13 @@ static void sofs_unmount (void *path)
 {
   soColorProbe (112, "07;31", "sofs_unmount_bin (\"%s\")\n", (char *) path);
 
+  stopSync ();                                   /* the periodic write-back is replaced by the last one */
+
   pthread_mutex_lock (&accessCR);                                    /* enter critical region */
 
+  soFlushBlocksInT ();                           /* the blocks of the table of inodes kept apart are written back */
+  setMountStat (PRU);                            /* the superblock is written back, marked properly unmounted */
+  dumpRefClustStats ();                          /* hit rate of the clusters of references kept apart */
   soUnmountSOFS ();
 
   pthread_mutex_unlock (&accessCR);                                  /* exit critical region */
@@ -846,7 +1140,7 @@ static int sofs_fsync (const char *ePath, int isdatasync, struct fuse_file_info
 {
   soColorProbe(131, "07;31", "sofs_fsync_bin (\"%s\", %d, %p)\n", ePath, isdatasync, fi);
 
-  return soFsync (ePath);
+  return syncFile (ePath);
 }
 
 /**
@@ -981,7 +1275,7 @@ static int sofs_fsyncdir (const char *ePath, int isdatasync, struct fuse_file_in
 {
   soColorProbe (135, "07;31", "sofs_fsyncdir_bin (\"%s\", %d, %p)\n", ePath, isdatasync, fi);
 
-  return soFsync (ePath);
+  return syncFile (ePath);
 }
 
 /**
@@ -0,0 +1,3073 @@
+/**
+ *  \file sofs_buffercache.c (implementation file)
+ *
+ *  \brief Access to buffered/unbuffered raw disk blocks and clusters.
+ *
+ *  The buffercache may be regarded as a storage area resident in main memory having the ability to store K data blocks
+ *  of the device's storage space.
+ *  Data transfer between the main memory and the device works according to the following rules:
+ *    \li every time a data block (cluster) is required for reading, it is looked up in the storage area: if it is
+ *        there, the contents is copied to the supplied buffer location; otherwise, it is first read from the device
+ *        and stored in the buffercache (a new node in the storage area is initialized to it and its status is marked
+ *        \e same), then its contents is copied to the supplied buffer location, as before
+ *    \li every time a data block (cluster) is required for writing, it is looked up in the storage area: if it is
+ *        there, the contents of the supplied buffer is copied into it and its status is marked \e changed; otherwise,
+ *        a new node in the storage area is initialized to this data block (cluster), the contents of the supplied
+ *        buffer is copied into it and its status is marked <em>changed</em>, as before
+ *    \li because the number of nodes in the storage area is finite, whenever it happens that no more free nodes are
+ *        available, a node is selected for replacement by the replacement policy (the one that has not been accessed
+ *        for the longest time, by default; see sofs_cachepolicy.h): its contents,
+ *        if needed (the status is marked <em>changed</em>), is first transfered to the device, then it becomes
+ *        available for a new assignment.
+ *
+ *  The size of the storage area is set at run time (see soSetBufferCacheSize). The nodes, their buffers and the hash
+ *  tables are all carved from a single arena, which is mapped when the storage area is assigned to the device (backed
+ *  by huge pages, if so required) and unmapped when it is unassigned.
+ *  The storage area is split in two pools of nodes: block nodes, which store a single block and hold the superblock and
+ *  the tables of inodes and of references to free data clusters, and cluster nodes, which store a whole cluster of the
+ *  data zone, so that a cluster is looked up, replaced and written back as a unit. Each pool is replaced apart from the
+ *  other one. A block is never stored in more than one node: a block operation on a block which belongs to a cluster
+ *  stored in a cluster node is carried out on the cluster node, and the block nodes of the blocks of a cluster are
+ *  unassigned, after being flushed, when the cluster is assigned a cluster node.
+ *  The nodes of each pool are looked up through a hash table indexed by the physical (first) block number, so that the
+ *  cost of a lookup does not depend on the size of the storage area; the replacement policy keeps them in queues of its
+ *  own.
+ *  A block, or a cluster, may be pinned in the storage area, so that it is accessed in place, through a pointer to the
+ *  buffer of its node, instead of being copied in and out: a pinned node is never replaced nor unassigned, until it is
+ *  unpinned as many times as it was pinned.
+ *  The storage area is split in shards, each one with pools, hash tables, replacement queues and a lock of its own, so
+ *  that it may be accessed concurrently: the device is divided in stripes of successive blocks, which are dealt out to
+ *  the shards in turn, and an operation locks only the shards of the stripes it touches (in ascending order, so that
+ *  operations on neighbouring stripes never deadlock). Operations on blocks of different shards never contend; the
+ *  storage area must not be assigned to, or unassigned from, the device while other operations are in progress.
+ *  The storage area may also be shared with a flusher, a thread which writes changed blocks back to the device in the
+ *  background, one shard at a time.
+ *  Changed blocks that are flushed together (when the storage area is unassigned or a block or a cluster is
+ *  synchronized) are written in ascending order of physical block number, runs of successive blocks being merged into
+ *  single vectored transfers.
+ *
+ *  The following operations are defined:
+ *    \li initialize the storage area and assign it to the storage device
+ *    \li initialize the storage area, with a given replacement policy, and assign it to the storage device
+ *    \li unassign the storage area from the storage device and perform the required housekeeping duties
+ *    \li read a block of data from the buffercache
+ *    \li write a block of data to the buffercache
+ *    \li flush a block of data to the storage device
+ *    \li synchronize a block of data with the same block in the storage device
+ *    \li read a cluster of data from the buffercache
+ *    \li write a cluster of data to the buffercache
+ *    \li flush a cluster of data to the storage device
+ *    \li synchronize a cluster of data with the same cluster in the storage device
+ *    \li synchronize a sequence of blocks of data with the same blocks in the storage device
+ *    \li set the owner of the changes made by the calling thread
+ *    \li synchronize the changes of an owner with the storage device
+ *    \li read a sequence of successive clusters of data from the buffercache
+ *    \li discard a sequence of successive clusters of data, releasing their storage in the storage device
+ *    \li set the discard mode
+ *    \li get the discard mode
+ *    \li set the size of the storage area
+ *    \li set the size of the metadata partition of the storage area
+ *    \li set the supporting files the storage device is striped over
+ *    \li set whether the clusters accessed by the calling thread are references
+ *    \li pin a block of data in the buffercache
+ *    \li pin a cluster of data in the buffercache
+ *    \li mark the contents of a pinned block, or cluster, as changed
+ *    \li unpin a block, or a cluster, of data
+ *    \li start the flusher of the buffercache
+ *    \li stop the flusher of the buffercache
+ *    \li set the readahead of the buffercache
+ *    \li get the statistics of the readahead of the buffercache
+ *    \li set the regions of the device the statistics of the buffercache are split by
+ *    \li get the statistics of the buffercache
+ *    \li print the statistics of the buffercache.
+ *
+ *  \author Artur Carneiro Pereira - September 2007
+ *  \author Miguel Oliveira e Silva - September 2009
+ *  \author António Rui Borges - July 2010 / August 2011
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+
+#include "sofs_probe.h"
+#include "sofs_const.h"
+#include "sofs_rawdisk.h"
+#include "sofs_buffercache.h"
+#include "sofs_buffercachenode.h"
+#include "sofs_buffercacheinternals.h"
+#include "sofs_cachepolicy.h"
+#include "sofs_rawasync.h"
+
+/** \brief default number of blocks the storage area is able to store (K) */
+#define DEF_BUFFERCACHE  (1024)
+
+/** \brief minimum number of blocks the storage area is able to store (four cluster nodes, at least) */
+#define MIN_BUFFERCACHE  (2 * 4 * BLOCKS_PER_CLUSTER)
+
+/** \brief maximum number of blocks the storage area is able to store */
+#define MAX_BUFFERCACHE  (UINT32_C (1) << 31)
+
+/** \brief size of a huge page (in bytes), to which the arena is rounded up when it is backed by huge pages */
+#define HUGE_PAGE        (2 * 1024 * 1024)
+
+/** \brief maximum number of clusters read from the device by a single vectored transfer (a quarter of the cluster
+ *         nodes of a shard, at most) */
+#define MAX_CLUSTER_RUN  (64)
+
+/** \brief maximum number of shards of the storage area (a power of two, no greater than 64) */
+#define MAX_SHARDS       (64)
+
+/** \brief minimum number of cluster nodes of a shard, when the storage area is split in several of them */
+#define MIN_SHARDNODES   (64)
+
+/** \brief number of successive blocks of a stripe of the device, the stripes being dealt out to the shards in turn */
+#define SHARD_STRIPE     (32 * BLOCKS_PER_CLUSTER)
+
+/** \brief maximum number of changed nodes written to the device by a single vectored transfer */
+#define MAX_FLUSH_RUN    (256)
+
+/** \brief period of the flusher (in milliseconds) */
+#define FLUSH_PERIOD     (100)
+
+/** \brief number of streams of reads of successive clusters which are tracked by readahead */
+#define DIM_STREAMS      (8)
+
+
+/**
+ *  \brief Definition of a pool of nodes of the storage area, all of them storing the same number of blocks.
+ */
+
+typedef struct soNodePool
+{
+   /** \brief nodes of the pool */
+    SOBufferCacheNode *storage;
+   /** \brief buffers of the nodes, nBlks * BLOCK_SIZE bytes each, aligned so that they may be transferred by direct
+    *         I/O */
+    unsigned char *buffers;
+   /** \brief number of nodes */
+    uint32_t dim;
+   /** \brief number of blocks whose contents is stored by each node */
+    uint32_t nBlks;
+   /** \brief number of nodes which have already been assigned at least once */
+    uint32_t nAssigned;
+   /** \brief list of nodes which were released without being assigned (linked through \e h_next) */
+    SOBufferCacheNode *freeList;
+   /** \brief hash table indexed by the physical number of the (first) block */
+    SOHashTable hTable;
+   /** \brief queues of the replacement policy, for the nodes of the data partition */
+    SOCacheQueues queues;
+   /** \brief queues of the replacement policy, for the nodes of the metadata partition */
+    SOCacheQueues metaQueues;
+   /** \brief number of nodes of the metadata partition (0, if the pool is not partitioned) */
+    uint32_t metaDim;
+   /** \brief number of nodes assigned to the data partition */
+    uint32_t nData;
+   /** \brief number of nodes assigned to the metadata partition */
+    uint32_t nMeta;
+} SONodePool;
+
+/**
+ *  \brief Definition of a stream of reads of successive clusters, tracked by readahead.
+ */
+
+typedef struct soReadStream
+{
+   /** \brief physical number of the first block of the cluster which is expected to be read next */
+    uint32_t next;
+   /** \brief physical number of the first block of the cluster following those which were read ahead */
+    uint32_t ahead;
+   /** \brief readahead window (in clusters; 0, if the reads were not found successive yet) */
+    uint32_t window;
+   /** \brief time of the last read (sequence number), so that the least recently read stream is replaced */
+    uint64_t used;
+} SOReadStream;
+
+/**
+ *  \brief Definition of a shard of the storage area.
+ *
+ *  A shard stores the blocks, and the clusters starting at the blocks, of the stripes of the device dealt out to it.
+ */
+
+typedef struct soCacheShard
+{
+   /** \brief access with mutual exclusion to the shard */
+    pthread_mutex_t access;
+   /** \brief pool of block nodes, for the superblock and the tables of inodes and of references to free data clusters
+    *         (half of the blocks of the shard) */
+    SONodePool blocks;
+   /** \brief pool of cluster nodes, for the clusters of the data zone (the other half), split in a data partition
+    *         and a metadata partition, for the clusters of references */
+    SONodePool clusters;
+   /** \brief list of nodes where blocks of a sequence are stored, as collected to be flushed or updated (one element
+    *         per node of the shard) */
+    SOBufferCacheNode **collectList;
+   /** \brief number of pins which were not released yet */
+    uint32_t nPinned;
+   /** \brief number of blocks stored in nodes whose status is marked changed */
+    uint32_t nChanged;
+   /** \brief list of the nodes whose status is marked changed (linked through \e dirty_next) */
+    SOBufferCacheNode *dirtyList;
+   /** \brief the flusher is writing back changed nodes until their number of blocks falls to the low watermark */
+    bool draining;
+   /** \brief physical block number where the flusher resumes its sweep */
+    uint32_t flushCursor;
+   /** \brief number of clusters being read ahead */
+    uint32_t nAhead;
+   /** \brief statistics of the readahead which are kept by the shard (hits, wasted clusters and waits) */
+    SOCacheAheadStats aheadStats;
+   /** \brief statistics of the accesses to the shard */
+    SOCacheStats stats;
+} SOCacheShard;
+
+/*
+ *  Internal data structure
+ */
+
+/** \brief number of blocks the storage area is to be able to store, when it is next assigned to the device */
+static uint32_t nextBlks = DEF_BUFFERCACHE;
+/** \brief the arena is to be backed by huge pages, when the storage area is next assigned to the device */
+static bool nextHuge = false;
+/** \brief number of cluster nodes of the metadata partition, when the storage area is next assigned to the device */
+static uint64_t nextMeta = 0;
+/** \brief supporting files, besides the one given, the device is to be striped over, when it is next assigned to */
+static char *nextStripe[STRIPE_MAX_FILES - 1];
+/** \brief number of supporting files in nextStripe (0, if the device is not to be striped) */
+static uint32_t nextNStripes = 0;
+/** \brief stripe unit (number of clusters), when the device is next striped */
+static uint32_t nextUnit = 0;
+/** \brief number of blocks the storage area is able to store (K), while it is assigned to the device */
+static uint32_t cacheBlks = 0;
+/** \brief arena where the nodes, their buffers and the hash tables of the storage area are carved from */
+static void *arena = NULL;
+/** \brief size of the arena (in bytes) */
+static size_t arenaSize = 0;
+/** \brief shards of the storage area */
+static SOCacheShard shards[MAX_SHARDS];
+/** \brief number of shards of the storage area (a power of two), while it is assigned to the device */
+static uint32_t nShards = 0;
+/** \brief replacement policy of the storage area */
+static const SOCachePolicy *policy = NULL;
+/** \brief type of the communication channel: -1 - closed, BUF - buffered, UNBUF - unbuffered, MAPPED - mapped
+ *         (DIRECT channels are buffered and are recorded as BUF) */
+static int chType = -1;
+/** \brief number of blocks of the storage device */
+static uint32_t bnmax = 0;
+/** \brief contents of the storage device in the mapping of the supporting file (on a mapped channel) */
+static unsigned char *mapBase = NULL;
+/** \brief discard mode: the storage of the data clusters freed by the file system is released */
+static bool discard = false;
+/** \brief access with mutual exclusion to the state of the storage area: its assignment to the device, its size and
+ *         the flusher */
+static pthread_mutex_t cacheAccess = PTHREAD_MUTEX_INITIALIZER;
+/** \brief the flusher is woken up, before its period expires, to stop or to write back changed nodes */
+static pthread_cond_t flushWake = PTHREAD_COND_INITIALIZER;
+/** \brief thread of the flusher */
+static pthread_t flusher;
+/** \brief the flusher is running */
+static bool flusherOn = false;
+/** \brief the flusher was asked to stop */
+static bool flusherStop = false;
+/** \brief high watermark of the flusher: number of blocks stored in changed nodes of a shard above which they are
+ *         written back (UINT32_MAX, if the flusher is not running) */
+static uint32_t dirtyHigh = UINT32_MAX;
+/** \brief low watermark of the flusher: number of blocks stored in changed nodes of a shard down to which they are
+ *         written back */
+static uint32_t dirtyLow = 0;
+/** \brief time a node may stay changed before the flusher writes it back (in milliseconds; 0, if unlimited) */
+static uint32_t dirtyAge = 0;
+/** \brief maximum number of blocks the flusher writes per second (0, if unlimited) */
+static uint32_t flushRate = 0;
+/** \brief status of the write which made the flusher stop writing back (0, if none failed) */
+static int flushError = 0;
+/** \brief streams of reads of successive clusters */
+static SOReadStream streams[DIM_STREAMS];
+/** \brief sequence number of the last read of a stream */
+static uint64_t streamClock = 0;
+/** \brief initial readahead window (in clusters) */
+static uint32_t aheadInit = 0;
+/** \brief maximum readahead window (in clusters; 0, if readahead is off) */
+static uint32_t aheadMax = 0;
+/** \brief maximum number of clusters being read ahead simultaneously (half of the cluster nodes, at most) */
+static uint32_t maxAhead = 0;
+/** \brief the asynchronous engine was started by the buffercache for readahead */
+static bool aheadEngine = false;
+/** \brief number of clusters being read ahead */
+static uint32_t nAhead = 0;
+/** \brief statistics of the readahead which are kept apart from the shards (streams and clusters read ahead) */
+static SOCacheAheadStats aheadStats;
+/** \brief access with mutual exclusion to the readahead: the streams, the windows and the asynchronous engine */
+static pthread_mutex_t aheadAccess = PTHREAD_MUTEX_INITIALIZER;
+/** \brief statistics of the buffercache, the counters of the shards being added up when the storage area is
+ *         unassigned from the device */
+static SOCacheStats cacheStats;
+/** \brief physical number of the first block of each region of the device, indexed by CACHE_* */
+static uint32_t regionStart[CACHE_NREGIONS] = { 0, 1, 1, 1 };
+/** \brief owner of the changes made by the thread */
+static __thread uint32_t curOwner = CACHE_NO_OWNER;
+/** \brief the clusters accessed by the thread are references */
+static __thread bool curMeta = false;
+
+/** \brief shard the stripe of a physical block number is dealt out to */
+#define SHARD(n)    (&shards[((n) / SHARD_STRIPE) & (nShards - 1)])
+
+/** \brief set of all the shards (a bit per shard) */
+#define ALL_SHARDS  ((nShards == 64) ? ~UINT64_C (0) : (UINT64_C (1) << nShards) - 1)
+
+/** \brief the node is a cluster node (the cluster nodes of all the shards are carved in succession from the arena) */
+#define IS_CLUSTER_NODE(node)  (((node) >= shards[0].clusters.storage) && \
+                                ((node) < shards[0].clusters.storage + (size_t) nShards * shards[0].clusters.dim))
+
+/** \brief shard a node belongs to */
+#define SHARD_OF(node)  (IS_CLUSTER_NODE (node) \
+                         ? &shards[((node) - shards[0].clusters.storage) / shards[0].clusters.dim] \
+                         : &shards[((node) - shards[0].blocks.storage) / shards[0].blocks.dim])
+
+/** \brief counter of the statistics of a shard for the region of a physical block number */
+#define COUNT(sh, n, counter)  ((sh)->stats.region[regionOf (n)].counter += 1)
+
+/** \brief pool a node belongs to */
+#define POOL(node)  (IS_CLUSTER_NODE (node) ? &SHARD_OF (node)->clusters : &SHARD_OF (node)->blocks)
+
+/** \brief queues of a pool the node belongs to, according to its partition */
+#define QUEUES(pl, node)  ((node)->meta ? &(pl)->metaQueues : &(pl)->queues)
+
+/*
+ *  Allusion to internal functions
+ */
+
+static int mapArena (uint32_t nBlks, bool huge, uint64_t nMeta);
+static void unmapArena (void);
+static int resetQueues (const SOCachePolicy *p_pol, SONodePool *pl);
+static void releaseQueues (const SOCachePolicy *p_pol, SONodePool *pl);
+static void resetPool (SONodePool *pl);
+static int getFreeNode (SOCacheShard *sh, SONodePool *pl, SOBufferCacheNode **p_node);
+static int evictNode (SOCacheShard *sh, SONodePool *pl, bool meta, SOBufferCacheNode **p_node);
+static void unbindNode (SONodePool *pl, SOBufferCacheNode *node);
+static void putFreeNode (SONodePool *pl, SOBufferCacheNode *node);
+static void bindNode (SONodePool *pl, SOBufferCacheNode *node, uint32_t n);
+static void dropNode (SOBufferCacheNode *node);
+static void touchNode (SOBufferCacheNode *node);
+static int writeNode (SOBufferCacheNode *node);
+static SOBufferCacheNode *findBlock (uint32_t n, uint32_t *p_off);
+static int getBlockNode (uint32_t n, bool fill, SOBufferCacheNode **p_node, uint32_t *p_off);
+static int getClusterNode (uint32_t n, bool fill, SOBufferCacheNode **p_node);
+static uint32_t collectNodes (SOCacheShard *sh, uint32_t n, uint32_t nBlks, bool changed, SOBufferCacheNode **list);
+static uint32_t collectRange (uint32_t n, uint32_t nBlks, SOBufferCacheNode **list);
+static int cmpNode (const void *a, const void *b);
+static int flushNodes (uint32_t n, uint32_t nBlks);
+static int updateNodes (uint32_t n, uint32_t nBlks, const void *buf);
+static int readClusters (SOCacheShard *sh, uint32_t n, uint32_t nClust, unsigned char *p);
+static int checkBlock (uint32_t n, uint32_t nBlks);
+static int pinnedNode (const void *buf, SOBufferCacheNode **p_node);
+static int leave (int stat);
+static uint64_t shardsOf (uint32_t n, uint32_t nBlks);
+static uint64_t lockShards (uint64_t set);
+static void unlockShards (uint64_t set);
+static bool retryAhead (int stat);
+static void setChanged (SOBufferCacheNode *node);
+static void setSame (SOBufferCacheNode *node);
+static int writeRuns (SOBufferCacheNode **list, uint32_t nList);
+static void stopFlusher (void);
+static void *flushLoop (void *arg);
+static uint32_t flushStep (SOCacheShard *sh, uint32_t budget);
+static uint64_t nowMs (void);
+static void readAhead (uint32_t n, uint32_t nClust);
+static int reapAhead (bool wait);
+static void stopAhead (void);
+static uint32_t regionOf (uint32_t n);
+static void sumStats (SOCacheStats *p_stats);
+static void dumpStats (void);
+static void printStats (FILE *fs);
+
+/**
+ *  \brief Initialize the storage area and assign it to the storage device.
+ *
+ *  A communication channel is established with the storage device so that data transfers between main memory and the
+ *  storage device may be minimized.
+ *  This communication may be unbuffered or buffered: it will be unbuffered, if the second argument is \c UNBUF , mapped
+ *  into memory, if it is \c MAPPED, buffered over a device opened for direct I/O, if it is \c DIRECT, so that the
+ *  storage area is the only cache of the device's blocks, and buffered, in any other case.
+ *
+ *  \param devname absolute path to the Linux file that simulates the storage device
+ *  \param type type of the communication channel that is opened
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the argument is \c NULL
+ *  \return -\c EBUSY, if the storage area is already in use or the device is already opened
+ *  \return -\c ELIBBAD, if the supporting file size is invalid
+ *  \return -\c ENOTSUP, if the type is \c DIRECT and direct I/O of single blocks is not supported by the file system
+ *  \return -\c ENOTSUP, if the type is \c MAPPED or \c DIRECT and the device is striped (see soSetCacheStripes)
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat or \e mmap system calls
+ */
+
+int soOpenBufferCache (const char *devname, uint32_t type)
+{
+  soColorProbe (861, "07;31", "soOpenBufferCache(\"%s\", %"PRIu32")\n", devname, type);
+
+  return soOpenBufferCachePolicy (devname, type, CACHE_LRU);
+}
+
+/**
+ *  \brief Initialize the storage area, with a given replacement policy, and assign it to the storage device.
+ *
+ *  The storage area is initialized as in soOpenBufferCache, the nodes to be replaced being selected by the replacement
+ *  policy which is given: \c CACHE_LRU selects the node that has not been accessed for the longest time; \c CACHE_2Q
+ *  keeps the blocks that were accessed only once apart from the ones accessed repeatedly, so that long sequential scans
+ *  do not replace the latter.
+ *
+ *  \param devname absolute path to the Linux file that simulates the storage device
+ *  \param type type of the communication channel that is opened
+ *  \param pol replacement policy (\c CACHE_LRU or \c CACHE_2Q)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the first argument is \c NULL or the replacement policy is invalid
+ *  \return -\c EBUSY, if the storage area is already in use or the device is already opened
+ *  \return -\c ELIBBAD, if the supporting file size is invalid
+ *  \return -\c ENOTSUP, if the type is \c DIRECT and direct I/O of single blocks is not supported by the file system
+ *  \return -\c ENOTSUP, if the type is \c MAPPED or \c DIRECT and the device is striped (see soSetCacheStripes)
+ *  \return -\c ENOMEM, if there is no memory for the storage area or for the internal data structures of the
+ *                      replacement policy
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat or \e mmap system calls
+ */
+
+int soOpenBufferCachePolicy (const char *devname, uint32_t type, uint32_t pol)
+{
+  soColorProbe (875, "07;31", "soOpenBufferCachePolicy(\"%s\", %"PRIu32", %"PRIu32")\n", devname, type, pol);
+
+  const SOCachePolicy *p_pol;                    /* operations of the replacement policy */
+  void *base;                                    /* contents of the device in the mapping of the supporting file */
+  uint32_t mode;                                 /* access mode of the storage device */
+  uint32_t s;
+  int stat;                                      /* status of operation */
+
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+  if (devname == NULL) return leave (-EINVAL);   /* checking for null pointer */
+  if ((p_pol = getCachePolicy (pol)) == NULL) return leave (-EINVAL);  /* checking for valid replacement policy */
+  if (chType != -1) return leave (-EBUSY);       /* checking for storage area in use */
+
+  if (nextNStripes != 0)
+     { const char *name[STRIPE_MAX_FILES];        /* supporting files of the stripes */
+
+       if ((type == MAPPED) || (type == DIRECT)) return leave (-ENOTSUP);
+       name[0] = devname;
+       for (s = 0; s < nextNStripes; s++)
+         name[s+1] = nextStripe[s];
+       stat = soOpenStripedDevice (nextNStripes + 1, name, nextUnit, &bnmax);
+     }
+     else { mode = (type == MAPPED) ? DEV_MMAP : ((type == DIRECT) ? DEV_DIRECT : DEV_STD);
+            stat = soOpenDeviceMode (devname, mode, &bnmax);
+          }
+  if (stat != 0) return leave (stat);
+  if ((stat = mapArena (nextBlks, nextHuge, nextMeta)) != 0)
+     { soCloseDevice ();
+       return leave (stat);
+     }
+  for (s = 0; s < nShards; s++)
+    if (((stat = resetQueues (p_pol, &shards[s].blocks)) != 0) ||
+        ((stat = resetQueues (p_pol, &shards[s].clusters)) != 0))
+       { for (s = 0; s < nShards; s++)
+         { releaseQueues (p_pol, &shards[s].blocks);
+           releaseQueues (p_pol, &shards[s].clusters);
+         }
+         unmapArena ();
+         soCloseDevice ();
+         return leave (stat);
+       }
+
+  for (s = 0; s < nShards; s++)
+  { resetPool (&shards[s].blocks);
+    resetPool (&shards[s].clusters);
+  }
+  memset (&aheadStats, 0, sizeof (aheadStats));
+  memset (&cacheStats, 0, sizeof (cacheStats));
+  policy = p_pol;
+  mapBase = NULL;
+  if ((type == MAPPED) && (soMapRawBlock (0, &base) == 0))
+     mapBase = base;
+  chType = ((type == UNBUF) || (type == MAPPED)) ? type : BUF;
+
+  return leave (0);
+}
+
+/**
+ *  \brief Unassign the storage area from the storage device and perform the required housekeeping duties.
+ *
+ *  The buffered/unbuffered communication channel previously established with the storage device is closed.
+ *  This means, namely, that the contents of the storage area is flushed into the storage device to keep data
+ *  consistent.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EBUSY, if there are blocks, or clusters, still pinned
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the internal data is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soCloseBufferCache (void)
+{
+  soColorProbe (862, "07;31", "soCloseBufferCache()\n");
+
+  uint32_t pinned = 0;                           /* number of pins which were not released yet */
+  uint32_t s;
+  int stat;                                      /* status of operation */
+
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+  if (chType == -1) return leave (-EBADF);       /* checking for device closed state */
+  lockShards (ALL_SHARDS);
+  for (s = 0; s < nShards; s++)
+    pinned += shards[s].nPinned;
+  unlockShards (ALL_SHARDS);
+  if (pinned != 0) return leave (-EBUSY);        /* checking for pinned nodes */
+
+  stopFlusher ();
+  stopAhead ();
+  lockShards (ALL_SHARDS);
+  if (((stat = flushNodes (0, bnmax)) != 0) ||  /* flush the changed nodes */
+      ((stat = soCloseDevice ()) != 0))
+     { unlockShards (ALL_SHARDS);
+       return leave (stat);
+     }
+  for (s = 0; s < nShards; s++)
+  { releaseQueues (policy, &shards[s].blocks);
+    releaseQueues (policy, &shards[s].clusters);
+  }
+  unlockShards (ALL_SHARDS);
+  dumpStats ();                                  /* before the shards are folded, not to count them twice */
+  sumStats (&cacheStats);                        /* the statistics of the shards are kept */
+  unmapArena ();
+  policy = NULL;
+  chType = -1;
+  bnmax = 0;
+
+  return leave (0);
+}
+
+/**
+ *  \brief Read a block of data from the buffercache.
+ *
+ *  Both the physical number of the data block to be read and a pointer to a previously allocated buffer are supplied
+ *  as arguments.
+ *
+ *  \param n physical number of the data block to be read from
+ *  \param buf pointer to the buffer where the data must be read into
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+int soReadCacheBlock (uint32_t n, void *buf)
+{
+  soColorProbe (863, "07;31", "soReadCacheBlock(%"PRIu32", %p)\n", n, buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the block is stored */
+  uint32_t off;                                  /* offset of the block within the node */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (buf == NULL) return -EINVAL;               /* checking for null pointer */
+  if ((stat = checkBlock (n, 1)) != 0) return stat;
+  if (chType != BUF) return soReadRawBlock (n, buf);
+
+  do
+  { held = lockShards (shardsOf (n, 1));
+    if ((stat = getBlockNode (n, true, &node, &off)) == 0)
+       memcpy (buf, node->buffer + off * BLOCK_SIZE, BLOCK_SIZE);
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Write a block of data to the buffercache.
+ *
+ *  Both the physical number of the data block to be written and a pointer to a previously allocated buffer are supplied
+ *  as arguments.
+ *
+ *  \param n physical number of the block to be written into
+ *  \param buf pointer to the buffer containing the data to be written from
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soWriteCacheBlock (uint32_t n, void *buf)
+{
+  soColorProbe (864, "07;31", "soWriteCacheBlock(%"PRIu32", %p)\n", n, buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the block is stored */
+  uint32_t off;                                  /* offset of the block within the node */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (buf == NULL) return -EINVAL;               /* checking for null pointer */
+  if ((stat = checkBlock (n, 1)) != 0) return stat;
+  if (chType != BUF) return soWriteRawBlock (n, buf);
+
+  do
+  { held = lockShards (shardsOf (n, 1));
+    if ((stat = getBlockNode (n, false, &node, &off)) == 0)
+       { memcpy (node->buffer + off * BLOCK_SIZE, buf, BLOCK_SIZE);
+         setChanged (node);
+       }
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Flush a block of data to the storage device.
+ *
+ *  Both the physical number of the data block to be written and a pointer to a previously allocated buffer are supplied
+ *  as arguments.
+ *
+ *  \param n physical number of the block to be flushed
+ *  \param buf pointer to the buffer containing the data to be written from
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soFlushCacheBlock (uint32_t n, void *buf)
+{
+  soColorProbe (865, "07;31", "soFlushCacheBlock(%"PRIu32", %p)\n", n, buf);
+
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (buf == NULL) return -EINVAL;               /* checking for null pointer */
+  if ((stat = checkBlock (n, 1)) != 0) return stat;
+  if (chType != BUF) return soWriteRawBlock (n, buf);
+
+  /* the device is written with the shards locked, so that the flusher does not overwrite it with former contents */
+
+  do
+  { held = lockShards (shardsOf (n, 1));
+    if ((stat = soWriteRawBlock (n, buf)) == 0)
+       stat = updateNodes (n, 1, buf);
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Synchronize a block of data with the same block in the storage device.
+ *
+ *  The physical number of the data block to be synchronized is supplied as argument.
+ *
+ *  \param n physical number of the block to be synchronized
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soSyncCacheBlock (uint32_t n)
+{
+  soColorProbe (866, "07;31", "soSyncCacheBlock(%"PRIu32")\n", n);
+
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if ((stat = checkBlock (n, 1)) != 0) return stat;
+  if (chType == MAPPED) return soSyncRawRange (n, 1);
+  if (chType == UNBUF) return 0;
+
+  held = lockShards (shardsOf (n, 1));
+  stat = flushNodes (n, 1);
+  unlockShards (held);
+
+  return stat;
+}
+
+/**
+ *  \brief Read a cluster of data from the buffercache.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  Both the physical number of the first block of the data cluster to be read and a pointer to a previously allocated
+ *  buffer are supplied as arguments.
+ *
+ *  \param n physical number of the first block of the data cluster to be read from
+ *  \param buf pointer to the buffer where the data must be read into
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+int soReadCacheCluster (uint32_t n, void *buf)
+{
+  soColorProbe (867, "07;31", "soReadCacheCluster(%"PRIu32", %p)\n", n, buf);
+
+  return soReadCacheClusters (n, 1, buf);
+}
+
+/**
+ *  \brief Write a cluster of data to the buffercache.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  Both the physical number of the first block of the data cluster to be written and a pointer to a previously
+ *  allocated buffer are supplied as arguments.
+ *
+ *  \param n physical number of the first block of the data cluster to be written into
+ *  \param buf pointer to the buffer containing the data to be written from
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soWriteCacheCluster (uint32_t n, void *buf)
+{
+  soColorProbe (868, "07;31", "soWriteCacheCluster(%"PRIu32", %p)\n", n, buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the cluster is stored */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (buf == NULL) return -EINVAL;               /* checking for null pointer */
+  if ((stat = checkBlock (n, BLOCKS_PER_CLUSTER)) != 0) return stat;
+  if (chType != BUF) return soWriteRawCluster (n, buf);
+
+  do
+  { held = lockShards (shardsOf (n, BLOCKS_PER_CLUSTER));
+    if ((stat = getClusterNode (n, false, &node)) == 0)
+       { memcpy (node->buffer, buf, CLUSTER_SIZE);
+         setChanged (node);
+       }
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Flush a cluster of data to the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  Both the physical number of the first block of the data cluster to be flushed and a pointer to a previously
+ *  allocated buffer are supplied as arguments.
+ *
+ *  \param n physical number of the first block of the data cluster to be flushed
+ *  \param buf pointer to the buffer containing the data to be written from
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soFlushCacheCluster (uint32_t n, void *buf)
+{
+  soColorProbe (869, "07;31", "soFlushCacheCluster(%"PRIu32", %p)\n", n, buf);
+
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (buf == NULL) return -EINVAL;               /* checking for null pointer */
+  if ((stat = checkBlock (n, BLOCKS_PER_CLUSTER)) != 0) return stat;
+  if (chType != BUF) return soWriteRawCluster (n, buf);
+
+  /* the device is written with the shards locked, so that the flusher does not overwrite it with former contents */
+
+  do
+  { held = lockShards (shardsOf (n, BLOCKS_PER_CLUSTER));
+    if ((stat = soWriteRawCluster (n, buf)) == 0)
+       stat = updateNodes (n, BLOCKS_PER_CLUSTER, buf);
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Synchronize a cluster of data with the same cluster in the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the data cluster to be synchronized is supplied as argument.
+ *
+ *  \param n physical number of the first block of the data cluster to be synchronized
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+int soSyncCacheCluster (uint32_t n)
+{
+  soColorProbe (870, "07;31", "soSyncCacheCluster(%"PRIu32")\n", n);
+
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if ((stat = checkBlock (n, BLOCKS_PER_CLUSTER)) != 0) return stat;
+  if (chType == MAPPED) return soSyncRawRange (n, BLOCKS_PER_CLUSTER);
+  if (chType == UNBUF) return 0;
+
+  held = lockShards (shardsOf (n, BLOCKS_PER_CLUSTER));
+  stat = flushNodes (n, BLOCKS_PER_CLUSTER);
+  unlockShards (held);
+
+  return stat;
+}
+
+/**
+ *  \brief Synchronize a sequence of blocks of data with the same blocks in the storage device.
+ *
+ *  The changed blocks, and clusters, which overlap the sequence are written in ascending order of physical block
+ *  number, runs of successive blocks being merged into single vectored transfers; a cluster is written as a whole,
+ *  even if only some of its blocks belong to the sequence.
+ *
+ *  \param first physical number of the first block of the sequence
+ *  \param last physical number of the last block of the sequence
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>first</em> is greater than <em>last</em> or <em>last</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwrite or \e msync system calls
+ */
+
+int soSyncCacheRange (uint32_t first, uint32_t last)
+{
+  soColorProbe (847, "07;31", "soSyncCacheRange(%"PRIu32", %"PRIu32")\n", first, last);
+
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (first > last) return -EINVAL;              /* checking for empty sequence */
+  if ((stat = checkBlock (first, last - first + 1)) != 0) return stat;
+  if (chType == MAPPED) return soSyncRawRange (first, last - first + 1);
+  if (chType == UNBUF) return 0;
+
+  held = lockShards (shardsOf (first, last - first + 1));
+  stat = flushNodes (first, last - first + 1);
+  unlockShards (held);
+
+  return stat;
+}
+
+/**
+ *  \brief Set the owner of the changes made by the calling thread.
+ *
+ *  Every block, or cluster, changed afterwards by the calling thread (written or marked changed) is tagged with the
+ *  owner, usually the number of the inode the change belongs to, so that soSyncCacheOwner writes only the changes of
+ *  the owner. A block changed on behalf of several owners, or while no owner is set, is regarded as shared by all of
+ *  them and is written whichever owner is synchronized. Initially, no owner is set.
+ *
+ *  \param owner owner of the changes (\c CACHE_NO_OWNER, to set no owner)
+ *
+ *  \return the owner which was set before
+ */
+
+uint32_t soSetCacheOwner (uint32_t owner)
+{
+  soColorProbe (848, "07;31", "soSetCacheOwner(%"PRIu32")\n", owner);
+
+  uint32_t former = curOwner;                    /* owner which was set before */
+
+  curOwner = owner;
+
+  return former;
+}
+
+/**
+ *  \brief Synchronize the changes of an owner with the storage device.
+ *
+ *  The changed blocks, and clusters, tagged with the owner, or shared, are written in ascending order of physical block
+ *  number, runs of successive blocks being merged into single vectored transfers; the changes of other owners are left
+ *  in the storage area. Only the changed nodes are looked at, so that the cost does not depend on the size of the
+ *  storage area. On a mapped communication channel, the whole device is synchronized.
+ *
+ *  \param owner owner of the changes (see soSetCacheOwner)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwrite or \e msync system calls
+ */
+
+int soSyncCacheOwner (uint32_t owner)
+{
+  soColorProbe (849, "07;31", "soSyncCacheOwner(%"PRIu32")\n", owner);
+
+  SOCacheShard *sh;                              /* shard under synchronization */
+  SOBufferCacheNode *node;                       /* pointer to the node under inspection */
+  uint32_t cnt;                                  /* number of nodes collected */
+  uint32_t s;
+  int stat;                                      /* status of operation */
+
+  if (chType == -1) return -EBADF;               /* checking for device closed state */
+  if (chType == MAPPED) return soSyncRawRange (0, bnmax);
+  if (chType == UNBUF) return 0;
+
+  for (s = 0; s < nShards; s++)
+  { sh = &shards[s];
+    pthread_mutex_lock (&sh->access);
+    cnt = 0;
+    for (node = sh->dirtyList; node != NULL; node = node->dirty_next)
+      if ((node->owner == owner) || (node->owner == CACHE_NO_OWNER)) sh->collectList[cnt++] = node;
+    if (cnt > 1) qsort (sh->collectList, cnt, sizeof (SOBufferCacheNode *), cmpNode);
+    stat = writeRuns (sh->collectList, cnt);
+    pthread_mutex_unlock (&sh->access);
+    if (stat != 0) return stat;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Read a sequence of successive clusters of data from the buffercache.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the first block of the first data cluster to be read, the number of clusters and a pointer
+ *  to a previously allocated buffer, large enough to hold all of them, are supplied as arguments.
+ *
+ *  Clusters none of whose blocks are stored in the storage area are grouped in runs which are read from the device by a
+ *  single vectored transfer straight into newly assigned cluster nodes; the remaining clusters are processed one by
+ *  one. The clusters are dealt with stripe by stripe, so that only the shards of a stripe are locked at a time.
+ *
+ *  \param n physical number of the first block of the first data cluster to be read from
+ *  \param nClust number of successive clusters to be read
+ *  \param buf pointer to the buffer where the data must be read into
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL, the <em>number of clusters</em> is zero or the
+ *                      <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e preadv, \e pread or \e pwrite system calls
+ */
+
+int soReadCacheClusters (uint32_t n, uint32_t nClust, void *buf)
+{
+  soColorProbe (871, "07;31", "soReadCacheClusters(%"PRIu32", %"PRIu32", %p)\n", n, nClust, buf);
+
+  unsigned char *p = buf;                        /* current location in the buffer */
+  uint32_t first = n, total = nClust;            /* sequence of clusters to be read */
+  uint32_t chunk;                                /* number of clusters starting in the stripe of the current one */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if ((buf == NULL) || (nClust == 0)) return -EINVAL;  /* checking for null pointer and empty sequence */
+  if ((uint64_t) nClust * BLOCKS_PER_CLUSTER > UINT32_MAX) return -EINVAL;
+  if ((stat = checkBlock (n, nClust * BLOCKS_PER_CLUSTER)) != 0) return stat;
+  if (chType != BUF)
+     { struct iovec whole = { .iov_base = buf, .iov_len = (size_t) nClust * CLUSTER_SIZE };
+       return soReadRawClusters (n, nClust, &whole, 1);
+     }
+
+  while (nClust > 0)
+  { /* the clusters starting in the same stripe are read with the shards they overlap locked */
+
+    chunk = ((n / SHARD_STRIPE + 1) * SHARD_STRIPE - n + BLOCKS_PER_CLUSTER - 1) / BLOCKS_PER_CLUSTER;
+    if (chunk > nClust) chunk = nClust;
+    do
+    { held = lockShards (shardsOf (n, chunk * BLOCKS_PER_CLUSTER));
+      stat = readClusters (SHARD (n), n, chunk, p);
+      unlockShards (held);
+    } while (retryAhead (stat));
+    if (stat != 0) return stat;
+
+    n += chunk * BLOCKS_PER_CLUSTER;
+    p += (size_t) chunk * CLUSTER_SIZE;
+    nClust -= chunk;
+  }
+  readAhead (first, total);
+
+  return 0;
+}
+
+/**
+ *  \brief Discard a sequence of successive clusters of data, releasing their storage in the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The clusters are meant to hold no useful information any longer: a hole is punched in the supporting file, so that
+ *  their storage is released, and their contents is read as zeros afterwards. The blocks of the clusters which are
+ *  stored in the storage area are zeroed and the status of the nodes which store nothing else is marked \e same, so
+ *  that they are never written back.
+ *
+ *  \param n physical number of the first block of the first data cluster to be discarded
+ *  \param nClust number of successive clusters to be discarded
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>number of clusters</em> is zero or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EOPNOTSUPP, if the file system hosting the supporting file does not support punching holes
+ *  \return -<em>other specific error</em> issued by \e fallocate system call
+ */
+
+int soDiscardCacheClusters (uint32_t n, uint32_t nClust)
+{
+  soColorProbe (872, "07;31", "soDiscardCacheClusters(%"PRIu32", %"PRIu32")\n", n, nClust);
+
+  uint64_t nBlks = (uint64_t) nClust * BLOCKS_PER_CLUSTER; /* number of blocks to be discarded */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if ((nClust == 0) || (nBlks > UINT32_MAX)) return -EINVAL;  /* checking for empty sequence */
+  if ((stat = checkBlock (n, nBlks)) != 0) return stat;
+  if (chType != BUF) return soDiscardRawRange (n, nBlks);
+
+  /* the device is written with the shards locked, so that the flusher does not overwrite it with former contents */
+
+  do
+  { held = lockShards (shardsOf (n, nBlks));
+    if ((stat = soDiscardRawRange (n, nBlks)) == 0)
+       stat = updateNodes (n, nBlks, NULL);
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Set the discard mode.
+ *
+ *  In discard mode, the file system releases the storage of the data clusters it frees (see
+ *  soDiscardCacheClusters), so that the supporting file is kept sparse. The mode is not changed when the storage area
+ *  is assigned to, or unassigned from, the storage device. It is initially off.
+ *
+ *  \param on \c true, to set the discard mode on; \c false, to set it off
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ */
+
+int soSetDiscardMode (bool on)
+{
+  soColorProbe (873, "07;31", "soSetDiscardMode(%d)\n", on);
+
+  discard = on;
+
+  return 0;
+}
+
+/**
+ *  \brief Get the discard mode.
+ *
+ *  \return \c true, if the discard mode is on; \c false, otherwise
+ */
+
+bool soGetDiscardMode (void)
+{
+  soColorProbe (874, "07;31", "soGetDiscardMode()\n");
+
+  return discard;
+}
+
+/**
+ *  \brief Set the size of the storage area.
+ *
+ *  The size is given as the number of bytes of block contents the storage area is to be able to store, half of them
+ *  in block nodes and the other half in cluster nodes; the memory taken by the nodes and the hash tables comes on top
+ *  of it. All of it is carved from a single arena, mapped when the storage area is assigned to the device, which may
+ *  be backed by huge pages (explicitly reserved huge pages, if there are enough of them, or transparent huge pages,
+ *  otherwise), so that a large storage area takes neither an allocation per node nor a translation per small page.
+ *  The size takes effect the next time the storage area is assigned to the device; it is not changed when the storage
+ *  area is unassigned. It is initially 1024 blocks.
+ *
+ *  \param size size of the storage area (in bytes; it is rounded down to a whole number of blocks)
+ *  \param huge \c true, if the arena is to be backed by huge pages; \c false, otherwise
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>size</em> is too small for four cluster nodes or greater than 2^31 blocks
+ */
+
+int soSetBufferCacheSize (uint64_t size, bool huge)
+{
+  soColorProbe (860, "07;31", "soSetBufferCacheSize(%"PRIu64", %d)\n", size, huge);
+
+  if ((size / BLOCK_SIZE < MIN_BUFFERCACHE) || (size / BLOCK_SIZE > MAX_BUFFERCACHE))
+     return -EINVAL;                             /* checking for valid size */
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+
+  nextBlks = (uint32_t) (size / BLOCK_SIZE);
+  nextHuge = huge;
+
+  return leave (0);
+}
+
+/**
+ *  \brief Set the size of the metadata partition of the storage area.
+ *
+ *  The cluster nodes are split in two partitions: one for the clusters of references (see soSetCacheMetadata) and
+ *  the other for the clusters of data, so that a stream of data does not replace the references which are accessed on
+ *  nearly every operation. Each partition replaces its own nodes when it is full; the nodes of a partition which are
+ *  not assigned yet are only taken by the other one while the partition is not full, and are given back to it as
+ *  soon as it needs them. The metadata partition is carved from the storage area, whose size is not changed (the
+ *  block nodes, where the superblock and the tables of inodes and of references to free data clusters are stored, are
+ *  kept apart from the cluster nodes already).
+ *  The size takes effect the next time the storage area is assigned to the device, being cut down to half of the
+ *  cluster nodes, if it is greater; it is not changed when the storage area is unassigned. It is initially zero (a
+ *  single partition).
+ *
+ *  \param size size of the metadata partition (in bytes; it is rounded up to a whole number of clusters per shard)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ */
+
+int soSetCacheMetaSize (uint64_t size)
+{
+  soColorProbe (843, "07;31", "soSetCacheMetaSize(%"PRIu64")\n", size);
+
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+
+  nextMeta = (size + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+  return leave (0);
+}
+
+/**
+ *  \brief Set the supporting files the storage device is striped over.
+ *
+ *  The storage device is striped over the file given when the storage area is assigned to the device, followed by the
+ *  files which are set here, in stripe units of a given number of clusters (see soOpenStripedDevice); it is then
+ *  accessed in \c DEV_STD mode, the transfers to the different files being carried out in parallel. The names are
+ *  copied. The files take effect the next time the storage area is assigned to the device; they are not changed when
+ *  the storage area is unassigned. There are none initially (the device is not striped).
+ *
+ *  \param nFiles number of supporting files besides the one the storage area is assigned to (0, if the device is not
+ *                to be striped)
+ *  \param devname array of absolute paths to the Linux files that support the rest of the storage device
+ *  \param unit stripe unit (number of clusters)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>number of files</em> is greater than <tt>STRIPE_MAX_FILES - 1</tt> or, being
+ *                      non-zero, the array, or some of its paths, is \c NULL or the <em>stripe unit</em> is zero
+ *  \return -\c ENOMEM, if there is no memory to copy the names
+ */
+
+int soSetCacheStripes (uint32_t nFiles, const char *devname[], uint32_t unit)
+{
+  soColorProbe (841, "07;31", "soSetCacheStripes(%"PRIu32", %p, %"PRIu32")\n", nFiles, devname, unit);
+
+  char *name[STRIPE_MAX_FILES - 1];              /* copies of the names */
+  uint32_t n;
+
+  if (nFiles > STRIPE_MAX_FILES - 1) return -EINVAL;  /* checking for valid number of files */
+  if ((nFiles != 0) && ((devname == NULL) || (unit == 0))) return -EINVAL;
+  for (n = 0; n < nFiles; n++)
+    if (devname[n] == NULL) return -EINVAL;      /* checking for null pointer */
+  for (n = 0; n < nFiles; n++)
+    if ((name[n] = strdup (devname[n])) == NULL)
+       { while (n > 0) free (name[--n]);
+         return -ENOMEM;
+       }
+  if (pthread_mutex_lock (&cacheAccess) != 0)   /* enter critical region */
+     { for (n = 0; n < nFiles; n++) free (name[n]);
+       return -ENOLCK;
+     }
+
+  for (n = 0; n < nextNStripes; n++)
+    free (nextStripe[n]);
+  for (n = 0; n < nFiles; n++)
+    nextStripe[n] = name[n];
+  nextNStripes = nFiles;
+  nextUnit = unit;
+
+  return leave (0);
+}
+
+/**
+ *  \brief Set whether the clusters accessed by the calling thread are references.
+ *
+ *  While it is set, the clusters accessed by the thread are stored in the metadata partition of the storage area (see
+ *  soSetCacheMetaSize), a cluster already stored in the data partition being moved there (the least valuable cluster
+ *  of the metadata partition being moved to the data partition in exchange, if it is full). It is kept per thread
+ *  and is initially \c false.
+ *
+ *  \param on \c true, if the clusters are references; \c false, otherwise
+ *
+ *  \return the former setting
+ */
+
+bool soSetCacheMetadata (bool on)
+{
+  soColorProbe (842, "07;31", "soSetCacheMetadata(%d)\n", on);
+
+  bool former = curMeta;                         /* former setting */
+
+  curMeta = on;
+
+  return former;
+}
+
+/**
+ *  \brief Pin a block of data in the buffercache.
+ *
+ *  The block is stored in the storage area, as if it was read (or written, if it is not to be read from the device),
+ *  and a pointer to its contents in the buffer of the node is returned. The contents may be read, and modified, in
+ *  place until the block is unpinned (see soUnpinCache); a modification must be signalled by soMarkCacheChanged. The
+ *  node is not replaced nor unassigned while it is pinned. A block may be pinned several times, as long as it is
+ *  unpinned as many times.
+ *  Pinning is supported on a buffered communication channel and on a mapped one. On a mapped channel, the pointer
+ *  refers to the contents of the block in the mapping of the supporting file (see soMapRawBlock), which is read and
+ *  modified in place with no intermediate copy; changes reach the device when it is synchronized.
+ *
+ *  \param n physical number of the data block to be pinned
+ *  \param fill \c true, if the contents of the block must be read from the device when it is not stored in the storage
+ *              area; \c false, if it is to be wholly overwritten, its contents being undefined in that case
+ *  \param p_buf pointer to a location where the pointer to the contents of the block is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer to the location</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is unbuffered
+ *  \return -\c ENOBUFS, if all the nodes where the block might be stored are pinned
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+int soPinCacheBlock (uint32_t n, bool fill, void **p_buf)
+{
+  soColorProbe (876, "07;31", "soPinCacheBlock(%"PRIu32", %d, %p)\n", n, fill, p_buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the block is stored */
+  uint32_t off;                                  /* offset of the block within the node */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (p_buf == NULL) return -EINVAL;             /* checking for null pointer */
+  if ((stat = checkBlock (n, 1)) != 0) return stat;
+  if (chType == MAPPED) return soMapRawBlock (n, p_buf);
+  if (chType != BUF) return -ENOTSUP;
+
+  do
+  { held = lockShards (shardsOf (n, 1));
+    if ((stat = getBlockNode (n, fill, &node, &off)) == 0)
+       { node->pins += 1;
+         SHARD_OF (node)->nPinned += 1;
+         *p_buf = node->buffer + off * BLOCK_SIZE;
+       }
+    unlockShards (held);
+  } while (retryAhead (stat));
+
+  return stat;
+}
+
+/**
+ *  \brief Pin a cluster of data in the buffercache.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The cluster is stored in a cluster node and pinned, as a block is by soPinCacheBlock (on a mapped communication
+ *  channel, the pointer refers to the contents of the cluster in the mapping of the supporting file).
+ *
+ *  \param n physical number of the first block of the data cluster to be pinned
+ *  \param fill \c true, if the contents of the cluster must be read from the device when it is not stored in the
+ *              storage area; \c false, if it is to be wholly overwritten, its contents being undefined in that case
+ *  \param p_buf pointer to a location where the pointer to the contents of the cluster is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer to the location</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is unbuffered
+ *  \return -\c EBUSY, if some block of the cluster is pinned in a block node
+ *  \return -\c ENOBUFS, if all the cluster nodes are pinned
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+int soPinCacheCluster (uint32_t n, bool fill, void **p_buf)
+{
+  soColorProbe (877, "07;31", "soPinCacheCluster(%"PRIu32", %d, %p)\n", n, fill, p_buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the cluster is stored */
+  uint64_t held;                                 /* shards which are locked */
+  int stat;                                      /* status of operation */
+
+  if (p_buf == NULL) return -EINVAL;             /* checking for null pointer */
+  if ((stat = checkBlock (n, BLOCKS_PER_CLUSTER)) != 0) return stat;
+  if (chType == MAPPED) return soMapRawCluster (n, p_buf);
+  if (chType != BUF) return -ENOTSUP;
+
+  do
+  { held = lockShards (shardsOf (n, BLOCKS_PER_CLUSTER));
+    if ((stat = getClusterNode (n, fill, &node)) == 0)
+       { node->pins += 1;
+         SHARD_OF (node)->nPinned += 1;
+         *p_buf = node->buffer;
+       }
+    unlockShards (held);
+  } while (retryAhead (stat));
+  if ((stat == 0) && fill) readAhead (n, 1);
+
+  return stat;
+}
+
+/**
+ *  \brief Mark the contents of a pinned block, or cluster, as changed.
+ *
+ *  The status of the node is marked \e changed, so that its contents is written back to the device. On a mapped
+ *  communication channel, there is nothing to be done: the changes are made in the mapping of the supporting file.
+ *
+ *  \param buf pointer to the contents of the block, or cluster, as returned by soPinCacheBlock or soPinCacheCluster
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer does not point to a pinned block, or cluster
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+int soMarkCacheChanged (const void *buf)
+{
+  soColorProbe (878, "07;31", "soMarkCacheChanged(%p)\n", buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the block is stored */
+  SOCacheShard *sh;                              /* shard the node belongs to */
+  int stat;                                      /* status of operation */
+
+  if ((stat = pinnedNode (buf, &node)) != 0) return stat;
+  if (node == NULL) return 0;                    /* changed in the mapping of the supporting file */
+  sh = SHARD_OF (node);
+  if (pthread_mutex_lock (&sh->access) != 0) return -ENOLCK;   /* enter critical region of the shard */
+  if (node->pins == 0)                           /* checking for pinned node */
+     stat = -EINVAL;
+     else setChanged (node);
+  pthread_mutex_unlock (&sh->access);
+
+  return stat;
+}
+
+/**
+ *  \brief Unpin a block, or a cluster, of data.
+ *
+ *  The pointer to its contents must not be used afterwards, unless the block, or cluster, is still pinned. On a mapped
+ *  communication channel, there is nothing to be done: pins are not counted.
+ *
+ *  \param buf pointer to the contents of the block, or cluster, as returned by soPinCacheBlock or soPinCacheCluster
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer does not point to a pinned block, or cluster
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+int soUnpinCache (const void *buf)
+{
+  soColorProbe (879, "07;31", "soUnpinCache(%p)\n", buf);
+
+  SOBufferCacheNode *node;                       /* pointer to the node where the block is stored */
+  SOCacheShard *sh;                              /* shard the node belongs to */
+  int stat;                                      /* status of operation */
+
+  if ((stat = pinnedNode (buf, &node)) != 0) return stat;
+  if (node == NULL) return 0;                    /* pinned in the mapping of the supporting file */
+  sh = SHARD_OF (node);
+  if (pthread_mutex_lock (&sh->access) != 0) return -ENOLCK;   /* enter critical region of the shard */
+  if (node->pins == 0)                           /* checking for pinned node */
+     stat = -EINVAL;
+     else { node->pins -= 1;
+            sh->nPinned -= 1;
+          }
+  pthread_mutex_unlock (&sh->access);
+
+  return stat;
+}
+
+/**
+ *  \brief Start the flusher of the buffercache.
+ *
+ *  The flusher is a thread which writes the changed nodes back to the device in the background, so that a node is
+ *  seldom written when it is replaced or the storage area is unassigned. It wakes up periodically and writes, in
+ *  ascending order of physical block number, the changed nodes which have not been changed for a while and, once the
+ *  number of blocks stored in changed nodes of a shard rises above its share of a high watermark, all the changed
+ *  nodes of the shard until that number falls to half the share. Pinned nodes are passed over. The flusher is stopped
+ *  when the storage area is unassigned from the device.
+ *  The flusher is only supported on a buffered communication channel.
+ *
+ *  \param ratio high watermark, as a percentage of the number of blocks the storage area is able to store (1 to 100)
+ *  \param age time a node may stay changed before it is written back (in milliseconds; 0, if unlimited)
+ *  \param rate maximum number of blocks written per second (0, if unlimited)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>ratio</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is not buffered
+ *  \return -\c EBUSY, if the flusher is already running
+ *  \return -<em>other specific error</em> issued by \e pthread_create
+ */
+
+int soStartCacheFlusher (uint32_t ratio, uint32_t age, uint32_t rate)
+{
+  soColorProbe (880, "07;31", "soStartCacheFlusher(%"PRIu32", %"PRIu32", %"PRIu32")\n", ratio, age, rate);
+
+  uint32_t high;                                 /* high watermark of a shard */
+  int stat;                                      /* status of operation */
+
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+  if ((ratio == 0) || (ratio > 100)) return leave (-EINVAL);   /* checking for valid watermark */
+  if (chType == -1) return leave (-EBADF);       /* checking for device closed state */
+  if (chType != BUF) return leave (-ENOTSUP);
+  if (flusherOn) return leave (-EBUSY);          /* checking for flusher running */
+
+  high = (uint32_t) ((uint64_t) cacheBlks * ratio / 100 / nShards);
+  dirtyLow = high / 2;
+  dirtyAge = age;
+  flushRate = rate;
+  flusherStop = false;
+  flushError = 0;
+  if ((stat = pthread_create (&flusher, NULL, flushLoop, NULL)) != 0) return leave (-stat);
+  __atomic_store_n (&dirtyHigh, high, __ATOMIC_RELAXED);   /* the shards may cross it from now on */
+  flusherOn = true;
+
+  return leave (0);
+}
+
+/**
+ *  \brief Stop the flusher of the buffercache.
+ *
+ *  The changed nodes which were not written back yet are kept in the storage area.
+ *  If a write of the flusher failed, the flusher stopped writing back at that point, the nodes it was writing being
+ *  kept changed, and the failure is reported here.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c ESRCH, if the flusher is not running
+ *  \return -<em>specific error</em> issued by the lower level on a write of the flusher which failed
+ */
+
+int soStopCacheFlusher (void)
+{
+  soColorProbe (888, "07;31", "soStopCacheFlusher()\n");
+
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+  if (!flusherOn) return leave (-ESRCH);         /* checking for flusher running */
+
+  stopFlusher ();
+
+  return leave (__atomic_load_n (&flushError, __ATOMIC_RELAXED));
+}
+
+/**
+ *  \brief Set the readahead of the buffercache.
+ *
+ *  Successive reads of clusters (by soReadCacheClusters, soReadCacheCluster or soPinCacheCluster) are tracked as
+ *  streams. When a stream is found, the clusters which follow it are read ahead, asynchronously, into newly assigned
+ *  cluster nodes, which are pinned until the transfer is completed: the readahead window starts at \e init clusters
+ *  and is doubled on every further read of the stream, up to \e max clusters, and the clusters of the window are read
+ *  when less than half of it is left ahead of the stream. An access to a cluster which is still being read ahead waits
+ *  for the transfer.
+ *  The transfers are run by the asynchronous engine (see sofs_rawasync.h), which is started by the buffercache and is
+ *  stopped when readahead is set off or the storage area is unassigned from the device. Readahead is initially off.
+ *  Readahead is only supported on a buffered communication channel.
+ *
+ *  \param init initial readahead window (in clusters)
+ *  \param max maximum readahead window (in clusters; 0, to set readahead off)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>initial window</em> is zero or greater than the <em>maximum window</em>, or the
+ *                      <em>maximum window</em> is greater than \c MAX_READAHEAD
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is not buffered
+ *  \return -\c EBUSY, if the asynchronous engine was already started elsewhere
+ *  \return -<em>other specific error</em> issued by soOpenAsyncEngine
+ */
+
+int soSetCacheReadahead (uint32_t init, uint32_t max)
+{
+  soColorProbe (889, "07;31", "soSetCacheReadahead(%"PRIu32", %"PRIu32")\n", init, max);
+
+  int stat;                                      /* status of operation */
+
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+  if ((max != 0) && ((init == 0) || (init > max) || (max > MAX_READAHEAD)))
+     return leave (-EINVAL);                     /* checking for valid windows */
+  if (chType == -1) return leave (-EBADF);       /* checking for device closed state */
+  if (chType != BUF) return leave (-ENOTSUP);
+
+  if (max == 0)
+     { stopAhead ();
+       return leave (0);
+     }
+  pthread_mutex_lock (&aheadAccess);
+  if (!aheadEngine)
+     { if ((stat = soOpenAsyncEngine (maxAhead, ASYNC_NATIVE)) != 0)
+          { pthread_mutex_unlock (&aheadAccess);
+            return leave (stat);
+          }
+       aheadEngine = true;
+     }
+  memset (streams, 0, sizeof (streams));
+  aheadInit = (init < maxAhead) ? init : maxAhead;
+  aheadMax = (max < maxAhead) ? max : maxAhead;
+  pthread_mutex_unlock (&aheadAccess);
+
+  return leave (0);
+}
+
+/**
+ *  \brief Get the statistics of the readahead of the buffercache.
+ *
+ *  The statistics are reset when the storage area is assigned to the device.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+int soGetCacheAheadStats (SOCacheAheadStats *p_stats)
+{
+  soColorProbe (890, "07;31", "soGetCacheAheadStats(%p)\n", p_stats);
+
+  uint32_t s;
+
+  if (p_stats == NULL) return -EINVAL;           /* checking for null pointer */
+  if (pthread_mutex_lock (&aheadAccess) != 0) return -ENOLCK;  /* enter critical region */
+  *p_stats = aheadStats;
+  pthread_mutex_unlock (&aheadAccess);
+
+  for (s = 0; s < nShards; s++)
+  { pthread_mutex_lock (&shards[s].access);
+    p_stats->nHits += shards[s].aheadStats.nHits;
+    p_stats->nWasted += shards[s].aheadStats.nWasted;
+    p_stats->nWaits += shards[s].aheadStats.nWaits;
+    pthread_mutex_unlock (&shards[s].access);
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Set the regions of the device the statistics of the buffercache are split by.
+ *
+ *  The superblock is block 0 (zero); each of the other regions extends from its first block up to the first block of
+ *  the region which follows it on the device. Until the regions are set, every block but the superblock is accounted
+ *  to the data zone. The regions are kept until they are set again.
+ *
+ *  \param itable physical number of the first block of the table of inodes
+ *  \param fctable physical number of the first block of the table of references to free data clusters
+ *  \param dzone physical number of the first block of the data zone
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the regions starts at block 0 (zero)
+ */
+
+int soSetCacheRegions (uint32_t itable, uint32_t fctable, uint32_t dzone)
+{
+  soColorProbe (846, "07;31", "soSetCacheRegions(%"PRIu32", %"PRIu32", %"PRIu32")\n", itable, fctable, dzone);
+
+  if ((itable == 0) || (fctable == 0) || (dzone == 0)) return -EINVAL;  /* checking for valid regions */
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+
+  lockShards (ALL_SHARDS);                       /* the regions are looked up with a shard locked */
+  regionStart[CACHE_ITABLE] = itable;
+  regionStart[CACHE_FCTABLE] = fctable;
+  regionStart[CACHE_DZONE] = dzone;
+  unlockShards (ALL_SHARDS);
+
+  return leave (0);
+}
+
+/**
+ *  \brief Get the statistics of the buffercache.
+ *
+ *  Every access to a block, or a cluster, is a hit, if it is stored in the storage area, or a miss, otherwise; a
+ *  cluster read ahead is accounted only when it is accessed. A block, or cluster, is accounted to the region of the
+ *  device its (first) block belongs to.
+ *  The statistics are reset when the storage area is assigned to the device and are printed through the probing
+ *  system, with depth 850, when it is unassigned; they remain available until it is assigned again.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+int soGetCacheStats (SOCacheStats *p_stats)
+{
+  soColorProbe (845, "07;31", "soGetCacheStats(%p)\n", p_stats);
+
+  if (p_stats == NULL) return -EINVAL;           /* checking for null pointer */
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+
+  sumStats (p_stats);
+
+  return leave (0);
+}
+
+/**
+ *  \brief Print the statistics of the buffercache.
+ *
+ *  A line with the counters is printed for each region of the device which was accessed at least once.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the stream is \c NULL
+ */
+
+int soPrintCacheStats (FILE *fs)
+{
+  soColorProbe (844, "07;31", "soPrintCacheStats(%p)\n", fs);
+
+  if (fs == NULL) return -EINVAL;                /* checking for null pointer */
+  if (pthread_mutex_lock (&cacheAccess) != 0) return -ENOLCK;  /* enter critical region */
+
+  printStats (fs);
+
+  return leave (0);
+}
+
+/**
+ *  \brief Map the arena of the storage area and carve the shards from it.
+ *
+ *  The storage area is split in as many shards as possible, up to \c MAX_SHARDS, so that each one has
+ *  \c MIN_SHARDNODES cluster nodes, at least; if it is too small for that, it has a single shard.
+ *  The arena holds, in this order, the buffers of the block nodes, the buffers of the cluster nodes (both of them
+ *  aligned on a page boundary, so that they may be transferred by direct I/O), the nodes, the buckets of the hash
+ *  tables (as many as the nodes of each pool of a shard, rounded up to a power of two) and the lists of collected
+ *  nodes; the nodes of every kind are laid out shard after shard. If huge pages are required, the arena is rounded up
+ *  to a whole number of them and is mapped from the reserved huge pages, or, if there are not enough of them, mapped
+ *  as usual and advised to be backed by transparent huge pages.
+ *  The buffers are not touched here, so that they are only backed by memory on demand.
+ *  The cluster nodes of the metadata partition are dealt out evenly to the shards, up to half of the cluster nodes of
+ *  each one.
+ *
+ *  \param nBlks number of blocks the storage area is to be able to store
+ *  \param huge \c true, if the arena is to be backed by huge pages; \c false, otherwise
+ *  \param nMeta number of cluster nodes of the metadata partition
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c ENOMEM, if the arena could not be mapped
+ */
+
+static int mapArena (uint32_t nBlks, bool huge, uint64_t nMeta)
+{
+  uint32_t ns;                                   /* number of shards */
+  uint32_t nb, nc;                               /* number of block nodes and of cluster nodes of a shard */
+  uint32_t nm;                                   /* number of cluster nodes of the metadata partition of a shard */
+  uint32_t bb, cb;                               /* number of buckets of the hash tables of a shard */
+  size_t page = (size_t) sysconf (_SC_PAGESIZE); /* size of a page */
+  size_t offC, offN, offH, offL;                 /* offsets in the arena of its parts */
+  unsigned char *base;                           /* start of the arena */
+  SOBufferCacheNode *node;                       /* first node of a shard */
+  SOBufferCacheNode **bucket, **list;            /* first bucket and first element of the list of a shard */
+  SOCacheShard *sh;                              /* shard under initialization */
+  uint32_t s;
+
+  for (ns = 1; (2 * ns <= MAX_SHARDS) && (nBlks / 2 / BLOCKS_PER_CLUSTER / (2 * ns) >= MIN_SHARDNODES); ns <<= 1) ;
+  nb = nBlks / 2 / ns;
+  nc = nBlks / 2 / BLOCKS_PER_CLUSTER / ns;
+  nm = ((nMeta + ns - 1) / ns < nc / 2) ? (uint32_t) ((nMeta + ns - 1) / ns) : nc / 2;
+  for (bb = 1; bb < nb; bb <<= 1) ;
+  for (cb = 1; cb < nc; cb <<= 1) ;
+  offC = ((size_t) ns * nb * BLOCK_SIZE + page - 1) / page * page;
+  offN = offC + ((size_t) ns * nc * CLUSTER_SIZE + page - 1) / page * page;
+  offH = offN + (size_t) ns * (nb + nc) * sizeof (SOBufferCacheNode);
+  offL = offH + (size_t) ns * (bb + cb) * sizeof (SOBufferCacheNode *);
+  arenaSize = offL + (size_t) ns * (nb + nc) * sizeof (SOBufferCacheNode *);
+
+  base = MAP_FAILED;
+  if (huge)
+     { arenaSize = (arenaSize + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+       base = mmap (NULL, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+     }
+  if ((base == MAP_FAILED) &&
+      ((base = mmap (NULL, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))
+     { arenaSize = 0;
+       return -ENOMEM;
+     }
+  if (huge) madvise (base, arenaSize, MADV_HUGEPAGE);  /* the advice is ignored where it does not apply */
+
+  arena = base;
+  cacheBlks = nBlks;
+  nShards = ns;
+  node = (SOBufferCacheNode *) (base + offN);
+  bucket = (SOBufferCacheNode **) (base + offH);
+  list = (SOBufferCacheNode **) (base + offL);
+  for (s = 0; s < ns; s++)
+  { sh = &shards[s];
+    memset (sh, 0, sizeof (SOCacheShard));
+    pthread_mutex_init (&sh->access, NULL);
+    sh->blocks.storage = node + (size_t) s * nb;
+    sh->blocks.buffers = base + (size_t) s * nb * BLOCK_SIZE;
+    sh->blocks.dim = nb;
+    sh->blocks.nBlks = 1;
+    sh->blocks.hTable.bucket = bucket + (size_t) s * (bb + cb);
+    sh->blocks.hTable.mask = bb - 1;
+    sh->clusters.storage = node + (size_t) ns * nb + (size_t) s * nc;
+    sh->clusters.buffers = base + offC + (size_t) s * nc * CLUSTER_SIZE;
+    sh->clusters.dim = nc;
+    sh->clusters.metaDim = nm;
+    sh->clusters.nBlks = BLOCKS_PER_CLUSTER;
+    sh->clusters.hTable.bucket = sh->blocks.hTable.bucket + bb;
+    sh->clusters.hTable.mask = cb - 1;
+    sh->collectList = list + (size_t) s * (nb + nc);
+  }
+  maxAhead = (ns * (nc - nm) / 2 < ASYNC_MAX_DEPTH) ? ns * (nc - nm) / 2 : ASYNC_MAX_DEPTH;
+
+  return 0;
+}
+
+/**
+ *  \brief Unmap the arena of the storage area, the storage area having no shards any longer.
+ */
+
+static void unmapArena (void)
+{
+  uint32_t s;
+
+  for (s = 0; s < nShards; s++)
+  { pthread_mutex_destroy (&shards[s].access);
+    memset (&shards[s], 0, sizeof (SOCacheShard));
+  }
+  if (arena != NULL) munmap (arena, arenaSize);
+  arena = NULL;
+  arenaSize = 0;
+  cacheBlks = 0;
+  nShards = 0;
+  maxAhead = 0;
+}
+
+/**
+ *  \brief Empty the queues of the replacement policy of a pool, for each one of its partitions.
+ *
+ *  \param p_pol pointer to the operations of the replacement policy
+ *  \param pl pointer to the pool
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c ENOMEM, if there is no memory for the internal data structures of the replacement policy
+ */
+
+static int resetQueues (const SOCachePolicy *p_pol, SONodePool *pl)
+{
+  int stat;                                      /* status of operation */
+
+  if ((stat = p_pol->reset (&pl->queues, pl->dim - pl->metaDim)) != 0) return stat;
+  if ((pl->metaDim != 0) && ((stat = p_pol->reset (&pl->metaQueues, pl->metaDim)) != 0)) return stat;
+
+  return 0;
+}
+
+/**
+ *  \brief Release the internal data structures of the queues of the replacement policy of a pool.
+ *
+ *  \param p_pol pointer to the operations of the replacement policy
+ *  \param pl pointer to the pool
+ */
+
+static void releaseQueues (const SOCachePolicy *p_pol, SONodePool *pl)
+{
+  p_pol->release (&pl->queues);
+  p_pol->release (&pl->metaQueues);
+}
+
+/**
+ *  \brief Initialize a pool of nodes, none of them being assigned.
+ *
+ *  \param pl pointer to the pool
+ */
+
+static void resetPool (SONodePool *pl)
+{
+  uint32_t i;
+
+  for (i = 0; i < pl->dim; i++)
+  { pl->storage[i].buffer = pl->buffers + (size_t) i * pl->nBlks * BLOCK_SIZE;
+    pl->storage[i].nBlks = pl->nBlks;
+    pl->storage[i].stat = SAME;
+    pl->storage[i].pins = 0;
+    pl->storage[i].owner = CACHE_NO_OWNER;
+    pl->storage[i].dirty_prev = pl->storage[i].dirty_next = NULL;
+    pl->storage[i].meta = 0;
+  }
+  pl->nAssigned = 0;
+  pl->nData = pl->nMeta = 0;
+  pl->freeList = NULL;
+  memset (pl->hTable.bucket, 0, ((size_t) pl->hTable.mask + 1) * sizeof (SOBufferCacheNode *));
+}
+
+/**
+ *  \brief Get a node of a pool which is not assigned.
+ *
+ *  The node is got for the metadata partition of the pool, if the clusters accessed by the calling thread are
+ *  references and the pool is partitioned, or for its data partition, otherwise. If the partition is full, the node
+ *  selected by the replacement policy among its nodes is replaced; otherwise, or if all of them are pinned, a node
+ *  which is not assigned is used, a node which was released or else one which was never assigned. If there is none,
+ *  the other partition is taking up room which belongs to this one: the node selected by the replacement policy
+ *  among its nodes is replaced. The contents of a replaced node is flushed to the device, if it was changed.
+ *  The node is not inserted in the hash table nor in the queues.
+ *
+ *  \param sh pointer to the shard the pool belongs to
+ *  \param pl pointer to the pool
+ *  \param p_node pointer to a location where the pointer to the node is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EAGAIN, if all the nodes of the pool are pinned, but some of them are being read ahead
+ *  \return -\c ENOBUFS, if all the nodes of the pool are pinned
+ *  \return -<em>other specific error</em> issued by the lower level on writing
+ */
+
+static int getFreeNode (SOCacheShard *sh, SONodePool *pl, SOBufferCacheNode **p_node)
+{
+  SOBufferCacheNode *node = NULL;                /* pointer to the node */
+  bool meta = curMeta && (pl->metaDim != 0);     /* the node is got for the metadata partition */
+  bool full;                                     /* the partition is full */
+  int stat;                                      /* status of operation */
+
+  full = meta ? (pl->nMeta >= pl->metaDim) : (pl->nData >= pl->dim - pl->metaDim);
+  if (full && ((stat = evictNode (sh, pl, meta, &node)) != 0)) return stat;
+  if (node != NULL) ;                            /* a node of the partition was replaced */
+  else if (pl->freeList != NULL)                 /* a released node is available */
+     { node = pl->freeList;
+       pl->freeList = node->h_next;
+     }
+  else if (pl->nAssigned < pl->dim)              /* a node which was never assigned is available */
+     node = &pl->storage[pl->nAssigned++];
+  else { /* a node of the other partition is replaced or, if all of them are pinned, one of this partition */
+
+         if ((stat = evictNode (sh, pl, !meta, &node)) != 0) return stat;
+         if ((node == NULL) && !full && ((stat = evictNode (sh, pl, meta, &node)) != 0)) return stat;
+         if (node == NULL)
+            return ((pl == &sh->clusters) && (sh->nAhead != 0)) ? -EAGAIN : -ENOBUFS;
+       }
+  setSame (node);
+  node->ahead = 0;
+  node->meta = meta;
+  node->h_prev = node->h_next = node->access_prev = node->access_next = NULL;
+  *p_node = node;
+
+  return 0;
+}
+
+/**
+ *  \brief Replace the node selected by the replacement policy among the nodes of a partition of a pool.
+ *
+ *  The node is retrieved from the pool and, if its contents was changed, flushed to the device.
+ *
+ *  \param sh pointer to the shard the pool belongs to
+ *  \param pl pointer to the pool
+ *  \param meta \c true, if the node is selected in the metadata partition; \c false, in the data partition
+ *  \param p_node pointer to a location where the pointer to the node is to be stored (\c NULL, if all the nodes of
+ *                the partition are pinned)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the lower level on writing
+ */
+
+static int evictNode (SOCacheShard *sh, SONodePool *pl, bool meta, SOBufferCacheNode **p_node)
+{
+  SOBufferCacheNode *node;                       /* pointer to the node */
+  int stat;                                      /* status of operation */
+
+  *p_node = NULL;
+  if ((node = policy->victim (meta ? &pl->metaQueues : &pl->queues)) == NULL) return 0;
+  if (node->ahead) sh->aheadStats.nWasted += 1;
+  removeNode (node, &pl->hTable);
+  if ((node->stat == CHANGED) && ((stat = writeNode (node)) != 0))
+     { insertNode (node, &pl->hTable);           /* keep the contents in the storage area */
+       policy->insert (QUEUES (pl, node), node);
+       return stat;
+     }
+  if (node->meta)
+     pl->nMeta -= 1;
+     else pl->nData -= 1;
+  COUNT (sh, node->n, nEvictions);
+  *p_node = node;
+
+  return 0;
+}
+
+/**
+ *  \brief Release a node which was obtained by getFreeNode but could not be assigned.
+ *
+ *  \param pl pointer to the pool
+ *  \param node pointer to the node
+ */
+
+static void putFreeNode (SONodePool *pl, SOBufferCacheNode *node)
+{
+  node->h_next = pl->freeList;
+  pl->freeList = node;
+}
+
+/**
+ *  \brief Assign a node, obtained by getFreeNode, to the block, or cluster, starting at a given physical block number.
+ *
+ *  The node is inserted in the hash table and in the queues of the pool.
+ *
+ *  \param pl pointer to the pool
+ *  \param node pointer to the node
+ *  \param n physical number of the (first) block
+ */
+
+static void bindNode (SONodePool *pl, SOBufferCacheNode *node, uint32_t n)
+{
+  node->n = n;
+  insertNode (node, &pl->hTable);
+  policy->insert (QUEUES (pl, node), node);
+  if (node->meta)
+     pl->nMeta += 1;
+     else pl->nData += 1;
+}
+
+/**
+ *  \brief Unassign a node from its block, or cluster, removing it from the hash table and from the queues of the pool.
+ *
+ *  \param pl pointer to the pool
+ *  \param node pointer to the node
+ */
+
+static void unbindNode (SONodePool *pl, SOBufferCacheNode *node)
+{
+  removeNode (node, &pl->hTable);
+  policy->remove (QUEUES (pl, node), node);
+  if (node->meta)
+     pl->nMeta -= 1;
+     else pl->nData -= 1;
+}
+
+/**
+ *  \brief Unassign a node, whose contents is supposed to be stored in the device, returning it to its pool.
+ *
+ *  \param node pointer to the node
+ */
+
+static void dropNode (SOBufferCacheNode *node)
+{
+  SONodePool *pl = POOL (node);                  /* pool the node belongs to */
+
+  unbindNode (pl, node);
+  putFreeNode (pl, node);
+}
+
+/**
+ *  \brief Tell the replacement policy about an access to the block, or cluster, stored in a node.
+ *
+ *  The first access to a cluster read ahead is not told, since the node was inserted in the queues when the transfer
+ *  was submitted.
+ *  A node of the data partition accessed as a reference is moved to the metadata partition, in exchange for the node
+ *  selected by the replacement policy among the nodes of the metadata partition, if it is full.
+ *
+ *  \param node pointer to the node
+ */
+
+static void touchNode (SOBufferCacheNode *node)
+{
+  SONodePool *pl = POOL (node);                  /* pool the node belongs to */
+  SOBufferCacheNode *other;                      /* node moved to the data partition in exchange */
+
+  if (curMeta && (pl->metaDim != 0) && !node->meta)     /* a reference stored in the data partition */
+     { if (node->ahead)
+          { node->ahead = 0;
+            SHARD_OF (node)->aheadStats.nHits += 1;
+          }
+       if ((pl->nMeta >= pl->metaDim) && ((other = policy->victim (&pl->metaQueues)) != NULL))
+          { other->meta = 0;
+            policy->insert (&pl->queues, other);
+            pl->nMeta -= 1;
+            pl->nData += 1;
+          }
+       policy->remove (&pl->queues, node);
+       node->meta = 1;
+       policy->insert (&pl->metaQueues, node);
+       pl->nData -= 1;
+       pl->nMeta += 1;
+     }
+  else if (node->ahead)                          /* first access to a cluster read ahead: it was inserted for it */
+     { node->ahead = 0;
+       SHARD_OF (node)->aheadStats.nHits += 1;
+     }
+     else policy->touch (QUEUES (pl, node), node);
+}
+
+/**
+ *  \brief Write the contents of a node to the device.
+ *
+ *  \param node pointer to the node
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the lower level on writing
+ */
+
+static int writeNode (SOBufferCacheNode *node)
+{
+  int stat;                                      /* status of operation */
+
+  if (node->nBlks == 1)
+     stat = soWriteRawBlock (node->n, node->buffer);
+     else stat = soWriteRawCluster (node->n, node->buffer);
+  if (stat == 0) COUNT (SHARD_OF (node), node->n, nWritebacks);
+
+  return stat;
+}
+
+/**
+ *  \brief Find the node where a block is stored.
+ *
+ *  The block is looked up among the block nodes and, if it is not there, among the cluster nodes whose cluster may
+ *  contain it.
+ *
+ *  \param n physical number of the block
+ *  \param p_off pointer to a location where the offset of the block within the node (in blocks) is to be stored
+ *
+ *  \return pointer to the node, or \c NULL if the block is not stored in the storage area
+ */
+
+static SOBufferCacheNode *findBlock (uint32_t n, uint32_t *p_off)
+{
+  SOBufferCacheNode *node;                       /* pointer to the node */
+  uint32_t i;
+
+  *p_off = 0;
+  if ((node = searchNode (n, &SHARD (n)->blocks.hTable)) != NULL) return node;
+  for (i = 0; (i < BLOCKS_PER_CLUSTER) && (i <= n); i++)
+    if ((node = searchNode (n - i, &SHARD (n - i)->clusters.hTable)) != NULL)
+       { *p_off = i;
+         return node;
+       }
+
+  return NULL;
+}
+
+/**
+ *  \brief Get the node where a block is stored, assigning a new block node if the block is not present.
+ *
+ *  The replacement policy is told about the access to the node (or about its insertion).
+ *  The shards of the stripes the block, and the clusters which may contain it, belong to must be locked.
+ *
+ *  \param n physical number of the block
+ *  \param fill \c true, if the contents of a newly assigned node must be read from the device
+ *  \param p_node pointer to a location where the pointer to the node is to be stored
+ *  \param p_off pointer to a location where the offset of the block within the node (in blocks) is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EAGAIN, if the block belongs to a cluster which is being read ahead
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by the lower level on reading or writing
+ */
+
+static int getBlockNode (uint32_t n, bool fill, SOBufferCacheNode **p_node, uint32_t *p_off)
+{
+  SOCacheShard *sh = SHARD (n);                  /* shard the block belongs to */
+  SOBufferCacheNode *node;                       /* pointer to the node */
+  int stat;                                      /* status of operation */
+
+  if ((node = findBlock (n, p_off)) != NULL)
+     { if (node->stat == PENDING)                /* the cluster is being read ahead */
+          { SHARD_OF (node)->aheadStats.nWaits += 1;
+            return -EAGAIN;
+          }
+       touchNode (node);
+       COUNT (sh, n, nHits);
+       *p_node = node;
+       return 0;
+     }
+
+  if ((stat = getFreeNode (sh, &sh->blocks, &node)) != 0) return stat;
+  if (fill && ((stat = soReadRawBlock (n, node->buffer)) != 0))
+     { putFreeNode (&sh->blocks, node);
+       return stat;
+     }
+  bindNode (&sh->blocks, node, n);
+  COUNT (sh, n, nMisses);
+  *p_node = node;
+
+  return 0;
+}
+
+/**
+ *  \brief Get the node where a cluster is stored, assigning a new cluster node if the cluster is not present.
+ *
+ *  Before a new cluster node is assigned, the nodes where any of the blocks of the cluster happen to be stored are
+ *  flushed, if their contents was changed, and unassigned, so that a block is never stored in more than one node.
+ *  The replacement policy is told about the access to the node (or about its insertion).
+ *  The shards of the stripes the blocks of the cluster, and the clusters which may overlap it, belong to must be
+ *  locked.
+ *
+ *  \param n physical number of the first block of the cluster
+ *  \param fill \c true, if the contents of a newly assigned node must be read from the device
+ *  \param p_node pointer to a location where the pointer to the node is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EAGAIN, if the cluster, or a cluster which overlaps it, is being read ahead
+ *  \return -\c EBUSY, if some of the nodes to be unassigned is pinned
+ *  \return -\c ENOBUFS, if all the cluster nodes are pinned
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by the lower level on reading or writing
+ */
+
+static int getClusterNode (uint32_t n, bool fill, SOBufferCacheNode **p_node)
+{
+  SOCacheShard *sh = SHARD (n);                  /* shard the cluster belongs to */
+  SOBufferCacheNode *list[BLOCKS_PER_CLUSTER];   /* nodes where blocks of the cluster are stored */
+  SOBufferCacheNode *node;                       /* pointer to the node */
+  uint32_t cnt, i;
+  int stat;                                      /* status of operation */
+
+  if ((node = searchNode (n, &sh->clusters.hTable)) != NULL)
+     { if (node->stat == PENDING)                /* the cluster is being read ahead */
+          { sh->aheadStats.nWaits += 1;
+            return -EAGAIN;
+          }
+       touchNode (node);
+       COUNT (sh, n, nHits);
+       *p_node = node;
+       return 0;
+     }
+
+  cnt = collectRange (n, BLOCKS_PER_CLUSTER, list);
+  for (i = 0; i < cnt; i++)
+    if (list[i]->stat == PENDING) return -EAGAIN;  /* an overlapping cluster is being read ahead */
+  for (i = 0; i < cnt; i++)
+    if (list[i]->pins != 0) return -EBUSY;
+  for (i = 0; i < cnt; i++)
+  { if ((list[i]->stat == CHANGED) && ((stat = writeNode (list[i])) != 0)) return stat;
+    setSame (list[i]);
+    dropNode (list[i]);
+  }
+
+  if ((stat = getFreeNode (sh, &sh->clusters, &node)) != 0) return stat;
+  if (fill && ((stat = soReadRawCluster (n, node->buffer)) != 0))
+     { putFreeNode (&sh->clusters, node);
+       return stat;
+     }
+  bindNode (&sh->clusters, node, n);
+  COUNT (sh, n, nMisses);
+  *p_node = node;
+
+  return 0;
+}
+
+/**
+ *  \brief Collect the nodes of a shard where blocks of a sequence are stored, in ascending order of physical block
+ *         number.
+ *
+ *  A short sequence is looked up block by block in the hash tables; otherwise, the whole shard is traversed.
+ *  Since a block is never stored in more than one node, there are never more nodes than blocks in the sequence.
+ *
+ *  \param sh pointer to the shard
+ *  \param n physical number of the first block of the sequence
+ *  \param nBlks number of blocks of the sequence
+ *  \param changed \c true, if only the nodes whose contents was changed are to be collected
+ *  \param list pointer to an array, of \c nBlks elements or as many elements as there are nodes in the shard,
+ *              whichever is less, where the pointers to the nodes are to be stored
+ *
+ *  \return number of nodes which were collected
+ */
+
+static uint32_t collectNodes (SOCacheShard *sh, uint32_t n, uint32_t nBlks, bool changed, SOBufferCacheNode **list)
+{
+  SOBufferCacheNode *node;                       /* pointer to the node under inspection */
+  uint64_t end = (uint64_t) n + nBlks;           /* physical number of the block following the sequence */
+  uint64_t m;                                    /* physical number of the block under inspection */
+  uint32_t cnt = 0;                              /* number of nodes collected */
+
+  if (nBlks <= cacheBlks)
+     { for (m = n; m < end; m++)
+         if ((SHARD (m) == sh) && ((node = searchNode (m, &sh->blocks.hTable)) != NULL) &&
+             (!changed || (node->stat == CHANGED)))
+            list[cnt++] = node;
+       for (m = (n >= BLOCKS_PER_CLUSTER - 1) ? n - (BLOCKS_PER_CLUSTER - 1) : 0; m < end; m++)
+         if ((SHARD (m) == sh) && ((node = searchNode (m, &sh->clusters.hTable)) != NULL) &&
+             (!changed || (node->stat == CHANGED)))
+            list[cnt++] = node;
+     }
+     else { for (node = getFirstNode (&sh->blocks.hTable); node != NULL; node = getNextNode (&sh->blocks.hTable))
+              if ((node->n >= n) && (node->n < end) && (!changed || (node->stat == CHANGED)))
+                 list[cnt++] = node;
+            for (node = getFirstNode (&sh->clusters.hTable); node != NULL; node = getNextNode (&sh->clusters.hTable))
+              if ((node->n < end) && (node->n + node->nBlks > n) && (!changed || (node->stat == CHANGED)))
+                 list[cnt++] = node;
+          }
+  if (cnt > 1) qsort (list, cnt, sizeof (SOBufferCacheNode *), cmpNode);
+
+  return cnt;
+}
+
+/**
+ *  \brief Collect the nodes of all the shards where blocks of a short sequence are stored.
+ *
+ *  The nodes are in ascending order of physical block number within each shard, the shards being taken in ascending
+ *  order.
+ *
+ *  \param n physical number of the first block of the sequence
+ *  \param nBlks number of blocks of the sequence
+ *  \param list pointer to an array, of \c nBlks elements, where the pointers to the nodes are to be stored
+ *
+ *  \return number of nodes which were collected
+ */
+
+static uint32_t collectRange (uint32_t n, uint32_t nBlks, SOBufferCacheNode **list)
+{
+  uint64_t set = shardsOf (n, nBlks);            /* shards the sequence may be stored in */
+  uint32_t cnt = 0;                              /* number of nodes collected */
+  uint32_t s;
+
+  for (s = 0; s < nShards; s++)
+    if (set & (UINT64_C (1) << s)) cnt += collectNodes (&shards[s], n, nBlks, false, list + cnt);
+
+  return cnt;
+}
+
+/**
+ *  \brief Compare two nodes by the physical block number (qsort).
+ */
+
+static int cmpNode (const void *a, const void *b)
+{
+  uint32_t na = (*(SOBufferCacheNode * const *) a)->n,
+           nb = (*(SOBufferCacheNode * const *) b)->n;
+
+  return (na > nb) - (na < nb);
+}
+
+/**
+ *  \brief Flush the changed nodes where blocks of a sequence are stored to the device.
+ *
+ *  A cluster node is flushed as a whole, even if only some of its blocks belong to the sequence. The shards the
+ *  sequence may be stored in must be locked; they are flushed one after the other.
+ *
+ *  \param n physical number of the first block of the sequence
+ *  \param nBlks number of blocks of the sequence
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the lower level on writing
+ */
+
+static int flushNodes (uint32_t n, uint32_t nBlks)
+{
+  uint64_t set = shardsOf (n, nBlks);            /* shards the sequence may be stored in */
+  uint32_t nList;                                /* number of changed nodes of a shard */
+  uint32_t s;
+  int stat;                                      /* status of operation */
+
+  for (s = 0; s < nShards; s++)
+    if (set & (UINT64_C (1) << s))
+       { nList = collectNodes (&shards[s], n, nBlks, true, shards[s].collectList);
+         if ((stat = writeRuns (shards[s].collectList, nList)) != 0) return stat;
+       }
+
+  return 0;
+}
+
+/**
+ *  \brief Write a list of changed nodes to the device.
+ *
+ *  The nodes are taken in ascending order of physical block number: those of successive blocks, or clusters, are
+ *  gathered in runs, each one written by a single vectored transfer, and their status is marked \e same.
+ *
+ *  \param list pointer to an array of pointers to the nodes, in ascending order of physical block number
+ *  \param nList number of nodes
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the lower level on writing
+ */
+
+static int writeRuns (SOBufferCacheNode **list, uint32_t nList)
+{
+  struct iovec iov[MAX_FLUSH_RUN];               /* gather list pointing to the buffers of the current run */
+  uint32_t first = 0;                            /* index in the list of the first node of the current run */
+  uint32_t cnt = 0;                              /* number of nodes of the current run */
+  uint32_t nb = 0;                               /* number of blocks of the current run */
+  uint32_t i, j;
+  int stat;                                      /* status of operation */
+
+  for (i = 0; i <= nList; i++)
+  { /* the current run ends if the node does not follow it */
+
+    if ((cnt > 0) &&
+        ((i == nList) || (list[i]->n != list[i-1]->n + list[i-1]->nBlks) || (cnt == MAX_FLUSH_RUN)))
+       { if ((stat = soWriteRawBlocks (list[first]->n, nb, iov, cnt)) != 0) return stat;
+         for (j = first; j < i; j++)
+         { setSame (list[j]);
+           COUNT (SHARD_OF (list[j]), list[j]->n, nWritebacks);
+         }
+         cnt = nb = 0;
+       }
+    if (i == nList) break;
+
+    if (cnt == 0) first = i;
+    iov[cnt].iov_base = list[i]->buffer;
+    iov[cnt].iov_len = (size_t) list[i]->nBlks * BLOCK_SIZE;
+    nb += list[i]->nBlks;
+    cnt += 1;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Update the nodes where blocks of a sequence are stored after the sequence was written to the device.
+ *
+ *  The part of the contents of each node which belongs to the sequence is replaced by the data that was written and
+ *  the node is touched; if the contents of the node belongs wholly to the sequence, its status is marked \e same.
+ *  If no data is supplied, the sequence is supposed to be read as zeros.
+ *  The shards the sequence may be stored in must be locked; they are updated one after the other, a shard where a
+ *  cluster of the sequence is being read ahead not being updated at all, so that its contents is not overwritten
+ *  afterwards (the update is to be repeated once the transfer is completed).
+ *
+ *  \param n physical number of the first block of the sequence
+ *  \param nBlks number of blocks of the sequence
+ *  \param buf pointer to the buffer containing the data that was written, or \c NULL for zeros
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EAGAIN, if a cluster of the sequence is being read ahead
+ */
+
+static int updateNodes (uint32_t n, uint32_t nBlks, const void *buf)
+{
+  uint64_t set = shardsOf (n, nBlks);            /* shards the sequence may be stored in */
+  SOBufferCacheNode **list;                      /* nodes of a shard where blocks of the sequence are stored */
+  SOBufferCacheNode *node;                       /* pointer to the node under processing */
+  uint64_t end = (uint64_t) n + nBlks;           /* physical number of the block following the sequence */
+  uint64_t from, to;                             /* blocks of the node which belong to the sequence */
+  uint32_t cnt, i, s;
+
+  for (s = 0; s < nShards; s++)
+  { if (!(set & (UINT64_C (1) << s))) continue;
+    list = shards[s].collectList;
+    cnt = collectNodes (&shards[s], n, nBlks, false, list);
+    for (i = 0; i < cnt; i++)
+      if (list[i]->stat == PENDING) return -EAGAIN;   /* a cluster is being read ahead */
+    for (i = 0; i < cnt; i++)
+    { node = list[i];
+      from = (node->n > n) ? node->n : n;
+      to = ((uint64_t) node->n + node->nBlks < end) ? (uint64_t) node->n + node->nBlks : end;
+      if (buf != NULL)
+         { memcpy (node->buffer + (from - node->n) * BLOCK_SIZE, (const unsigned char *) buf + (from - n) * BLOCK_SIZE,
+                   (to - from) * BLOCK_SIZE);
+           touchNode (node);
+         }
+         else memset (node->buffer + (from - node->n) * BLOCK_SIZE, 0, (to - from) * BLOCK_SIZE);
+      if ((from == node->n) && (to == (uint64_t) node->n + node->nBlks)) setSame (node);
+    }
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Read a sequence of successive clusters, starting in the same stripe, through the storage area.
+ *
+ *  The runs of clusters which are not stored at all in the storage area are assigned new cluster nodes and are read
+ *  from the device by single vectored transfers; the other clusters are got one by one.
+ *  The shards of the stripes the sequence, and the clusters which may overlap it, belong to must be locked.
+ *
+ *  \param sh pointer to the shard the clusters belong to
+ *  \param n physical number of the first block of the first cluster
+ *  \param nClust number of clusters of the sequence
+ *  \param p pointer to the buffer where the data must be read into
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EAGAIN, if a cluster is being read ahead
+ *  \return -\c EBUSY, if some of the nodes to be unassigned is pinned
+ *  \return -\c ENOBUFS, if all the cluster nodes are pinned
+ *  \return -<em>other specific error</em> issued by the lower level on reading or writing
+ */
+
+static int readClusters (SOCacheShard *sh, uint32_t n, uint32_t nClust, unsigned char *p)
+{
+  SOBufferCacheNode *node[MAX_CLUSTER_RUN];      /* nodes assigned to a run of missing clusters */
+  SOBufferCacheNode *list[BLOCKS_PER_CLUSTER];   /* nodes where the blocks of a cluster are stored */
+  struct iovec iov[MAX_CLUSTER_RUN];             /* scatter list pointing to their buffers */
+  uint32_t run, maxRun;                          /* number of clusters of the current run and of the longest one */
+  uint32_t i;
+  int stat;                                      /* status of operation */
+
+  maxRun = (sh->clusters.dim / 4 < MAX_CLUSTER_RUN) ? sh->clusters.dim / 4 : MAX_CLUSTER_RUN;
+  while (nClust > 0)
+  { /* find out the run of clusters, starting at the current one, that are not stored at all in the storage area */
+
+    for (run = 0; (run < nClust) && (run < maxRun); run++)
+      if (collectRange (n + run * BLOCKS_PER_CLUSTER, BLOCKS_PER_CLUSTER, list) != 0) break;
+
+    if (run == 0)
+       { /* the current cluster is, at least partially, present: get its node */
+
+         if ((stat = getClusterNode (n, true, &node[0])) != 0) return stat;
+         memcpy (p, node[0]->buffer, CLUSTER_SIZE);
+         run = 1;
+       }
+       else { /* assign nodes to the whole run and read it from the device in a single transfer */
+
+              for (i = 0; i < run; i++)
+              { if ((stat = getFreeNode (sh, &sh->clusters, &node[i])) != 0)
+                   { while (i > 0)
+                       putFreeNode (&sh->clusters, node[--i]);
+                     return stat;
+                   }
+                iov[i].iov_base = node[i]->buffer;
+                iov[i].iov_len = CLUSTER_SIZE;
+              }
+              if ((stat = soReadRawClusters (n, run, iov, run)) != 0)
+                 { for (i = 0; i < run; i++)
+                     putFreeNode (&sh->clusters, node[i]);
+                   return stat;
+                 }
+              for (i = 0; i < run; i++)
+              { bindNode (&sh->clusters, node[i], n + i * BLOCKS_PER_CLUSTER);
+                COUNT (sh, node[i]->n, nMisses);
+                memcpy (p + i * CLUSTER_SIZE, node[i]->buffer, CLUSTER_SIZE);
+              }
+            }
+
+    n += run * BLOCKS_PER_CLUSTER;
+    p += (size_t) run * CLUSTER_SIZE;
+    nClust -= run;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Check the state of the storage area and the range of a sequence of blocks.
+ *
+ *  \param n physical number of the first block
+ *  \param nBlks number of blocks of the sequence
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+static int checkBlock (uint32_t n, uint32_t nBlks)
+{
+  if (chType == -1) return -EBADF;               /* checking for device closed state */
+  if (((uint64_t) n + nBlks) > bnmax) return -EINVAL;    /* checking for block number */
+
+  return 0;
+}
+
+/**
+ *  \brief Get the node whose buffer contains a given location.
+ *
+ *  The buffers of the nodes of every kind are carved in succession from the arena, shard after shard. Whether the node
+ *  is pinned is to be checked by the caller, with the shard of the node locked. On a mapped communication channel, the
+ *  location must belong to the mapping of the supporting file instead and \c NULL is stored.
+ *
+ *  \param buf pointer to the location
+ *  \param p_node pointer to a location where the pointer to the node is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the location does not belong to the buffer of a node
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+static int pinnedNode (const void *buf, SOBufferCacheNode **p_node)
+{
+  const unsigned char *p = buf;                  /* location */
+  SONodePool *bl = &shards[0].blocks,            /* first pools of block nodes and of cluster nodes */
+             *cl = &shards[0].clusters;
+
+  if (chType == -1) return -EBADF;               /* checking for device closed state */
+  if (chType == MAPPED)                          /* the contents are pinned in the mapping of the supporting file */
+     { *p_node = NULL;
+       return ((mapBase != NULL) && (p >= mapBase) && (p < mapBase + (size_t) bnmax * BLOCK_SIZE)) ? 0 : -EINVAL;
+     }
+  if ((p >= bl->buffers) && (p < bl->buffers + (size_t) nShards * bl->dim * BLOCK_SIZE))
+     *p_node = &bl->storage[(p - bl->buffers) / BLOCK_SIZE];
+  else if ((p >= cl->buffers) && (p < cl->buffers + (size_t) nShards * cl->dim * CLUSTER_SIZE))
+     *p_node = &cl->storage[(p - cl->buffers) / CLUSTER_SIZE];
+  else return -EINVAL;
+
+  return 0;
+}
+
+/**
+ *  \brief Exit the critical region of the storage area.
+ *
+ *  \param stat status of operation
+ *
+ *  \return the status of operation
+ */
+
+static int leave (int stat)
+{
+  pthread_mutex_unlock (&cacheAccess);
+
+  return stat;
+}
+
+/**
+ *  \brief Get the shards where blocks of a sequence, and the clusters which may overlap it, are stored.
+ *
+ *  \param n physical number of the first block of the sequence
+ *  \param nBlks number of blocks of the sequence
+ *
+ *  \return set of shards (a bit per shard)
+ */
+
+static uint64_t shardsOf (uint32_t n, uint32_t nBlks)
+{
+  uint64_t first = ((n >= BLOCKS_PER_CLUSTER - 1) ? n - (BLOCKS_PER_CLUSTER - 1) : 0) / SHARD_STRIPE,
+           last = ((uint64_t) n + nBlks - 1) / SHARD_STRIPE;     /* first and last stripes */
+  uint64_t set = 0;                              /* set of shards */
+  uint64_t i;
+
+  if (last - first + 1 >= nShards) return ALL_SHARDS;
+  for (i = first; i <= last; i++)
+    set |= UINT64_C (1) << (i & (nShards - 1));
+
+  return set;
+}
+
+/**
+ *  \brief Lock a set of shards, in ascending order.
+ *
+ *  \param set set of shards (a bit per shard)
+ *
+ *  \return the set of shards
+ */
+
+static uint64_t lockShards (uint64_t set)
+{
+  uint32_t s;
+
+  for (s = 0; s < nShards; s++)
+    if (set & (UINT64_C (1) << s)) pthread_mutex_lock (&shards[s].access);
+
+  return set;
+}
+
+/**
+ *  \brief Unlock a set of shards.
+ *
+ *  \param set set of shards (a bit per shard)
+ */
+
+static void unlockShards (uint64_t set)
+{
+  uint32_t s;
+
+  for (s = 0; s < nShards; s++)
+    if (set & (UINT64_C (1) << s)) pthread_mutex_unlock (&shards[s].access);
+}
+
+/**
+ *  \brief Wait for a cluster being read ahead, if an operation was kept from going on by it.
+ *
+ *  It must be called with no shard locked. A completion is collected, or, if it was already collected by another
+ *  thread, the processor is yielded, so that the operation may be tried again.
+ *
+ *  \param stat status of the operation
+ *
+ *  \return \c true, if the operation is to be tried again; \c false, otherwise
+ */
+
+static bool retryAhead (int stat)
+{
+  if (stat != -EAGAIN) return false;
+
+  if (reapAhead (true) != 0) sched_yield ();     /* the completion is being collected by another thread */
+
+  return true;
+}
+
+/**
+ *  \brief Mark the status of a node as changed.
+ *
+ *  The node is tagged with the owner of the changes made by the calling thread, or as shared, if it was already changed
+ *  on behalf of another owner, and is inserted in the list of changed nodes of its shard.
+ *  The flusher is woken up, if the number of blocks stored in changed nodes of the shard rises above its high
+ *  watermark.
+ *
+ *  \param node pointer to the node
+ */
+
+static void setChanged (SOBufferCacheNode *node)
+{
+  SOCacheShard *sh = SHARD_OF (node);            /* shard the node belongs to */
+
+  if (node->stat == CHANGED)
+     { if (node->owner != curOwner) node->owner = CACHE_NO_OWNER;   /* the changes are shared */
+       return;
+     }
+
+  node->stat = CHANGED;
+  node->changedAt = nowMs ();
+  node->owner = curOwner;
+  node->dirty_prev = NULL;
+  node->dirty_next = sh->dirtyList;
+  if (sh->dirtyList != NULL) sh->dirtyList->dirty_prev = node;
+  sh->dirtyList = node;
+  sh->nChanged += node->nBlks;
+  if (!sh->draining && (sh->nChanged > __atomic_load_n (&dirtyHigh, __ATOMIC_RELAXED)))
+     pthread_cond_signal (&flushWake);
+}
+
+/**
+ *  \brief Mark the status of a node as same.
+ *
+ *  The node is removed from the list of changed nodes of its shard.
+ *
+ *  \param node pointer to the node
+ */
+
+static void setSame (SOBufferCacheNode *node)
+{
+  SOCacheShard *sh;                              /* shard the node belongs to */
+
+  if (node->stat == SAME) return;
+
+  sh = SHARD_OF (node);
+  node->stat = SAME;
+  if (node->dirty_prev != NULL)
+     node->dirty_prev->dirty_next = node->dirty_next;
+     else sh->dirtyList = node->dirty_next;
+  if (node->dirty_next != NULL) node->dirty_next->dirty_prev = node->dirty_prev;
+  node->dirty_prev = node->dirty_next = NULL;
+  sh->nChanged -= node->nBlks;
+}
+
+/**
+ *  \brief Stop the flusher, if it is running.
+ *
+ *  It must be called inside the critical region, which is left while waiting for the flusher to terminate.
+ */
+
+static void stopFlusher (void)
+{
+  uint32_t s;
+
+  if (!flusherOn) return;
+
+  __atomic_store_n (&dirtyHigh, UINT32_MAX, __ATOMIC_RELAXED);
+  __atomic_store_n (&flusherStop, true, __ATOMIC_RELAXED);
+  pthread_cond_signal (&flushWake);
+  pthread_mutex_unlock (&cacheAccess);
+  pthread_join (flusher, NULL);
+  pthread_mutex_lock (&cacheAccess);
+  flusherOn = flusherStop = false;
+  for (s = 0; s < nShards; s++)
+  { pthread_mutex_lock (&shards[s].access);
+    shards[s].draining = false;
+    pthread_mutex_unlock (&shards[s].access);
+  }
+}
+
+/**
+ *  \brief Life cycle of the flusher.
+ *
+ *  In each period, changed nodes are written back, shard by shard and run by run, up to the number of blocks allowed
+ *  by the maximum rate; a shard is locked for a single run at a time, so that the foreground operations are kept
+ *  waiting for a single run at most, and the critical region is left while the shards are swept. The flusher is woken
+ *  up before the period expires to stop or, if the rate allows it, when the high watermark of a shard is crossed.
+ *  If a write fails, the flusher stops writing back: the failure is recorded, to be reported when the flusher is
+ *  stopped, and the nodes are left changed, to be written by the foreground operations, which report their own
+ *  failures.
+ *
+ *  \param arg not used
+ *
+ *  \return \c NULL
+ */
+
+static void *flushLoop (void *arg)
+{
+  uint64_t start = nowMs ();                     /* start of the current period */
+  uint64_t full = (flushRate != 0) ? ((uint64_t) flushRate * FLUSH_PERIOD + 999) / 1000 : UINT32_MAX;
+                                                 /* number of blocks which may be written in a period */
+  uint32_t budget = full;                        /* number of blocks which may still be written in the current period */
+  uint32_t nb;                                   /* number of blocks written by a run */
+  struct timespec until;                         /* time to wake up */
+  uint64_t wake;                                 /* time to wake up, in milliseconds from now */
+  uint32_t s;
+
+  (void) arg;                                    /* the flusher takes no argument */
+
+  pthread_mutex_lock (&cacheAccess);
+  while (!flusherStop)
+  { if (nowMs () - start >= FLUSH_PERIOD)
+       { start = nowMs ();
+         budget = full;
+       }
+    pthread_mutex_unlock (&cacheAccess);         /* the shards are locked one at a time */
+    for (s = 0; (s < nShards) && (budget > 0); s++)
+      while (!__atomic_load_n (&flusherStop, __ATOMIC_RELAXED) && (budget > 0) &&
+             ((nb = flushStep (&shards[s], budget)) != 0))
+        budget = (nb < budget) ? budget - nb : 0;
+    pthread_mutex_lock (&cacheAccess);
+    if (flusherStop || (__atomic_load_n (&flushError, __ATOMIC_RELAXED) != 0)) break;
+
+    wake = start + FLUSH_PERIOD - nowMs ();
+    if (wake > FLUSH_PERIOD) wake = 0;           /* the period has already expired */
+    clock_gettime (CLOCK_REALTIME, &until);
+    until.tv_sec += (until.tv_nsec + wake * 1000000) / 1000000000;
+    until.tv_nsec = (until.tv_nsec + wake * 1000000) % 1000000000;
+    pthread_cond_timedwait (&flushWake, &cacheAccess, &until);
+  }
+  pthread_mutex_unlock (&cacheAccess);
+
+  return NULL;
+}
+
+/**
+ *  \brief Write back a run of changed nodes of a shard on behalf of the flusher.
+ *
+ *  A node is eligible if its status is marked changed, it is not pinned and, either the flusher is draining the changed
+ *  nodes of the shard, or it has not been changed for longer than the maximum age. The shard is swept in ascending
+ *  order of physical block number: the run starts at the eligible node of lowest physical block number from where the
+ *  previous one ended on, wrapping around to the beginning of the device, and goes on with the eligible nodes which
+ *  store the blocks that follow, as long as they belong to the shard. The first node of the run is searched for in a
+ *  single walk of the list of changed nodes of the shard, the nodes that follow being looked up in the hash tables, so
+ *  that the shard is kept locked for a time which does not depend on the size of the storage area.
+ *  The run is written by a single synchronous vectored transfer (see writeRuns), with the shard locked. It is not
+ *  submitted to the asynchronous engine: the engine transfers single blocks or clusters only, which would split the
+ *  run, and its completions are collected by the readahead.
+ *  If it fails on writing, the failure is recorded in \e flushError.
+ *
+ *  \param sh pointer to the shard
+ *  \param budget maximum number of blocks of the run (a single node may exceed it)
+ *
+ *  \return number of blocks which were written, or <tt>0 (zero)</tt> if there is nothing to be written or it fails on
+ *          writing
+ */
+
+static uint32_t flushStep (SOCacheShard *sh, uint32_t budget)
+{
+  SOBufferCacheNode *list[MAX_FLUSH_RUN];        /* nodes of the run */
+  SOBufferCacheNode *node;                       /* pointer to the node under inspection */
+  SOBufferCacheNode *first = NULL;               /* first node of the run */
+  SOBufferCacheNode *lowest = NULL;              /* eligible node of lowest physical block number */
+  SOHashTable *table[2] = { &sh->blocks.hTable, &sh->clusters.hTable };  /* hash tables of the shard */
+  uint64_t now = nowMs ();                       /* current time */
+  uint64_t next;                                 /* physical number of the block following the run */
+  uint32_t high = __atomic_load_n (&dirtyHigh, __ATOMIC_RELAXED);  /* high watermark */
+  uint32_t cnt, nb;                              /* number of nodes and of blocks of the run */
+  int stat;                                      /* status of operation */
+
+#define ELIGIBLE(nd) (((nd)->stat == CHANGED) && ((nd)->pins == 0) && \
+                      (sh->draining || ((dirtyAge != 0) && (now - (nd)->changedAt >= dirtyAge))))
+
+  pthread_mutex_lock (&sh->access);
+  if (sh->nChanged > high) sh->draining = true;
+  if (sh->nChanged <= dirtyLow) sh->draining = false;
+
+  for (node = sh->dirtyList; node != NULL; node = node->dirty_next)
+    if (ELIGIBLE (node))
+       { if ((node->n >= sh->flushCursor) && ((first == NULL) || (node->n < first->n))) first = node;
+         if ((lowest == NULL) || (node->n < lowest->n)) lowest = node;
+       }
+  if (first == NULL) first = lowest;             /* wrap around */
+  if (first == NULL)
+     { pthread_mutex_unlock (&sh->access);
+       return 0;
+     }
+
+  list[0] = first;
+  nb = first->nBlks;
+  for (cnt = 1; (cnt < MAX_FLUSH_RUN) && (nb < budget); cnt++)
+  { next = (uint64_t) list[cnt-1]->n + list[cnt-1]->nBlks;
+    if ((next >= bnmax) || (SHARD (next) != sh)) break;
+    if (((node = searchNode (next, table[0])) == NULL) && ((node = searchNode (next, table[1])) == NULL)) break;
+    if (!ELIGIBLE (node)) break;
+    list[cnt] = node;
+    nb += node->nBlks;
+  }
+#undef ELIGIBLE
+
+  if ((stat = writeRuns (list, cnt)) != 0)
+     { __atomic_store_n (&flushError, stat, __ATOMIC_RELAXED);
+       soProbe (850, "buffercache flusher: writing back %"PRIu32" blocks at %"PRIu32" failed (%d)\n",
+                nb, first->n, stat);
+       nb = 0;
+     }
+     else sh->flushCursor = list[cnt-1]->n + list[cnt-1]->nBlks;
+  pthread_mutex_unlock (&sh->access);
+
+  return nb;
+}
+
+/**
+ *  \brief Get the current time of a monotonic clock.
+ *
+ *  \return current time (in milliseconds)
+ */
+
+static uint64_t nowMs (void)
+{
+  struct timespec t;                             /* current time */
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+
+  return (uint64_t) t.tv_sec * 1000 + t.tv_nsec / 1000000;
+}
+
+/**
+ *  \brief Track the streams of reads of successive clusters and read ahead the clusters which follow them.
+ *
+ *  The read is matched against the streams: if it starts where a stream is expected to go on, the stream goes on and
+ *  its readahead window is opened, or doubled; otherwise, the least recently read stream is replaced by a new one.
+ *  The clusters of the window which are not stored in the storage area are then read ahead, if less than half of the
+ *  window is left ahead of the stream. The completed transfers are collected beforehand.
+ *  It must be called with no shard locked: the shards of each cluster read ahead are locked while a node is assigned
+ *  to it.
+ *
+ *  \param n physical number of the first block of the first cluster which was read
+ *  \param nClust number of successive clusters which were read
+ */
+
+static void readAhead (uint32_t n, uint32_t nClust)
+{
+  SOBufferCacheNode *list[BLOCKS_PER_CLUSTER];   /* nodes where blocks of a cluster are stored */
+  SOBufferCacheNode *node;                       /* node assigned to a cluster read ahead */
+  SOCacheShard *sh;                              /* shard a cluster read ahead belongs to */
+  SOReadStream *st = NULL;                       /* stream the read belongs to */
+  SOReadStream *lru = &streams[0];               /* least recently read stream */
+  uint64_t end = (uint64_t) n + (uint64_t) nClust * BLOCKS_PER_CLUSTER;    /* block following the read */
+  uint64_t limit;                                /* block following the readahead window */
+  uint64_t m;                                    /* physical number of the first block of a cluster */
+  uint64_t held;                                 /* shards which are locked */
+  bool stop;                                     /* no more clusters are to be read ahead */
+  uint32_t i;
+
+  pthread_mutex_lock (&aheadAccess);
+  if (aheadMax == 0)                             /* readahead is off */
+     { pthread_mutex_unlock (&aheadAccess);
+       return;
+     }
+  while ((__atomic_load_n (&nAhead, __ATOMIC_RELAXED) != 0) && (reapAhead (false) == 0)) ;
+
+  for (i = 0; i < DIM_STREAMS; i++)
+  { if ((streams[i].used != 0) && (streams[i].next == n))
+       { st = &streams[i];
+         break;
+       }
+    if (streams[i].used < lru->used) lru = &streams[i];
+  }
+  if (st == NULL)                                /* a new stream */
+     { st = lru;
+       st->window = 0;
+       st->ahead = 0;
+     }
+     else if (st->window == 0)                   /* the reads were found successive */
+             { st->window = aheadInit;
+               aheadStats.nStreams += 1;
+             }
+     else st->window = (2 * st->window < aheadMax) ? 2 * st->window : aheadMax;
+  st->next = (end < bnmax) ? (uint32_t) end : bnmax;
+  st->used = ++streamClock;
+  if (st->window == 0)
+     { pthread_mutex_unlock (&aheadAccess);
+       return;
+     }
+
+  if (st->ahead < end) st->ahead = st->next;
+  if ((st->ahead - end) / BLOCKS_PER_CLUSTER >= st->window / 2)   /* enough is left ahead */
+     { pthread_mutex_unlock (&aheadAccess);
+       return;
+     }
+
+  limit = end + (uint64_t) st->window * BLOCKS_PER_CLUSTER;
+  for (m = st->ahead, stop = false;
+       !stop && (m + BLOCKS_PER_CLUSTER <= limit) && (m + BLOCKS_PER_CLUSTER <= bnmax) &&
+       (__atomic_load_n (&nAhead, __ATOMIC_RELAXED) < maxAhead);
+       m += BLOCKS_PER_CLUSTER)
+  { sh = SHARD (m);
+    held = lockShards (shardsOf (m, BLOCKS_PER_CLUSTER));
+    if (collectRange (m, BLOCKS_PER_CLUSTER, list) != 0)   /* already stored */
+       { unlockShards (held);
+         continue;
+       }
+    if (getFreeNode (sh, &sh->clusters, &node) != 0)
+       { unlockShards (held);
+         break;
+       }
+    node->stat = PENDING;
+    node->pins = 1;
+    node->ahead = 1;
+    bindNode (&sh->clusters, node, m);
+    if (soSubmitRawCluster (ASYNC_READ, m, node->buffer, node - shards[0].clusters.storage) != 0)
+       { unbindNode (&sh->clusters, node);
+         node->stat = SAME;
+         node->pins = 0;
+         node->ahead = 0;
+         putFreeNode (&sh->clusters, node);
+         stop = true;
+       }
+       else { sh->nAhead += 1;
+              __atomic_add_fetch (&nAhead, 1, __ATOMIC_RELAXED);
+              aheadStats.nIssued += 1;
+            }
+    unlockShards (held);
+    if (stop) break;
+  }
+  st->ahead = m;
+  pthread_mutex_unlock (&aheadAccess);
+}
+
+/**
+ *  \brief Collect the completion of a cluster being read ahead.
+ *
+ *  The node is unpinned and its status is marked \e same; if the transfer failed, the node is unassigned.
+ *  It must be called with no shard locked, since the shard of the node is locked while it is updated.
+ *
+ *  \param wait \c true, if the caller is to be blocked until a completion is available; \c false, otherwise
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by soReapRawCompletion
+ */
+
+static int reapAhead (bool wait)
+{
+  SOBufferCacheNode *node;                       /* node where the cluster is stored */
+  SOCacheShard *sh;                              /* shard the node belongs to */
+  uint64_t tag;                                  /* index of the node */
+  int stat, tstat;                               /* status of operation and of the transfer */
+
+  if ((stat = soReapRawCompletion (wait, &tag, &tstat)) != 0) return stat;
+  node = &shards[0].clusters.storage[tag];
+  sh = SHARD_OF (node);
+  pthread_mutex_lock (&sh->access);
+  node->pins -= 1;
+  node->stat = SAME;
+  sh->nAhead -= 1;
+  if (tstat != 0)
+     { node->ahead = 0;
+       dropNode (node);
+     }
+  pthread_mutex_unlock (&sh->access);
+  __atomic_sub_fetch (&nAhead, 1, __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+/**
+ *  \brief Set readahead off, waiting for the clusters being read ahead and stopping the asynchronous engine.
+ *
+ *  It must be called inside the critical region, with no shard locked.
+ */
+
+static void stopAhead (void)
+{
+  pthread_mutex_lock (&aheadAccess);
+  aheadInit = aheadMax = 0;
+  while ((__atomic_load_n (&nAhead, __ATOMIC_RELAXED) != 0) && (reapAhead (true) == 0)) ;
+  if (aheadEngine) soCloseAsyncEngine ();
+  aheadEngine = false;
+  pthread_mutex_unlock (&aheadAccess);
+}
+
+/**
+ *  \brief Get the region of the device a block belongs to.
+ *
+ *  It is the region whose first block is the nearest one at, or before, the block. It must be called with a shard
+ *  locked.
+ *
+ *  \param n physical number of the block
+ *
+ *  \return region (CACHE_SUPERBLOCK, CACHE_ITABLE, CACHE_FCTABLE or CACHE_DZONE)
+ */
+
+static uint32_t regionOf (uint32_t n)
+{
+  uint32_t r, region = CACHE_SUPERBLOCK;         /* region under inspection and region of the block */
+
+  for (r = CACHE_SUPERBLOCK + 1; r < CACHE_NREGIONS; r++)
+    if ((regionStart[r] <= n) && (regionStart[r] >= regionStart[region])) region = r;
+
+  return region;
+}
+
+/**
+ *  \brief Add up the statistics of the buffercache and those of the shards.
+ *
+ *  It must be called inside the critical region.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ */
+
+static void sumStats (SOCacheStats *p_stats)
+{
+  SOCacheRegionStats *p, *q;                     /* statistics of a region: total and of a shard */
+  uint32_t s, r;
+
+  *p_stats = cacheStats;
+  for (s = 0; s < nShards; s++)
+  { pthread_mutex_lock (&shards[s].access);
+    for (r = 0; r < CACHE_NREGIONS; r++)
+    { p = &p_stats->region[r];
+      q = &shards[s].stats.region[r];
+      p->nHits += q->nHits;
+      p->nMisses += q->nMisses;
+      p->nEvictions += q->nEvictions;
+      p->nWritebacks += q->nWritebacks;
+    }
+    pthread_mutex_unlock (&shards[s].access);
+  }
+}
+
+/**
+ *  \brief Dump the statistics of the buffercache through the probing system.
+ *
+ *  It must be called inside the critical region.
+ */
+
+static void dumpStats (void)
+{
+  char *text = NULL;                             /* the statistics printed as a string */
+  size_t len = 0;
+  FILE *fs;
+
+  if ((fs = open_memstream (&text, &len)) == NULL) return;
+  printStats (fs);
+  fclose (fs);
+  if (len > 0) soProbe (850, "buffercache statistics\n%s", text);
+  free (text);
+}
+
+/**
+ *  \brief Print the statistics of the buffercache.
+ *
+ *  A line with the counters is printed for each region of the device which was accessed at least once.
+ *  It must be called inside the critical region.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ */
+
+static void printStats (FILE *fs)
+{
+  static const char *regionName[CACHE_NREGIONS] = { "superblock", "inode table", "free clusters", "data zone" };
+  SOCacheStats s;                                /* copy of the statistics */
+  SOCacheRegionStats *p;                         /* statistics of a region */
+  uint32_t r;
+
+  sumStats (&s);
+  for (r = 0; r < CACHE_NREGIONS; r++)
+  { p = &s.region[r];
+    if (p->nHits + p->nMisses + p->nEvictions + p->nWritebacks == 0) continue;
+    fprintf (fs, "%-14s hits %"PRIu64", misses %"PRIu64", evictions %"PRIu64", writebacks %"PRIu64
+             ", hit ratio %.1f%%\n", regionName[r], p->nHits, p->nMisses, p->nEvictions, p->nWritebacks,
+             (p->nHits + p->nMisses != 0) ? 100.0 * p->nHits / (p->nHits + p->nMisses) : 0.0);
+  }
+}
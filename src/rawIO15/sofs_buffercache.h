@@ -21,12 +21,25 @@
  *        a new node in the storage area is initialized to this data block (cluster), the contents of the supplied
  *        buffer is copied into it and its status is marked <em>changed</em>, as before
  *    \li because the number of nodes in the storage area is finite, whenever it happens that no more free nodes are
- *        available, the node that has not been accessed for the longest time is selected for replacement: its contents,
+ *        available, a node is selected for replacement by the replacement policy (the one that has not been accessed
+ *        for the longest time, by default): its contents,
  *        if needed (the status is marked <em>changed</em>), is first transfered to the device, then it becomes
  *        available for a new assignment.
  *
+ *  A block, or a cluster, may also be pinned in the storage area, so that it is read and modified in place, through a
+ *  pointer to its contents, instead of being copied in and out. A pinned block is never replaced until it is unpinned;
+ *  hence, while some blocks are pinned, the operations which need a node may fail with -\c ENOBUFS, if every node
+ *  where the block might be stored is pinned, or with -\c EBUSY, if a pinned block would have to be moved to a
+ *  cluster node.
+ *
+ *  The operations on blocks and clusters may be called concurrently by several threads: the storage area is split in
+ *  shards, each one storing the blocks of some stripes of the device and having a lock of its own, so that operations
+ *  on blocks far apart seldom contend. The storage area must not be assigned to, nor unassigned from, the device, nor
+ *  resized, while other operations are in progress.
+ *
  *  The following operations are defined:
  *    \li initialize the storage area and assign it to the storage device
+ *    \li initialize the storage area, with a given replacement policy, and assign it to the storage device
  *    \li unassign the storage area from the storage device and perform the required housekeeping duties
  *    \li read a block of data from the buffercache
  *    \li write a block of data to the buffercache
@@ -35,7 +48,29 @@
  *    \li read a cluster of data from the buffercache
  *    \li write a cluster of data to the buffercache
  *    \li flush a cluster of data to the storage device
- *    \li synchronize a cluster of data with the same cluster in the storage device.
+ *    \li synchronize a cluster of data with the same cluster in the storage device
+ *    \li synchronize a sequence of blocks of data with the same blocks in the storage device
+ *    \li set the owner of the changes made by the calling thread
+ *    \li synchronize the changes of an owner with the storage device
+ *    \li read a sequence of successive clusters of data from the buffercache
+ *    \li discard a sequence of successive clusters of data, releasing their storage in the storage device
+ *    \li set the discard mode
+ *    \li get the discard mode
+ *    \li set the size of the storage area
+ *    \li set the size of the metadata partition of the storage area
+ *    \li set the supporting files the storage device is striped over
+ *    \li set whether the clusters accessed by the calling thread are references
+ *    \li pin a block of data in the buffercache
+ *    \li pin a cluster of data in the buffercache
+ *    \li mark the contents of a pinned block, or cluster, as changed
+ *    \li unpin a block, or a cluster, of data
+ *    \li start the flusher of the buffercache
+ *    \li stop the flusher of the buffercache
+ *    \li set the readahead of the buffercache
+ *    \li get the statistics of the readahead of the buffercache
+ *    \li set the regions of the device the statistics of the buffercache are split by
+ *    \li get the statistics of the buffercache
+ *    \li print the statistics of the buffercache.
  *
  *  \author Artur Carneiro Pereira - September 2007
  *  \author Miguel Oliveira e Silva - September 2009
@@ -49,19 +84,97 @@
 #ifndef SOFS_BUFFERCACHE_H_
 #define SOFS_BUFFERCACHE_H_
 
+#include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
+
 /** \brief the communication channel to the storage device is buffered */
 #define BUF    0
 /** \brief the communication channel to the storage device is unbuffered */
 #define UNBUF  1
+/** \brief the communication channel to the storage device is unbuffered and the device is mapped into memory */
+#define MAPPED 2
+/** \brief the communication channel to the storage device is buffered and the device bypasses the page cache */
+#define DIRECT 3
+
+/** \brief replacement policy: the node that has not been accessed for the longest time is replaced */
+#define CACHE_LRU  0
+/** \brief replacement policy: 2Q, the blocks accessed only once are replaced before the ones accessed repeatedly */
+#define CACHE_2Q   1
+
+/** \brief owner of the changes made on behalf of no owner, or of several ones (see soSetCacheOwner) */
+#define CACHE_NO_OWNER  UINT32_MAX
+
+/** \brief maximum readahead window (in clusters) */
+#define MAX_READAHEAD (64)
+
+/**
+ *  \brief Definition of the statistics of the readahead of the buffercache.
+ */
+
+typedef struct soCacheAheadStats
+{
+   /** \brief number of times a stream of reads of successive clusters was found */
+    uint64_t nStreams;
+   /** \brief number of clusters which were read ahead */
+    uint64_t nIssued;
+   /** \brief number of clusters read ahead which were accessed afterwards */
+    uint64_t nHits;
+   /** \brief number of clusters read ahead which were replaced without being accessed */
+    uint64_t nWasted;
+   /** \brief number of accesses which had to wait for a cluster being read ahead */
+    uint64_t nWaits;
+} SOCacheAheadStats;
+
+/* Regions of the device the statistics of the buffercache are split by */
+
+/** \brief superblock */
+#define CACHE_SUPERBLOCK  0
+/** \brief table of inodes */
+#define CACHE_ITABLE      1
+/** \brief table of references to free data clusters */
+#define CACHE_FCTABLE     2
+/** \brief data zone */
+#define CACHE_DZONE       3
+
+/** \brief number of regions of the device the statistics of the buffercache are split by */
+#define CACHE_NREGIONS    4
+
+/**
+ *  \brief Definition of the statistics of the buffercache for a region of the device.
+ */
+
+typedef struct soCacheRegionStats
+{
+   /** \brief number of accesses to blocks, or clusters, which were stored in the storage area */
+    uint64_t nHits;
+   /** \brief number of accesses to blocks, or clusters, which had to be assigned a node */
+    uint64_t nMisses;
+   /** \brief number of nodes which were replaced */
+    uint64_t nEvictions;
+   /** \brief number of changed nodes which were written back to the device */
+    uint64_t nWritebacks;
+} SOCacheRegionStats;
+
+/**
+ *  \brief Definition of the statistics of the buffercache.
+ */
+
+typedef struct soCacheStats
+{
+   /** \brief statistics of each region of the device, indexed by CACHE_SUPERBLOCK, CACHE_ITABLE, CACHE_FCTABLE and
+    *         CACHE_DZONE */
+    SOCacheRegionStats region[CACHE_NREGIONS];
+} SOCacheStats;
 
 /**
  *  \brief Initialize the storage area and assign it to the storage device.
  *
  *  A communication channel is established with the storage device so that data transfers between main memory and the
  *  storage device may be minimized.
- *  This communication may be unbuffered or buffered: it will be unbuffered, if the second argument is \c UNBUF , and
- *  buffered, in any other case.
+ *  This communication may be unbuffered or buffered: it will be unbuffered, if the second argument is \c UNBUF , mapped
+ *  into memory, if it is \c MAPPED, buffered over a device opened for direct I/O, if it is \c DIRECT, so that the
+ *  storage area is the only cache of the device's blocks, and buffered, in any other case.
  *
  *  \param devname absolute path to the Linux file that simulates the storage device
  *  \param type type of the communication channel that is opened
@@ -70,11 +183,38 @@
  *  \return -\c EINVAL, if the argument is \c NULL
  *  \return -\c EBUSY, if the storage area is already in use or the device is already opened
  *  \return -\c ELIBBAD, if the supporting file size is invalid
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -\c ENOTSUP, if the type is \c DIRECT and direct I/O of single blocks is not supported by the file system
+ *  \return -\c ENOTSUP, if the type is \c MAPPED or \c DIRECT and the device is striped (see soSetCacheStripes)
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat or \e mmap system calls
  */
 
 extern int soOpenBufferCache (const char *devname, uint32_t type);
 
+/**
+ *  \brief Initialize the storage area, with a given replacement policy, and assign it to the storage device.
+ *
+ *  The storage area is initialized as in soOpenBufferCache, the nodes to be replaced being selected by the replacement
+ *  policy which is given: \c CACHE_LRU selects the node that has not been accessed for the longest time; \c CACHE_2Q
+ *  keeps the blocks that were accessed only once apart from the ones accessed repeatedly, so that long sequential scans
+ *  do not replace the latter. soOpenBufferCache uses \c CACHE_LRU.
+ *
+ *  \param devname absolute path to the Linux file that simulates the storage device
+ *  \param type type of the communication channel that is opened
+ *  \param pol replacement policy (\c CACHE_LRU or \c CACHE_2Q)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the first argument is \c NULL or the replacement policy is invalid
+ *  \return -\c EBUSY, if the storage area is already in use or the device is already opened
+ *  \return -\c ELIBBAD, if the supporting file size is invalid
+ *  \return -\c ENOTSUP, if the type is \c DIRECT and direct I/O of single blocks is not supported by the file system
+ *  \return -\c ENOTSUP, if the type is \c MAPPED or \c DIRECT and the device is striped (see soSetCacheStripes)
+ *  \return -\c ENOMEM, if there is no memory for the storage area or for the internal data structures of the
+ *                      replacement policy
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat or \e mmap system calls
+ */
+
+extern int soOpenBufferCachePolicy (const char *devname, uint32_t type, uint32_t pol);
+
 /**
  *  \brief Unassign the storage area from the storage device and perform the required housekeeping duties.
  *
@@ -84,9 +224,10 @@ extern int soOpenBufferCache (const char *devname, uint32_t type);
  *
  *  \return <tt>0 (zero)</tt>, on success
  *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EBUSY, if there are blocks, or clusters, still pinned
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the internal data is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soCloseBufferCache (void);
@@ -105,7 +246,7 @@ extern int soCloseBufferCache (void);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soReadCacheBlock (uint32_t n, void *buf);
@@ -124,7 +265,7 @@ extern int soReadCacheBlock (uint32_t n, void *buf);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soWriteCacheBlock (uint32_t n, void *buf);
@@ -143,7 +284,7 @@ extern int soWriteCacheBlock (uint32_t n, void *buf);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soFlushCacheBlock (uint32_t n, void *buf);
@@ -160,7 +301,7 @@ extern int soFlushCacheBlock (uint32_t n, void *buf);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soSyncCacheBlock (uint32_t n);
@@ -180,7 +321,7 @@ extern int soSyncCacheBlock (uint32_t n);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soReadCacheCluster (uint32_t n, void *buf);
@@ -200,7 +341,7 @@ extern int soReadCacheCluster (uint32_t n, void *buf);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soWriteCacheCluster (uint32_t n, void *buf);
@@ -220,7 +361,7 @@ extern int soWriteCacheCluster (uint32_t n, void *buf);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soFlushCacheCluster (uint32_t n, void *buf);
@@ -238,9 +379,416 @@ extern int soFlushCacheCluster (uint32_t n, void *buf);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soSyncCacheCluster (uint32_t n);
 
+/**
+ *  \brief Synchronize a sequence of blocks of data with the same blocks in the storage device.
+ *
+ *  The changed blocks, and clusters, which overlap the sequence are written in ascending order of physical block
+ *  number, runs of successive blocks being merged into single vectored transfers; a cluster is written as a whole,
+ *  even if only some of its blocks belong to the sequence.
+ *
+ *  \param first physical number of the first block of the sequence
+ *  \param last physical number of the last block of the sequence
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if <em>first</em> is greater than <em>last</em> or <em>last</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwrite or \e msync system calls
+ */
+
+extern int soSyncCacheRange (uint32_t first, uint32_t last);
+
+/**
+ *  \brief Set the owner of the changes made by the calling thread.
+ *
+ *  Every block, or cluster, changed afterwards by the calling thread (written or marked changed) is tagged with the
+ *  owner, usually the number of the inode the change belongs to, so that soSyncCacheOwner writes only the changes of
+ *  the owner. A block changed on behalf of several owners, or while no owner is set, is regarded as shared by all of
+ *  them and is written whichever owner is synchronized. Initially, no owner is set.
+ *
+ *  \param owner owner of the changes (\c CACHE_NO_OWNER, to set no owner)
+ *
+ *  \return the owner which was set before
+ */
+
+extern uint32_t soSetCacheOwner (uint32_t owner);
+
+/**
+ *  \brief Synchronize the changes of an owner with the storage device.
+ *
+ *  The changed blocks, and clusters, tagged with the owner, or shared, are written in ascending order of physical block
+ *  number, runs of successive blocks being merged into single vectored transfers; the changes of other owners are left
+ *  in the storage area. Only the changed nodes are looked at, so that the cost does not depend on the size of the
+ *  storage area. On a mapped communication channel, the whole device is synchronized.
+ *
+ *  \param owner owner of the changes (see soSetCacheOwner)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwrite or \e msync system calls
+ */
+
+extern int soSyncCacheOwner (uint32_t owner);
+
+/**
+ *  \brief Read a sequence of successive clusters of data from the buffercache.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the first block of the first data cluster to be read, the number of clusters and a pointer
+ *  to a previously allocated buffer, large enough to hold all of them, are supplied as arguments.
+ *
+ *  Clusters none of whose blocks are stored in the storage area are grouped in runs which are read from the device by a
+ *  single vectored transfer; the remaining clusters are processed one by one.
+ *
+ *  \param n physical number of the first block of the first data cluster to be read from
+ *  \param nClust number of successive clusters to be read
+ *  \param buf pointer to the buffer where the data must be read into
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL, the <em>number of clusters</em> is zero or the
+ *                      <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e preadv, \e pread or \e pwrite system calls
+ */
+
+extern int soReadCacheClusters (uint32_t n, uint32_t nClust, void *buf);
+
+/**
+ *  \brief Discard a sequence of successive clusters of data, releasing their storage in the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The clusters are meant to hold no useful information any longer: a hole is punched in the supporting file, so that
+ *  their storage is released, and their contents is read as zeros afterwards. The blocks of the clusters which are
+ *  stored in the storage area are zeroed and their status is marked \e same, so that they are never written back.
+ *
+ *  \param n physical number of the first block of the first data cluster to be discarded
+ *  \param nClust number of successive clusters to be discarded
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>number of clusters</em> is zero or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EOPNOTSUPP, if the file system hosting the supporting file does not support punching holes
+ *  \return -<em>other specific error</em> issued by \e fallocate system call
+ */
+
+extern int soDiscardCacheClusters (uint32_t n, uint32_t nClust);
+
+/**
+ *  \brief Set the discard mode.
+ *
+ *  In discard mode, the file system releases the storage of the data clusters it frees (see
+ *  soDiscardCacheClusters), so that the supporting file is kept sparse. The mode is not changed when the storage area
+ *  is assigned to, or unassigned from, the storage device. It is initially off.
+ *
+ *  \param on \c true, to set the discard mode on; \c false, to set it off
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ */
+
+extern int soSetDiscardMode (bool on);
+
+/**
+ *  \brief Get the discard mode.
+ *
+ *  \return \c true, if the discard mode is on; \c false, otherwise
+ */
+
+extern bool soGetDiscardMode (void);
+
+/**
+ *  \brief Set the size of the storage area.
+ *
+ *  The size is given as the number of bytes of block contents the storage area is to be able to store, half of them
+ *  in block nodes and the other half in cluster nodes; the memory taken by the nodes and the hash tables comes on top
+ *  of it. All of it is carved from a single arena, mapped when the storage area is assigned to the device, which may
+ *  be backed by huge pages (explicitly reserved huge pages, if there are enough of them, or transparent huge pages,
+ *  otherwise), so that a large storage area takes neither an allocation per node nor a translation per small page.
+ *  The size takes effect the next time the storage area is assigned to the device; it is not changed when the storage
+ *  area is unassigned. It is initially 1024 blocks.
+ *
+ *  \param size size of the storage area (in bytes; it is rounded down to a whole number of blocks)
+ *  \param huge \c true, if the arena is to be backed by huge pages; \c false, otherwise
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>size</em> is too small for four cluster nodes or greater than 2^31 blocks
+ */
+
+extern int soSetBufferCacheSize (uint64_t size, bool huge);
+
+/**
+ *  \brief Set the size of the metadata partition of the storage area.
+ *
+ *  The cluster nodes are split in two partitions: one for the clusters of references (see soSetCacheMetadata) and
+ *  the other for the clusters of data, so that a stream of data does not replace the references which are accessed on
+ *  nearly every operation. Each partition replaces its own nodes when it is full; the nodes of a partition which are
+ *  not assigned yet are only taken by the other one while the partition is not full, and are given back to it as
+ *  soon as it needs them. The metadata partition is carved from the storage area, whose size is not changed (the
+ *  block nodes, where the superblock and the tables of inodes and of references to free data clusters are stored, are
+ *  kept apart from the cluster nodes already).
+ *  The size takes effect the next time the storage area is assigned to the device, being cut down to half of the
+ *  cluster nodes, if it is greater; it is not changed when the storage area is unassigned. It is initially zero (a
+ *  single partition).
+ *
+ *  \param size size of the metadata partition (in bytes; it is rounded up to a whole number of clusters per shard)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ */
+
+extern int soSetCacheMetaSize (uint64_t size);
+
+/**
+ *  \brief Set the supporting files the storage device is striped over.
+ *
+ *  The storage device is striped over the file given when the storage area is assigned to the device, followed by the
+ *  files which are set here, in stripe units of a given number of clusters (see soOpenStripedDevice); it is then
+ *  accessed in \c DEV_STD mode, the transfers to the different files being carried out in parallel. The names are
+ *  copied. The files take effect the next time the storage area is assigned to the device; they are not changed when
+ *  the storage area is unassigned. There are none initially (the device is not striped).
+ *
+ *  \param nFiles number of supporting files besides the one the storage area is assigned to (0, if the device is not
+ *                to be striped)
+ *  \param devname array of absolute paths to the Linux files that support the rest of the storage device
+ *  \param unit stripe unit (number of clusters)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>number of files</em> is greater than <tt>STRIPE_MAX_FILES - 1</tt> or, being
+ *                      non-zero, the array, or some of its paths, is \c NULL or the <em>stripe unit</em> is zero
+ *  \return -\c ENOMEM, if there is no memory to copy the names
+ */
+
+extern int soSetCacheStripes (uint32_t nFiles, const char *devname[], uint32_t unit);
+
+/**
+ *  \brief Set whether the clusters accessed by the calling thread are references.
+ *
+ *  While it is set, the clusters accessed by the thread are stored in the metadata partition of the storage area (see
+ *  soSetCacheMetaSize), a cluster already stored in the data partition being moved there (the least valuable cluster
+ *  of the metadata partition being moved to the data partition in exchange, if it is full). It is kept per thread
+ *  and is initially \c false.
+ *
+ *  \param on \c true, if the clusters are references; \c false, otherwise
+ *
+ *  \return the former setting
+ */
+
+extern bool soSetCacheMetadata (bool on);
+
+/**
+ *  \brief Pin a block of data in the buffercache.
+ *
+ *  The block is stored in the storage area, as if it was read (or written, if it is not to be read from the device),
+ *  and a pointer to its contents in the buffer of the node is returned. The contents may be read, and modified, in
+ *  place until the block is unpinned (see soUnpinCache); a modification must be signalled by soMarkCacheChanged. The
+ *  node is not replaced nor unassigned while it is pinned. A block may be pinned several times, as long as it is
+ *  unpinned as many times.
+ *  Pinning is supported on a buffered communication channel and on a mapped one. On a mapped channel, the pointer
+ *  refers to the contents of the block in the mapping of the supporting file (see soMapRawBlock), which is read and
+ *  modified in place with no intermediate copy; changes reach the device when it is synchronized.
+ *
+ *  \param n physical number of the data block to be pinned
+ *  \param fill \c true, if the contents of the block must be read from the device when it is not stored in the storage
+ *              area; \c false, if it is to be wholly overwritten, its contents being undefined in that case
+ *  \param p_buf pointer to a location where the pointer to the contents of the block is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer to the location</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is unbuffered
+ *  \return -\c ENOBUFS, if all the nodes where the block might be stored are pinned
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+extern int soPinCacheBlock (uint32_t n, bool fill, void **p_buf);
+
+/**
+ *  \brief Pin a cluster of data in the buffercache.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The cluster is stored in a cluster node and pinned, as a block is by soPinCacheBlock (on a mapped communication
+ *  channel, the pointer refers to the contents of the cluster in the mapping of the supporting file).
+ *
+ *  \param n physical number of the first block of the data cluster to be pinned
+ *  \param fill \c true, if the contents of the cluster must be read from the device when it is not stored in the
+ *              storage area; \c false, if it is to be wholly overwritten, its contents being undefined in that case
+ *  \param p_buf pointer to a location where the pointer to the contents of the cluster is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer to the location</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is unbuffered
+ *  \return -\c EBUSY, if some block of the cluster is pinned in a block node
+ *  \return -\c ENOBUFS, if all the cluster nodes are pinned
+ *  \return -\c EIO, if it fails on reading or writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+extern int soPinCacheCluster (uint32_t n, bool fill, void **p_buf);
+
+/**
+ *  \brief Mark the contents of a pinned block, or cluster, as changed.
+ *
+ *  The status of the node is marked \e changed, so that its contents is written back to the device. On a mapped
+ *  communication channel, there is nothing to be done: the changes are made in the mapping of the supporting file.
+ *
+ *  \param buf pointer to the contents of the block, or cluster, as returned by soPinCacheBlock or soPinCacheCluster
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer does not point to a pinned block, or cluster
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+extern int soMarkCacheChanged (const void *buf);
+
+/**
+ *  \brief Unpin a block, or a cluster, of data.
+ *
+ *  The pointer to its contents must not be used afterwards, unless the block, or cluster, is still pinned. On a mapped
+ *  communication channel, there is nothing to be done: pins are not counted.
+ *
+ *  \param buf pointer to the contents of the block, or cluster, as returned by soPinCacheBlock or soPinCacheCluster
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer does not point to a pinned block, or cluster
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+extern int soUnpinCache (const void *buf);
+
+/**
+ *  \brief Start the flusher of the buffercache.
+ *
+ *  The flusher is a thread which writes the changed nodes back to the device in the background, so that a node is
+ *  seldom written when it is replaced or the storage area is unassigned. It wakes up periodically and writes, in
+ *  ascending order of physical block number, the changed nodes which have not been changed for a while and, once the
+ *  number of blocks stored in changed nodes of a shard rises above its share of a high watermark, all the changed
+ *  nodes of the shard until that number falls to half the share. Pinned nodes are passed over. The flusher is stopped
+ *  when the storage area is unassigned from the device.
+ *  The flusher is only supported on a buffered communication channel.
+ *
+ *  \param ratio high watermark, as a percentage of the number of blocks the storage area is able to store (1 to 100)
+ *  \param age time a node may stay changed before it is written back (in milliseconds; 0, if unlimited)
+ *  \param rate maximum number of blocks written per second (0, if unlimited)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>ratio</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is not buffered
+ *  \return -\c EBUSY, if the flusher is already running
+ *  \return -<em>other specific error</em> issued by \e pthread_create
+ */
+
+extern int soStartCacheFlusher (uint32_t ratio, uint32_t age, uint32_t rate);
+
+/**
+ *  \brief Stop the flusher of the buffercache.
+ *
+ *  The changed nodes which were not written back yet are kept in the storage area.
+ *  If a write of the flusher failed, the flusher stopped writing back at that point, the nodes it was writing being
+ *  kept changed, and the failure is reported here.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c ESRCH, if the flusher is not running
+ *  \return -<em>specific error</em> issued by the lower level on a write of the flusher which failed
+ */
+
+extern int soStopCacheFlusher (void);
+
+/**
+ *  \brief Set the readahead of the buffercache.
+ *
+ *  Successive reads of clusters (by soReadCacheClusters, soReadCacheCluster or soPinCacheCluster) are tracked as
+ *  streams. When a stream is found, the clusters which follow it are read ahead, asynchronously, into newly assigned
+ *  cluster nodes, which are pinned until the transfer is completed: the readahead window starts at \e init clusters
+ *  and is doubled on every further read of the stream, up to \e max clusters, and the clusters of the window are read
+ *  when less than half of it is left ahead of the stream. An access to a cluster which is still being read ahead waits
+ *  for the transfer.
+ *  The transfers are run by the asynchronous engine (see sofs_rawasync.h), which is started by the buffercache and is
+ *  stopped when readahead is set off or the storage area is unassigned from the device. Readahead is initially off.
+ *  Readahead is only supported on a buffered communication channel.
+ *
+ *  \param init initial readahead window (in clusters)
+ *  \param max maximum readahead window (in clusters; 0, to set readahead off)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>initial window</em> is zero or greater than the <em>maximum window</em>, or the
+ *                      <em>maximum window</em> is greater than \c MAX_READAHEAD
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the communication channel is not buffered
+ *  \return -\c EBUSY, if the asynchronous engine was already started elsewhere
+ *  \return -<em>other specific error</em> issued by soOpenAsyncEngine
+ */
+
+extern int soSetCacheReadahead (uint32_t init, uint32_t max);
+
+/**
+ *  \brief Get the statistics of the readahead of the buffercache.
+ *
+ *  The statistics are reset when the storage area is assigned to the device.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+extern int soGetCacheAheadStats (SOCacheAheadStats *p_stats);
+
+/**
+ *  \brief Set the regions of the device the statistics of the buffercache are split by.
+ *
+ *  The superblock is block 0 (zero); each of the other regions extends from its first block up to the first block of
+ *  the region which follows it on the device. Until the regions are set, every block but the superblock is accounted
+ *  to the data zone. The regions are kept until they are set again.
+ *
+ *  \param itable physical number of the first block of the table of inodes
+ *  \param fctable physical number of the first block of the table of references to free data clusters
+ *  \param dzone physical number of the first block of the data zone
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the regions starts at block 0 (zero)
+ */
+
+extern int soSetCacheRegions (uint32_t itable, uint32_t fctable, uint32_t dzone);
+
+/**
+ *  \brief Get the statistics of the buffercache.
+ *
+ *  Every access to a block, or a cluster, is a hit, if it is stored in the storage area, or a miss, otherwise; a
+ *  cluster read ahead is accounted only when it is accessed. A block, or cluster, is accounted to the region of the
+ *  device its (first) block belongs to.
+ *  The statistics are reset when the storage area is assigned to the device and are printed through the probing
+ *  system, with depth 850, when it is unassigned; they remain available until it is assigned again.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+extern int soGetCacheStats (SOCacheStats *p_stats);
+
+/**
+ *  \brief Print the statistics of the buffercache.
+ *
+ *  A line with the counters is printed for each region of the device which was accessed at least once.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the stream is \c NULL
+ */
+
+extern int soPrintCacheStats (FILE *fs);
+
 #endif /* SOFS_BUFFERCACHE_H_ */
@@ -0,0 +1,165 @@
+/**
+ *  \file sofs_buffercacheinternals.c (implementation file)
+ *
+ *  \brief Set of operations to internally manage the buffercache.
+ *
+ *  The nodes of the buffercache which are assigned to blocks are kept in a hash table indexed by the physical block
+ *  number of the storage device they are referencing, each bucket being a double-linked list of its own. Hence, one
+ *  needs to define operations to insert, remove, look up and traverse its nodes. The order of last access to the
+ *  blocks is kept apart, by the replacement policy (see sofs_cachepolicy.h).
+ *  One should notice that this module does not stand alone: it supposes a very tight coupling with the buffercache
+ *  implementation, its only application.
+ *
+ *  The buckets are linear: the first node has a \c NULL pointer to the previous one and the last node has a \c NULL
+ *  pointer to the next one. Successive physical block numbers map to different buckets, so that the blocks of a cluster
+ *  or of a sequence of clusters never share one.
+ *
+ *  The following operations are defined:
+ *    \li access the first node of the hash table
+ *    \li access the next node of the hash table
+ *    \li check if a given block, whose physical number is given, has already been stored in the storage area
+ *    \li insert a node in the hash table
+ *    \li remove a node from the hash table.
+ *
+ *  \author António Rui Borges - July 2010 / August 2011
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sofs_buffercachenode.h"
+#include "sofs_buffercacheinternals.h"
+
+/** \brief bucket of hash table \e t a physical block number maps to (multiplicative hashing, which is one-to-one on
+ *         any \e mask + 1 successive block numbers) */
+#define HASH(t,n)  (((uint32_t) (n) * 2654435761u) & (t)->mask)
+
+/*
+ *  Allusion to internal functions
+ */
+
+static SOBufferCacheNode *nextBucket (SOHashTable *hTable, uint32_t bucket);
+
+/**
+ *  \brief Access the first node of the hash table.
+ *
+ *  The iterator of the hash table is set to the first node of the first non empty bucket and a pointer to it is
+ *  returned. The nodes are visited in no particular order. Each hash table has an iterator of its own.
+ *
+ *  \param hTable pointer to the hash table
+ *
+ *  \return value of the <em>iterator</em>
+ */
+
+SOBufferCacheNode *getFirstNode (SOHashTable *hTable)
+{
+  if ((hTable == NULL) || (hTable->bucket == NULL)) return NULL;
+
+  return (hTable->iter = nextBucket (hTable, 0));
+}
+
+/**
+ *  \brief Access the next node of the hash table.
+ *
+ *  The iterator of the hash table is iterated if it does not already point to the last node of the hash table, and
+ *  a pointer to the node pointed to by the iterator is returned.
+ *
+ *  \param hTable pointer to the hash table
+ *
+ *  \return value of the <em>iterator</em>
+ */
+
+SOBufferCacheNode *getNextNode (SOHashTable *hTable)
+{
+  if ((hTable == NULL) || (hTable->iter == NULL)) return NULL;
+  if (hTable->iter->h_next != NULL)
+     hTable->iter = hTable->iter->h_next;
+     else hTable->iter = nextBucket (hTable, hTable->iterBucket + 1);
+
+  return hTable->iter;
+}
+
+/**
+ *  \brief Check if a given block, whose physical number is given, has already been stored in the storage area.
+ *
+ *  The bucket of the hash table the physical block number maps to is traversed to find out if there is a node whose
+ *  contents belongs to the block whose physical number is passed as the first argument.
+ *
+ *  \param nBlock physical block number
+ *  \param hTable pointer to the hash table
+ *
+ *  \return pointer to the node where the block contents is stored, or \c NULL if the block has not been stored yet
+ */
+
+SOBufferCacheNode *searchNode (uint32_t nBlock, SOHashTable *hTable)
+{
+  SOBufferCacheNode *node;                       /* pointer to the node under inspection */
+
+  if ((hTable == NULL) || (hTable->bucket == NULL)) return NULL;
+  for (node = hTable->bucket[HASH (hTable, nBlock)]; (node != NULL) && (node->n != nBlock); node = node->h_next) ;
+
+  return node;
+}
+
+/**
+ *  \brief Insert a node in the hash table.
+ *
+ *  A node whose contents belongs to a block of the storage device, which is supposed not to be stored in the storage
+ *  area yet, is inserted at the head of the bucket the physical block number maps to. If the node is already present,
+ *  nothing is done.
+ *
+ *  \param node pointer to the node to be inserted
+ *  \param hTable pointer to the hash table
+ */
+
+void insertNode (SOBufferCacheNode *node, SOHashTable *hTable)
+{
+  if ((node == NULL) || (hTable == NULL)) return;
+  if (searchNode (node->n, hTable) != NULL) return;         /* the block is already present */
+
+  SOBufferCacheNode **p_bucket = &hTable->bucket[HASH (hTable, node->n)];   /* head of the bucket */
+
+  node->h_prev = NULL;
+  node->h_next = *p_bucket;
+  if (*p_bucket != NULL) (*p_bucket)->h_prev = node;
+  *p_bucket = node;
+}
+
+/**
+ *  \brief Remove a node from the hash table.
+ *
+ *  If the node is the one the iterator points to, the iterator is moved to the next node beforehand, so that it is kept
+ *  valid.
+ *
+ *  \param node pointer to the node to be removed
+ *  \param hTable pointer to the hash table
+ */
+
+void removeNode (SOBufferCacheNode *node, SOHashTable *hTable)
+{
+  if ((node == NULL) || (hTable == NULL)) return;
+
+  if (hTable->iter == node) getNextNode (hTable);  /* keep the iterator valid */
+  if (node->h_prev != NULL)
+     node->h_prev->h_next = node->h_next;
+     else if (hTable->bucket[HASH (hTable, node->n)] == node)
+             hTable->bucket[HASH (hTable, node->n)] = node->h_next;
+  if (node->h_next != NULL) node->h_next->h_prev = node->h_prev;
+  node->h_prev = node->h_next = NULL;
+}
+
+/**
+ *  \brief Find the first node of the first non empty bucket, starting at a given one.
+ *
+ *  \param bucket index of the bucket where the search starts
+ *
+ *  \return pointer to the node, or \c NULL if all the remaining buckets are empty
+ */
+
+static SOBufferCacheNode *nextBucket (SOHashTable *hTable, uint32_t bucket)
+{
+  for (hTable->iterBucket = bucket; hTable->iterBucket <= hTable->mask; hTable->iterBucket++)
+    if (hTable->bucket[hTable->iterBucket] != NULL) return hTable->bucket[hTable->iterBucket];
+
+  return NULL;
+}
@@ -3,20 +3,19 @@
  *
  *  \brief Set of operations to internally manage the buffercache.
  *
- *  The buffercache is conceived as two double-linked lists: the first, based on the physical block number of the
- *  storage device it is referencing; the second, based on the order of last access to the block. Hence, one needs to
- *  define operations to insert, retrieve and access its nodes.
+ *  The nodes of the buffercache which are assigned to blocks are kept in a hash table indexed by the physical block
+ *  number of the storage device they are referencing, each bucket being a double-linked list of its own. Hence, one
+ *  needs to define operations to insert, remove, look up and traverse its nodes. The order of last access to the
+ *  blocks is kept apart, by the replacement policy (see sofs_cachepolicy.h).
  *  One should notice that this module does not stand alone: it supposes a very tight coupling with the buffercache
  *  implementation, its only application.
  *
  *  The following operations are defined:
- *    \li access the first node of the double-linked list based on the physical block number of the storage device
- *    \li access the next node of the double-linked list based on the physical block number of the storage device
+ *    \li access the first node of the hash table
+ *    \li access the next node of the hash table
  *    \li check if a given block, whose physical number is given, has already been stored in the storage area
- *    \li insert a node in the two double-linked lists infrastructure
- *    \li retrieve a node from the two double-linked lists infrastructure
- *    \li move a node already present in the storage area to the head of the double-linked list based on the last access
- *        time.
+ *    \li insert a node in the hash table
+ *    \li remove a node from the hash table.
  *
  *  \author António Rui Borges - July 2010 / August 2011
  */
@@ -29,96 +28,84 @@
 #include "sofs_buffercachenode.h"
 
 /**
- *  \brief Access the first node of the double-linked list based on the physical block number of the storage device.
+ *  \brief Definition of a hash table of nodes.
+ */
+
+typedef struct soHashTable
+{
+   /** \brief heads of the buckets */
+    SOBufferCacheNode **bucket;
+   /** \brief number of buckets, minus one (a power of two, minus one) */
+    uint32_t mask;
+   /** \brief iterator: the node it points to */
+    SOBufferCacheNode *iter;
+   /** \brief iterator: the bucket the node belongs to */
+    uint32_t iterBucket;
+} SOHashTable;
+
+/**
+ *  \brief Access the first node of the hash table.
  *
- *  An iterator internal variable is set to the value of the argument and a pointer to the node pointed to by the
- *  iterator variable is returned.
+ *  The iterator of the hash table is set to the first node of the first non empty bucket and a pointer to it is
+ *  returned. The nodes are visited in no particular order. Each hash table has an iterator of its own.
  *
- *  \param head pointer to the head of the linked list based on the physical block number of the storage device
+ *  \param hTable pointer to the hash table
  *
- *  \return value of the <em>iterator</em> variable
+ *  \return value of the <em>iterator</em>
  */
 
-extern SOBufferCacheNode *getFirstNodeOnN (SOBufferCacheNode *head);
+extern SOBufferCacheNode *getFirstNode (SOHashTable *hTable);
 
 /**
- *  \brief Access the next node of the double-linked list based on the physical block number of the storage device.
+ *  \brief Access the next node of the hash table.
  *
- *  The iterator internal variable is iterated if it does not already point to the last node of the linked list, and
- *  a pointer to the node pointed to by the iterator variable is returned.
+ *  The iterator of the hash table is iterated if it does not already point to the last node of the hash table, and
+ *  a pointer to the node pointed to by the iterator is returned.
  *
- *  \return value of the <em>iterator</em> variable
+ *  \param hTable pointer to the hash table
+ *
+ *  \return value of the <em>iterator</em>
  */
 
-extern SOBufferCacheNode *getNextNodeOnN (void);
+extern SOBufferCacheNode *getNextNode (SOHashTable *hTable);
 
 /**
  *  \brief Check if a given block, whose physical number is given, has already been stored in the storage area.
  *
- *  The double-linked list based on the physical block number of the storage device is traversed from the node pointed
- *  to by the second argument to find out if there is a node whose contents belongs to the block whose physical number
- *  is passed as the first argument.
+ *  The bucket of the hash table the physical block number maps to is traversed to find out if there is a node whose
+ *  contents belongs to the block whose physical number is passed as the first argument.
  *
  *  \param nBlock physical block number
- *  \param head pointer to the head of the linked list based on the block number of the storage device
+ *  \param hTable pointer to the hash table
  *
  *  \return pointer to the node where the block contents is stored, or \c NULL if the block has not been stored yet
  */
 
-extern SOBufferCacheNode *searchNodeOnN (uint32_t nBlock, SOBufferCacheNode *head);
+extern SOBufferCacheNode *searchNode (uint32_t nBlock, SOHashTable *hTable);
 
 /**
- *  \brief Insert a node in the two double-linked lists infrastructure.
+ *  \brief Insert a node in the hash table.
  *
  *  A node whose contents belongs to a block of the storage device, which is supposed not to be stored in the storage
- *  area yet, is inserted in the two double-linked lists infrastructure. If the node is already present or the storage
- *  area is inconsistent, nothing is done.
+ *  area yet, is inserted at the head of the bucket the physical block number maps to. If the node is already present,
+ *  nothing is done.
  *
  *  \param node pointer to the node to be inserted
- *  \param p_nLHead pointer to a location where the pointer to the head of the double linked list based on the physical
- *                  block number of the storage device, is stored
- *  \param p_lATLHead pointer to a location where the pointer to the head of the double-linked list based on the last
- *                    access time, is stored
- *  \param p_lATLTail pointer to a location where the pointer to the tail of the double-linked list based on the last
- *                    access time, is stored
+ *  \param hTable pointer to the hash table
  */
 
-extern void insertNode (SOBufferCacheNode *node, SOBufferCacheNode **p_nLHead, SOBufferCacheNode **p_lATLHead,
-                        SOBufferCacheNode **p_lATLTail);
+extern void insertNode (SOBufferCacheNode *node, SOHashTable *hTable);
 
 /**
- *  \brief Retrieve a node from the two double-linked lists infrastructure.
- *
- *  The node which the tail of the double-linked list based on last access time points to, is retrieved from the two
- *  double-linked lists infrastructure. If the storage area is inconsistent, nothing is done.
+ *  \brief Remove a node from the hash table.
  *
- *  \param p_nLHead pointer to a location where the pointer to the head of the double linked list based on the physical
- *                  block number of the storage device, is stored
- *  \param p_lATLHead pointer to a location where the pointer to the head of the double-linked list based on the last
- *                    access time, is stored
- *  \param p_lATLTail pointer to a location where the pointer to the tail of the double-linked list based on the last
- *                    access time, is stored
+ *  If the node is the one the iterator points to, the iterator is moved to the next node beforehand, so that it is kept
+ *  valid.
  *
- *  \return pointer to the retrieved node, or \c NULL if the storage area is empty or inconsistent
- */
-
-extern SOBufferCacheNode *retrieveNode (SOBufferCacheNode **p_nLHead, SOBufferCacheNode **p_lATLHead,
-                                        SOBufferCacheNode **p_lATLTail);
-
-/**
- *  \brief Move the node to the head of the double-linked list based on last access time.
- *
- *  The node which is supposed to have been accessed, is retrieved from its location in the double-linked list based on
- *  the last access time and placed at the head of the list. If the node pointer is \c NULL or the storage area is
- *  inconsistent, nothing is done.
- *
- *  \param node pointer to the node to be inserted
- *  \param p_lATLHead pointer to a location where the pointer to the head of the double-linked list based on the last
- *                    access time, is stored
- *  \param p_lATLTail pointer to a location where the pointer to the tail of the double-linked list based on the last
- *                    access time, is stored
+ *  \param node pointer to the node to be removed
+ *  \param hTable pointer to the hash table
  */
 
-extern void moveNodeAtHeadLAT (SOBufferCacheNode *node, SOBufferCacheNode **p_lATLHead, SOBufferCacheNode **p_lATLTail);
+extern void removeNode (SOBufferCacheNode *node, SOHashTable *hTable);
 
 #endif /* SOFS_BUFFERCACHEINTERNALS_H_ */
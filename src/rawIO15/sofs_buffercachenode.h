@@ -16,38 +16,68 @@
 /**
  *  \brief Definition of the buffercache node data type.
  *
- *  The buffercache is conceived as two double-linked lists: the first, based on the block number of the storage device
- *  it is referencing; the second, based on the order of last access to the block.
+ *  The buffercache is conceived as a hash table, whose buckets are double-linked lists, indexed by the block number of
+ *  the storage device it is referencing, and one or more double-linked lists, the queues of the replacement policy,
+ *  which keep the order of access to the blocks.
  *  So, besides the pointers which are required to implement this dynamic structure, each node contains:
- *    \li a buffer area to store locally the contents of the referenced block
- *    \li the physical block number
+ *    \li a pointer to a buffer area, taken from an aligned pool, to store locally the contents of the referenced block,
+ *        or cluster
+ *    \li the physical block number (of the first block, for a cluster)
+ *    \li the number of blocks whose contents is stored: 1 (one), for a block node, or \c BLOCKS_PER_CLUSTER, for a
+ *        cluster node
  *    \li a status flag which signals whether the block contents is, or is not, synchronized with the contents of the
- *        corresponding block in the storage device.
+ *        corresponding block in the storage device
+ *    \li the number of pins of the buffer, a pinned node being never replaced nor unassigned
+ *    \li the time the contents was changed, so that the flusher writes it back once it is old enough
+ *    \li the owner of the changes, so that the changes of a single file may be synchronized apart, and the links of
+ *        the list of changed nodes
+ *    \li the queue of the replacement policy the node belongs to.
  */
 
 typedef struct soBufferCacheNode
 {
-   /** \brief contents of the data block */
-    unsigned char buffer[BLOCK_SIZE];
-   /** \brief physical block number */
+   /** \brief contents of the data block or cluster (nBlks * BLOCK_SIZE bytes, aligned to DIRECT_ALIGN) */
+    unsigned char *buffer;
+   /** \brief physical block number (of the first block, for a cluster) */
     uint32_t n;
-   /** \brief status of the data block
-    *  \li <em>same</em> - the contents is the same as the corresponding block in the storage device
+   /** \brief number of blocks whose contents is stored (1 or BLOCKS_PER_CLUSTER) */
+    uint32_t nBlks;
+   /** \brief status of the data block or cluster
+    *  \li <em>same</em> - the contents is the same as the corresponding block(s) in the storage device
     *  \li <em>changed</em> - the contents is potentially different
+    *  \li <em>pending</em> - the contents is being read ahead from the storage device
     */
     uint32_t stat;
+   /** \brief 1 (one), if the cluster was read ahead and has not been accessed yet; 0 (zero), otherwise */
+    uint32_t ahead;
+   /** \brief number of times the buffer is pinned (see soPinCacheBlock) */
+    uint32_t pins;
+   /** \brief time the status was last marked changed, after being marked same (in milliseconds of a monotonic
+    *         clock) */
+    uint64_t changedAt;
+   /** \brief owner of the changes (an inode number), or CACHE_NO_OWNER, if the contents was changed on behalf of no
+    *         owner or of several ones (see soSetCacheOwner) */
+    uint32_t owner;
+   /** \brief double-linked list of the changed nodes: pointer to previous node */
+    struct soBufferCacheNode *dirty_prev;
+   /** \brief double-linked list of the changed nodes: pointer to next node */
+    struct soBufferCacheNode *dirty_next;
 
-   /** \brief double-linked list based on block number:
+   /** \brief double-linked list of the bucket of the hash table based on block number:
     *         pointer to previous node */
-    struct soBufferCacheNode *n_prev;
-   /** \brief double-linked list based on block number:
+    struct soBufferCacheNode *h_prev;
+   /** \brief double-linked list of the bucket of the hash table based on block number:
     *         pointer to next node */
-    struct soBufferCacheNode *n_next;
+    struct soBufferCacheNode *h_next;
 
-   /** \brief double-linked list based on last access time:
+   /** \brief 1 (one), if the node belongs to the metadata partition of its pool; 0 (zero), otherwise */
+    uint32_t meta;
+   /** \brief queue of the replacement policy the node belongs to */
+    uint32_t queue;
+   /** \brief double-linked list of the queue of the replacement policy:
     *         pointer to previous node */
     struct soBufferCacheNode *access_prev;
-   /** \brief double-linked list based on last access time:
+   /** \brief double-linked list of the queue of the replacement policy:
     *         pointer to next node */
     struct soBufferCacheNode *access_next;
 } SOBufferCacheNode;
@@ -57,5 +87,7 @@ typedef struct soBufferCacheNode
 /** \brief the contents of a block in the storage area is potentially different from the corresponding block in the
  *         storage device */
 #define CHANGED 1
+/** \brief the contents of a cluster in the storage area is being read ahead from the storage device */
+#define PENDING 2
 
 #endif /* SOFS_BUFFERCACHENODE_H_ */
@@ -0,0 +1,311 @@
+/**
+ *  \file sofs_cachepolicy.c (implementation file)
+ *
+ *  \brief Replacement policies of the buffercache.
+ *
+ *  A replacement policy keeps the nodes of the storage area which are assigned to blocks in one or more queues, and
+ *  selects the node to be replaced when no free node is available. It is told whenever a node is assigned to a block
+ *  and whenever the block stored in a node is accessed again. The queues are kept apart from the operations, so that
+ *  several sets of nodes may be managed independently by the same policy.
+ *  One should notice that this module does not stand alone: it supposes a very tight coupling with the buffercache
+ *  implementation, its only application.
+ *
+ *  The following policies are defined:
+ *    \li \c CACHE_LRU - the node that has not been accessed for the longest time is replaced
+ *    \li \c CACHE_2Q - blocks accessed only once are kept in a FIFO queue (A1in), apart from the blocks which
+ *        proved to be accessed repeatedly, kept in an LRU queue (Am), so that a long sequential scan only flushes the
+ *        FIFO queue; a block moves to the LRU queue when it is accessed again, either while it is still in the FIFO
+ *        queue or shortly after being replaced from it, the physical numbers of the blocks recently replaced from the
+ *        FIFO queue being remembered in a ghost queue (A1out) for that purpose.
+ *
+ *  The queues are double-linked lists, linked through \e access_prev and \e access_next, whose head is the most
+ *  recently inserted node. Pinned nodes stay in their queues, but are passed over when a node is selected for
+ *  replacement. The ghost queue is a ring of physical block numbers, indexed by a hash table of its own.
+ *
+ *  The following operation is defined:
+ *    \li get the operations of a replacement policy.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "sofs_buffercache.h"
+#include "sofs_buffercachenode.h"
+#include "sofs_cachepolicy.h"
+
+/** \brief queue of the LRU policy */
+#define Q_LRU    0
+/** \brief FIFO queue of the 2Q policy, of the blocks accessed only once (A1in) */
+#define Q_A1IN   1
+/** \brief LRU queue of the 2Q policy, of the blocks accessed repeatedly (Am) */
+#define Q_AM     2
+
+/*
+ *  Allusion to internal functions
+ */
+
+static void queuePush (SOQueue *q, SOBufferCacheNode *node, uint32_t id);
+static void queueUnlink (SOQueue *q, SOBufferCacheNode *node);
+static SOBufferCacheNode *queuePop (SOQueue *q);
+static int lruReset (SOCacheQueues *q, uint32_t capacity);
+static void lruRelease (SOCacheQueues *q);
+static void lruInsert (SOCacheQueues *q, SOBufferCacheNode *node);
+static void lruTouch (SOCacheQueues *q, SOBufferCacheNode *node);
+static void lruRemove (SOCacheQueues *q, SOBufferCacheNode *node);
+static SOBufferCacheNode *lruVictim (SOCacheQueues *q);
+static int twoQReset (SOCacheQueues *q, uint32_t capacity);
+static void twoQRelease (SOCacheQueues *q);
+static void twoQInsert (SOCacheQueues *q, SOBufferCacheNode *node);
+static void twoQTouch (SOCacheQueues *q, SOBufferCacheNode *node);
+static void twoQRemove (SOCacheQueues *q, SOBufferCacheNode *node);
+static SOBufferCacheNode *twoQVictim (SOCacheQueues *q);
+static void ghostAdd (SOCacheQueues *q, uint32_t n);
+static bool ghostRemove (SOCacheQueues *q, uint32_t n);
+
+/** \brief operations of the replacement policies, indexed by CACHE_* */
+static const SOCachePolicy policies[] =
+{
+  { "lru", lruReset, lruRelease, lruInsert, lruTouch, lruRemove, lruVictim },
+  { "2q", twoQReset, twoQRelease, twoQInsert, twoQTouch, twoQRemove, twoQVictim }
+};
+
+/**
+ *  \brief Get the operations of a replacement policy.
+ *
+ *  \param policy replacement policy (\c CACHE_LRU or \c CACHE_2Q)
+ *
+ *  \return pointer to the operations of the policy, or \c NULL if the policy is invalid
+ */
+
+const SOCachePolicy *getCachePolicy (uint32_t policy)
+{
+  if (policy >= sizeof (policies) / sizeof (policies[0])) return NULL;
+
+  return &policies[policy];
+}
+
+/*
+ *  LRU policy: a single queue (a1in), the accessed nodes being moved to its head
+ */
+
+static int lruReset (SOCacheQueues *q, uint32_t capacity)
+{
+  (void) capacity;                               /* a single queue holds the nodes, whatever their number */
+
+  memset (q, 0, sizeof (SOCacheQueues));
+
+  return 0;
+}
+
+static void lruRelease (SOCacheQueues *q)
+{
+  memset (q, 0, sizeof (SOCacheQueues));
+}
+
+static void lruInsert (SOCacheQueues *q, SOBufferCacheNode *node)
+{
+  queuePush (&q->a1in, node, Q_LRU);
+}
+
+static void lruTouch (SOCacheQueues *q, SOBufferCacheNode *node)
+{
+  if (q->a1in.head == node) return;              /* the node is already at the head */
+
+  queueUnlink (&q->a1in, node);
+  queuePush (&q->a1in, node, Q_LRU);
+}
+
+static void lruRemove (SOCacheQueues *q, SOBufferCacheNode *node)
+{
+  queueUnlink (&q->a1in, node);
+}
+
+static SOBufferCacheNode *lruVictim (SOCacheQueues *q)
+{
+  return queuePop (&q->a1in);
+}
+
+/*
+ *  2Q policy: A1in is kept down to a quarter of the nodes, while Am is not empty, and the ghost queue remembers half as
+ *  many blocks as there are nodes
+ */
+
+static int twoQReset (SOCacheQueues *q, uint32_t capacity)
+{
+  uint32_t nBuckets;                             /* number of buckets of the hash table of the ghost queue */
+  uint32_t i;
+
+  twoQRelease (q);
+  q->kIn = (capacity >= 4) ? capacity / 4 : 1;
+  q->kOut = (capacity >= 2) ? capacity / 2 : 1;
+  for (nBuckets = 1; nBuckets < q->kOut; nBuckets <<= 1) ;
+  if (((q->ghost = malloc (q->kOut * sizeof (SOGhost))) == NULL) ||
+      ((q->ghostHead = malloc (nBuckets * sizeof (int32_t))) == NULL))
+     { twoQRelease (q);
+       return -ENOMEM;
+     }
+  for (i = 0; i < q->kOut; i++)
+  { q->ghost[i].n = GHOST_NONE;
+    q->ghost[i].next = -1;
+  }
+  for (i = 0; i < nBuckets; i++)
+    q->ghostHead[i] = -1;
+  q->ghostMask = nBuckets - 1;
+
+  return 0;
+}
+
+static void twoQRelease (SOCacheQueues *q)
+{
+  free (q->ghost);
+  free (q->ghostHead);
+  memset (q, 0, sizeof (SOCacheQueues));
+}
+
+static void twoQInsert (SOCacheQueues *q, SOBufferCacheNode *node)
+{
+  if (ghostRemove (q, node->n))                  /* the block was accessed again shortly after being replaced */
+     queuePush (&q->am, node, Q_AM);
+     else queuePush (&q->a1in, node, Q_A1IN);
+}
+
+static void twoQTouch (SOCacheQueues *q, SOBufferCacheNode *node)
+{
+  if (q->am.head == node) return;                /* the node is already at the head */
+
+  queueUnlink ((node->queue == Q_AM) ? &q->am : &q->a1in, node);
+  queuePush (&q->am, node, Q_AM);
+}
+
+static void twoQRemove (SOCacheQueues *q, SOBufferCacheNode *node)
+{
+  queueUnlink ((node->queue == Q_AM) ? &q->am : &q->a1in, node);
+}
+
+static SOBufferCacheNode *twoQVictim (SOCacheQueues *q)
+{
+  SOBufferCacheNode *node;                       /* node to be replaced */
+  bool a1inFirst = (q->a1in.size > q->kIn) || (q->am.size == 0);  /* A1in is preferred */
+
+  if (a1inFirst && ((node = queuePop (&q->a1in)) != NULL))
+     { ghostAdd (q, node->n);
+       return node;
+     }
+  if ((node = queuePop (&q->am)) != NULL) return node;
+  if (!a1inFirst && ((node = queuePop (&q->a1in)) != NULL))   /* every node of Am is pinned */
+     { ghostAdd (q, node->n);
+       return node;
+     }
+
+  return NULL;
+}
+
+/**
+ *  \brief Insert a node at the head of a queue.
+ *
+ *  \param q pointer to the queue
+ *  \param node pointer to the node
+ *  \param id identification of the queue, recorded in the node
+ */
+
+static void queuePush (SOQueue *q, SOBufferCacheNode *node, uint32_t id)
+{
+  node->queue = id;
+  node->access_prev = NULL;
+  node->access_next = q->head;
+  if (q->head != NULL)
+     q->head->access_prev = node;
+     else q->tail = node;
+  q->head = node;
+  q->size += 1;
+}
+
+/**
+ *  \brief Unlink a node from a queue.
+ *
+ *  \param q pointer to the queue
+ *  \param node pointer to the node
+ */
+
+static void queueUnlink (SOQueue *q, SOBufferCacheNode *node)
+{
+  if (node->access_prev != NULL)
+     node->access_prev->access_next = node->access_next;
+     else q->head = node->access_next;
+  if (node->access_next != NULL)
+     node->access_next->access_prev = node->access_prev;
+     else q->tail = node->access_prev;
+  node->access_prev = node->access_next = NULL;
+  q->size -= 1;
+}
+
+/**
+ *  \brief Remove the node nearest to the tail of a queue which is not pinned.
+ *
+ *  \param q pointer to the queue
+ *
+ *  \return pointer to the node, or \c NULL if the queue is empty or all its nodes are pinned
+ */
+
+static SOBufferCacheNode *queuePop (SOQueue *q)
+{
+  SOBufferCacheNode *node;                       /* node to be removed */
+
+  for (node = q->tail; (node != NULL) && (node->pins != 0); node = node->access_prev) ;
+  if (node != NULL) queueUnlink (q, node);
+
+  return node;
+}
+
+/**
+ *  \brief Remember the physical number of a block replaced from A1in in the ghost queue.
+ *
+ *  Once the ring is full, the oldest block number is forgotten.
+ *
+ *  \param q pointer to the queues
+ *  \param n physical block number
+ */
+
+static void ghostAdd (SOCacheQueues *q, uint32_t n)
+{
+  SOGhost *slot = &q->ghost[q->ghostPos];        /* slot to be filled */
+  int32_t *p_head;                               /* head of the bucket the block number maps to */
+
+  if (slot->n != GHOST_NONE) ghostRemove (q, slot->n);
+  p_head = &q->ghostHead[(n * 2654435761u) & q->ghostMask];
+  slot->n = n;
+  slot->next = *p_head;
+  *p_head = q->ghostPos;
+  q->ghostPos = (q->ghostPos + 1) % q->kOut;
+}
+
+/**
+ *  \brief Forget the physical number of a block, if it is in the ghost queue.
+ *
+ *  \param q pointer to the queues
+ *  \param n physical block number
+ *
+ *  \return \c true, if the block number was in the ghost queue; \c false, otherwise
+ */
+
+static bool ghostRemove (SOCacheQueues *q, uint32_t n)
+{
+  int32_t *p_link;                               /* link to the slot under inspection */
+
+  if (q->ghost == NULL) return false;
+  for (p_link = &q->ghostHead[(n * 2654435761u) & q->ghostMask]; *p_link != -1; p_link = &q->ghost[*p_link].next)
+    if (q->ghost[*p_link].n == n)
+       { int32_t i = *p_link;
+
+         *p_link = q->ghost[i].next;
+         q->ghost[i].n = GHOST_NONE;
+         q->ghost[i].next = -1;
+         return true;
+       }
+
+  return false;
+}
@@ -0,0 +1,121 @@
+/**
+ *  \file sofs_cachepolicy.h (interface file)
+ *
+ *  \brief Replacement policies of the buffercache.
+ *
+ *  A replacement policy keeps the nodes of the storage area which are assigned to blocks in one or more queues, and
+ *  selects the node to be replaced when no free node is available. It is told whenever a node is assigned to a block
+ *  and whenever the block stored in a node is accessed again. The queues are kept apart from the operations, so that
+ *  several sets of nodes may be managed independently by the same policy.
+ *  One should notice that this module does not stand alone: it supposes a very tight coupling with the buffercache
+ *  implementation, its only application.
+ *
+ *  The following policies are defined:
+ *    \li \c CACHE_LRU - the node that has not been accessed for the longest time is replaced
+ *    \li \c CACHE_2Q - blocks accessed only once are kept in a FIFO queue, apart from the blocks which proved to be
+ *        accessed repeatedly, kept in an LRU queue, so that a long sequential scan only flushes the FIFO queue; a
+ *        block moves to the LRU queue when it is accessed again, either while it is still in the FIFO queue or shortly
+ *        after being replaced from it, the physical numbers of the blocks recently replaced from the FIFO queue being
+ *        remembered in a ghost queue for that purpose.
+ *
+ *  The following operation is defined:
+ *    \li get the operations of a replacement policy.
+ */
+
+#ifndef SOFS_CACHEPOLICY_H_
+#define SOFS_CACHEPOLICY_H_
+
+#include <stdint.h>
+
+#include "sofs_buffercachenode.h"
+
+/** \brief empty slot of the ghost queue */
+#define GHOST_NONE  ((uint32_t) (~0UL))
+
+/**
+ *  \brief Definition of a queue of nodes.
+ */
+
+typedef struct soQueue
+{
+   /** \brief most recently inserted node */
+    SOBufferCacheNode *head;
+   /** \brief least recently inserted node */
+    SOBufferCacheNode *tail;
+   /** \brief number of nodes */
+    uint32_t size;
+} SOQueue;
+
+/**
+ *  \brief Definition of a slot of the ghost queue of the 2Q policy.
+ */
+
+typedef struct soGhost
+{
+   /** \brief physical block number (GHOST_NONE, if the slot is empty) */
+    uint32_t n;
+   /** \brief index of the next slot of the same bucket of the hash table (-1, if none) */
+    int32_t next;
+} SOGhost;
+
+/**
+ *  \brief Definition of the queues kept by a replacement policy for a set of nodes.
+ *
+ *  Each set of nodes managed apart (a pool of nodes of the storage area) has queues of its own.
+ */
+
+typedef struct soCacheQueues
+{
+   /** \brief queue of the LRU policy, or FIFO queue of the 2Q policy (A1in) */
+    SOQueue a1in;
+   /** \brief LRU queue of the 2Q policy (Am) */
+    SOQueue am;
+   /** \brief maximum number of nodes of A1in before its nodes are preferred for replacement */
+    uint32_t kIn;
+   /** \brief ring of the ghost queue (A1out) */
+    SOGhost *ghost;
+   /** \brief heads of the buckets of the hash table of the ghost queue */
+    int32_t *ghostHead;
+   /** \brief number of slots of the ghost queue */
+    uint32_t kOut;
+   /** \brief number of buckets of the hash table of the ghost queue, minus one (a power of two, minus one) */
+    uint32_t ghostMask;
+   /** \brief slot of the ghost queue to be filled next (the oldest one, once the ring is full) */
+    uint32_t ghostPos;
+} SOCacheQueues;
+
+/**
+ *  \brief Definition of the operations of a replacement policy.
+ */
+
+typedef struct soCachePolicy
+{
+   /** \brief name of the policy */
+    const char *name;
+   /** \brief empty the queues, which are to hold up to \e capacity nodes; returns <tt>0 (zero)</tt>, on success,
+    *         or -\c ENOMEM, if there is no memory for the internal data structures */
+    int (*reset) (SOCacheQueues *q, uint32_t capacity);
+   /** \brief release the internal data structures of the queues */
+    void (*release) (SOCacheQueues *q);
+   /** \brief a node was assigned to a block: insert it in a queue */
+    void (*insert) (SOCacheQueues *q, SOBufferCacheNode *node);
+   /** \brief the block stored in a node was accessed again */
+    void (*touch) (SOCacheQueues *q, SOBufferCacheNode *node);
+   /** \brief a node is no longer assigned to a block: remove it from its queue */
+    void (*remove) (SOCacheQueues *q, SOBufferCacheNode *node);
+   /** \brief select the node to be replaced, among the nodes which are not pinned, and remove it from its queue;
+    *         returns \c NULL, if the queues are empty or all their nodes are pinned */
+    SOBufferCacheNode *(*victim) (SOCacheQueues *q);
+} SOCachePolicy;
+
+/**
+ *  \brief Get the operations of a replacement policy.
+ *
+ *  \param policy replacement policy (\c CACHE_LRU or \c CACHE_2Q)
+ *
+ *  \return pointer to the operations of the policy, or \c NULL if the policy is invalid
+ */
+
+extern const SOCachePolicy *getCachePolicy (uint32_t policy);
+
+#endif /* SOFS_CACHEPOLICY_H_ */
@@ -0,0 +1,617 @@
+/**
+ *  \file sofs_rawasync.c (implementation file)
+ *
+ *  \brief Asynchronous access to raw disk blocks and clusters.
+ *
+ *  The asynchronous engine shares the communication channel established with the storage device by the raw disk
+ *  module (see sofs_rawdisk.h). Transfers of blocks and clusters are submitted and proceed while the caller goes on;
+ *  their completion is collected later, identified by a tag supplied on submission.
+ *  The number of transfers that may simultaneously be in flight (the queue depth) is fixed when the engine is started.
+ *
+ *  The engine is run by the Linux \e io_uring interface, accessed directly through its system calls. Whenever this
+ *  interface is not available, or a synchronous engine is explicitly required, the transfers are carried out by the raw
+ *  disk module at submission time and only their completion is deferred.
+ *
+ *  The following operations are defined:
+ *    \li start the asynchronous engine on the storage device
+ *    \li stop the asynchronous engine, waiting for the transfers in flight
+ *    \li get the type of the asynchronous engine which is running
+ *    \li submit the transfer of a block of data from / to the storage device
+ *    \li submit the transfer of a cluster of data from / to the storage device
+ *    \li collect the completion of a transfer previously submitted.
+ *
+ *  \remarks Submission and collection of completions may be carried out by different threads.
+ */
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <linux/io_uring.h>
+
+#undef BLOCK_SIZE                                /* defined by the kernel headers with a different meaning */
+
+#include "sofs_const.h"
+#include "sofs_probe.h"
+#include "sofs_rawdisk.h"
+#include "sofs_rawdiskinternals.h"
+#include "sofs_rawstats.h"
+#include "sofs_rawasync.h"
+
+/**
+ *  \brief Definition of the in flight transfer data type.
+ *
+ *  The descriptor of the memory area must remain valid until the transfer is completed.
+ */
+
+typedef struct soAsyncSlot
+{
+   /** \brief descriptor of the memory area of the transfer */
+    struct iovec iov;
+   /** \brief value that identifies the transfer on completion */
+    uint64_t tag;
+   /** \brief status of the transfer (synchronous engine only) */
+    int stat;
+   /** \brief operation the transfer is accounted for as (RAWOP_*, io_uring engine only) */
+    uint32_t op;
+   /** \brief physical number of the first block of the transfer (io_uring engine only) */
+    uint32_t n;
+   /** \brief value of the clock when the transfer was submitted (io_uring engine only) */
+    uint64_t t0;
+} SOAsyncSlot;
+
+/*
+ *  Internal data structure
+ */
+
+/** \brief type of the engine: -1 - stopped, ASYNC_NATIVE - io_uring, ASYNC_SYNC - synchronous */
+static int engType = -1;
+/** \brief queue depth */
+static uint32_t qDepth = 0;
+/** \brief number of transfers in flight (submitted, but whose completion was not collected yet) */
+static uint32_t inFlight = 0;
+/** \brief storage area for the transfers in flight (io_uring engine) or circular FIFO of the completed transfers
+ *         (synchronous engine) */
+static SOAsyncSlot *slot = NULL;
+/** \brief stack of the indices of the free elements of the storage area (io_uring engine) */
+static uint32_t *slotIdx = NULL;
+/** \brief number of elements of the stack of free indices / index of the first element of the FIFO of completions */
+static uint32_t slotTop = 0;
+/** \brief number of elements of the FIFO of completions (synchronous engine) */
+static uint32_t nDone = 0;
+/** \brief access with mutual exclusion to the submission side */
+static pthread_mutex_t sqAccess = PTHREAD_MUTEX_INITIALIZER;
+/** \brief access with mutual exclusion to the completion side */
+static pthread_mutex_t cqAccess = PTHREAD_MUTEX_INITIALIZER;
+/** \brief signaling of the availability of a completion (synchronous engine) */
+static pthread_cond_t cqReady = PTHREAD_COND_INITIALIZER;
+
+/** \brief file descriptor of the io_uring instance */
+static int ringFd = -1;
+/** \brief mapping of the submission queue ring */
+static void *sqRing = MAP_FAILED;
+/** \brief size of the mapping of the submission queue ring */
+static size_t sqRingSize = 0;
+/** \brief mapping of the completion queue ring (it may coincide with the submission queue ring) */
+static void *cqRing = MAP_FAILED;
+/** \brief size of the mapping of the completion queue ring */
+static size_t cqRingSize = 0;
+/** \brief mapping of the array of submission queue entries */
+static struct io_uring_sqe *sqes = MAP_FAILED;
+/** \brief size of the mapping of the array of submission queue entries */
+static size_t sqesSize = 0;
+/** \brief pointers to the fields of the submission queue ring */
+static unsigned *sqHead, *sqTail, *sqMask, *sqArray;
+/** \brief pointers to the fields of the completion queue ring */
+static unsigned *cqHead, *cqTail, *cqMask;
+/** \brief array of completion queue entries */
+static struct io_uring_cqe *cqes;
+
+/*
+ *  Allusion to internal functions
+ */
+
+static int setupRing (uint32_t depth);
+static void teardownRing (void);
+static int submit (uint32_t op, uint32_t n, void *buf, size_t count, uint64_t tag);
+static int submitNative (int fd, uint32_t op, uint32_t n, void *buf, size_t count, uint64_t tag);
+static int submitSync (uint32_t op, uint32_t n, void *buf, size_t count, uint64_t tag);
+static int reapNative (bool wait, uint64_t *p_tag, int *p_stat);
+static int reapSync (bool wait, uint64_t *p_tag, int *p_stat);
+
+/**
+ *  \brief Start the asynchronous engine on the storage device.
+ *
+ *  The storage device must have been previously opened by the raw disk module.
+ *  If the type of engine is \c ASYNC_NATIVE, an \e io_uring instance is set up; when that is not possible, or the
+ *  device is striped over several supporting files, a synchronous engine is started instead. If it is \c ASYNC_SYNC,
+ *  a synchronous engine is always started.
+ *
+ *  \param depth maximum number of transfers simultaneously in flight
+ *  \param type type of the engine that is required (\c ASYNC_NATIVE or \c ASYNC_SYNC)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>queue depth</em> is zero or greater than \c ASYNC_MAX_DEPTH, or the <em>type</em> is
+ *                      invalid
+ *  \return -\c EBUSY, if the engine is already started
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOMEM, if there is no memory for the internal data structures
+ */
+
+int soOpenAsyncEngine (uint32_t depth, uint32_t type)
+{
+  soColorProbe (881, "07;31", "soOpenAsyncEngine(%"PRIu32", %"PRIu32")\n", depth, type);
+
+  int fd;                                        /* file descriptor of the supporting file */
+  uint32_t bnmax;                                /* number of blocks of the storage device */
+  uint32_t i;
+  int stat;                                      /* status of operation */
+
+  if ((depth == 0) || (depth > ASYNC_MAX_DEPTH) || ((type != ASYNC_NATIVE) && (type != ASYNC_SYNC)))
+     return -EINVAL;
+  if (engType != -1) return -EBUSY;              /* checking for engine started state */
+  if ((stat = soGetRawDevice (&fd, &bnmax)) != 0) return stat;
+
+  if (((slot = calloc (depth, sizeof (SOAsyncSlot))) == NULL) ||
+      ((slotIdx = calloc (depth, sizeof (uint32_t))) == NULL))
+     { free (slot);
+       slot = NULL;
+       return -ENOMEM;
+     }
+
+  qDepth = depth;
+  inFlight = 0;
+  if ((type == ASYNC_NATIVE) && (fd != -1) && (setupRing (depth) == 0))
+     { for (i = 0; i < depth; i++)               /* all elements of the storage area are free */
+         slotIdx[i] = depth - 1 - i;
+       slotTop = depth;
+       engType = ASYNC_NATIVE;
+     }
+     else { slotTop = nDone = 0;                 /* the FIFO of completions is empty */
+            engType = ASYNC_SYNC;
+          }
+
+  return 0;
+}
+
+/**
+ *  \brief Stop the asynchronous engine, waiting for the transfers in flight.
+ *
+ *  The completions which were not yet collected are discarded.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the engine is not started
+ */
+
+int soCloseAsyncEngine (void)
+{
+  soColorProbe (882, "07;31", "soCloseAsyncEngine()\n");
+
+  uint64_t tag;                                  /* tag of a discarded completion */
+  int stat;                                      /* status of a discarded completion */
+
+  if (engType == -1) return -EBADF;              /* checking for engine stopped state */
+
+  while (soReapRawCompletion (true, &tag, &stat) == 0) ;
+
+  if (engType == ASYNC_NATIVE) teardownRing ();
+  free (slot);
+  free (slotIdx);
+  slot = NULL;
+  slotIdx = NULL;
+  qDepth = inFlight = slotTop = nDone = 0;
+  engType = -1;
+
+  return 0;
+}
+
+/**
+ *  \brief Get the type of the asynchronous engine which is running.
+ *
+ *  \return \c ASYNC_NATIVE, if the engine is run by the io_uring interface
+ *  \return \c ASYNC_SYNC, if the engine is synchronous
+ *  \return -\c EBADF, if the engine is not started
+ */
+
+int soGetAsyncEngineType (void)
+{
+  soColorProbe (883, "07;31", "soGetAsyncEngineType()\n");
+
+  if (engType == -1) return -EBADF;              /* checking for engine stopped state */
+
+  return engType;
+}
+
+/**
+ *  \brief Submit the transfer of a block of data from / to the storage device.
+ *
+ *  The buffer must remain valid, and unchanged in case of a write, until the completion of the transfer is collected.
+ *
+ *  \param op direction of the transfer (\c ASYNC_READ or \c ASYNC_WRITE)
+ *  \param n physical number of the data block
+ *  \param buf pointer to the buffer where the data must be read into / written from
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>direction</em> is invalid, the <em>buffer pointer</em> is \c NULL or the
+ *                      <em>block number</em> is out of range, or the buffer is not aligned to \c DIRECT_ALIGN while
+ *                      the device is in \c DEV_DIRECT mode and the engine is run by the io_uring interface
+ *  \return -\c EBADF, if the engine is not started or the device is not already opened
+ *  \return -\c EAGAIN, if the queue is full (some completions must be collected first)
+ *  \return -<em>other specific error</em> issued by \e io_uring_enter system call
+ */
+
+int soSubmitRawBlock (uint32_t op, uint32_t n, void *buf, uint64_t tag)
+{
+  soColorProbe (884, "07;31", "soSubmitRawBlock(%"PRIu32", %"PRIu32", %p, %"PRIu64")\n", op, n, buf, tag);
+
+  return submit (op, n, buf, BLOCK_SIZE, tag);
+}
+
+/**
+ *  \brief Submit the transfer of a cluster of data from / to the storage device.
+ *
+ *  The buffer must remain valid, and unchanged in case of a write, until the completion of the transfer is collected.
+ *
+ *  \param op direction of the transfer (\c ASYNC_READ or \c ASYNC_WRITE)
+ *  \param n physical number of the first block of the data cluster
+ *  \param buf pointer to the buffer where the data must be read into / written from
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>direction</em> is invalid, the <em>buffer pointer</em> is \c NULL or the
+ *                      <em>block number</em> is out of range, or the buffer is not aligned to \c DIRECT_ALIGN while
+ *                      the device is in \c DEV_DIRECT mode and the engine is run by the io_uring interface
+ *  \return -\c EBADF, if the engine is not started or the device is not already opened
+ *  \return -\c EAGAIN, if the queue is full (some completions must be collected first)
+ *  \return -<em>other specific error</em> issued by \e io_uring_enter system call
+ */
+
+int soSubmitRawCluster (uint32_t op, uint32_t n, void *buf, uint64_t tag)
+{
+  soColorProbe (885, "07;31", "soSubmitRawCluster(%"PRIu32", %"PRIu32", %p, %"PRIu64")\n", op, n, buf, tag);
+
+  return submit (op, n, buf, CLUSTER_SIZE, tag);
+}
+
+/**
+ *  \brief Collect the completion of a transfer previously submitted.
+ *
+ *  Completions are not necessarily collected in the order of submission.
+ *
+ *  \param wait \c true, if the caller is to be blocked until a completion is available; \c false, otherwise
+ *  \param p_tag pointer to a location where the tag of the completed transfer is to be stored
+ *  \param p_stat pointer to a location where the status of the completed transfer is to be stored (<tt>0 (zero)</tt>,
+ *                on success, -\c EIO, if it was incomplete, or -<em>other specific error</em> issued by the transfer)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the pointers is \c NULL
+ *  \return -\c EBADF, if the engine is not started
+ *  \return -\c EAGAIN, if the caller is not to be blocked and no completion is available yet
+ *  \return -\c ENOENT, if there are no transfers in flight
+ *  \return -<em>other specific error</em> issued by \e io_uring_enter system call
+ */
+
+int soReapRawCompletion (bool wait, uint64_t *p_tag, int *p_stat)
+{
+  soColorProbe (886, "07;31", "soReapRawCompletion(%d, %p, %p)\n", wait, p_tag, p_stat);
+
+  int stat;                                      /* status of operation */
+
+  if ((p_tag == NULL) || (p_stat == NULL)) return -EINVAL;  /* checking for null pointers */
+  if (engType == -1) return -EBADF;              /* checking for engine stopped state */
+
+  if (pthread_mutex_lock (&cqAccess) != 0) return -ENOLCK;
+  if (__atomic_load_n (&inFlight, __ATOMIC_ACQUIRE) == 0)
+     stat = -ENOENT;
+     else if (engType == ASYNC_NATIVE)
+             stat = reapNative (wait, p_tag, p_stat);
+             else stat = reapSync (wait, p_tag, p_stat);
+  pthread_mutex_unlock (&cqAccess);
+
+  return stat;
+}
+
+/**
+ *  \brief Set up an io_uring instance on the storage device.
+ *
+ *  \param depth number of entries of the submission queue
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by \e io_uring_setup or \e mmap system calls
+ */
+
+static int setupRing (uint32_t depth)
+{
+  struct io_uring_params p;                      /* parameters of the io_uring instance */
+  int stat;                                      /* status of operation */
+
+  memset (&p, 0, sizeof (p));
+  if ((ringFd = syscall (__NR_io_uring_setup, depth, &p)) < 0)
+     { stat = -errno;
+       ringFd = -1;
+       return stat;
+     }
+
+  /* map the rings and the array of submission queue entries */
+
+  sqRingSize = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+  cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+  if ((p.features & IORING_FEAT_SINGLE_MMAP) && (cqRingSize > sqRingSize))
+     sqRingSize = cqRingSize;
+  sqRing = mmap (NULL, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED)
+     { stat = -errno;
+       teardownRing ();
+       return stat;
+     }
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+     cqRing = sqRing;
+     else { cqRing = mmap (NULL, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                           IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED)
+               { stat = -errno;
+                 teardownRing ();
+                 return stat;
+               }
+          }
+  sqesSize = p.sq_entries * sizeof (struct io_uring_sqe);
+  sqes = mmap (NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+     { stat = -errno;
+       teardownRing ();
+       return stat;
+     }
+
+  sqHead = (unsigned *) ((char *) sqRing + p.sq_off.head);
+  sqTail = (unsigned *) ((char *) sqRing + p.sq_off.tail);
+  sqMask = (unsigned *) ((char *) sqRing + p.sq_off.ring_mask);
+  sqArray = (unsigned *) ((char *) sqRing + p.sq_off.array);
+  cqHead = (unsigned *) ((char *) cqRing + p.cq_off.head);
+  cqTail = (unsigned *) ((char *) cqRing + p.cq_off.tail);
+  cqMask = (unsigned *) ((char *) cqRing + p.cq_off.ring_mask);
+  cqes = (struct io_uring_cqe *) ((char *) cqRing + p.cq_off.cqes);
+
+  return 0;
+}
+
+/**
+ *  \brief Release the io_uring instance and its mappings.
+ */
+
+static void teardownRing (void)
+{
+  if (sqes != MAP_FAILED) munmap (sqes, sqesSize);
+  if ((cqRing != MAP_FAILED) && (cqRing != sqRing)) munmap (cqRing, cqRingSize);
+  if (sqRing != MAP_FAILED) munmap (sqRing, sqRingSize);
+  if (ringFd != -1) close (ringFd);
+  sqes = MAP_FAILED;
+  sqRing = cqRing = MAP_FAILED;
+  sqesSize = sqRingSize = cqRingSize = 0;
+  ringFd = -1;
+}
+
+/**
+ *  \brief Check the arguments of a submission and hand it to the engine which is running.
+ *
+ *  \param op direction of the transfer
+ *  \param n physical number of the first block
+ *  \param buf pointer to the buffer
+ *  \param count number of bytes to be transferred
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success, or a negative error code
+ */
+
+static int submit (uint32_t op, uint32_t n, void *buf, size_t count, uint64_t tag)
+{
+  int fd;                                        /* file descriptor of the supporting file */
+  uint32_t bnmax;                                /* number of blocks of the storage device */
+  int stat;                                      /* status of operation */
+
+  if (((op != ASYNC_READ) && (op != ASYNC_WRITE)) || (buf == NULL)) return -EINVAL;
+  if (engType == -1) return -EBADF;              /* checking for engine stopped state */
+  if ((stat = soGetRawDevice (&fd, &bnmax)) != 0) return stat;
+  if (((uint64_t) n + count / BLOCK_SIZE) > bnmax) return -EINVAL;     /* checking for block number */
+  if ((engType == ASYNC_NATIVE) && (soGetRawDeviceMode () == DEV_DIRECT) && (((uintptr_t) buf % DIRECT_ALIGN) != 0))
+     return -EINVAL;                             /* checking for buffer alignment in direct I/O mode */
+
+  if (engType == ASYNC_NATIVE)
+     return submitNative (fd, op, n, buf, count, tag);
+     else return submitSync (op, n, buf, count, tag);
+}
+
+/**
+ *  \brief Submit a transfer to the io_uring instance.
+ *
+ *  The transfer is accounted for in the statistics of the raw disk module (see sofs_rawstats.h) when it is completed,
+ *  as a read or a write of a block or a cluster taking the time from its submission to its completion.
+ *
+ *  \param fd file descriptor of the supporting file
+ *  \param op direction of the transfer
+ *  \param n physical number of the first block
+ *  \param buf pointer to the buffer
+ *  \param count number of bytes to be transferred
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success, or a negative error code
+ */
+
+static int submitNative (int fd, uint32_t op, uint32_t n, void *buf, size_t count, uint64_t tag)
+{
+  struct io_uring_sqe *sqe;                      /* submission queue entry */
+  uint32_t idx;                                  /* index of the element of the storage area */
+  unsigned tail;                                 /* tail of the submission queue */
+  int stat;                                      /* status of operation */
+
+  if (pthread_mutex_lock (&sqAccess) != 0) return -ENOLCK;
+  if (slotTop == 0)                              /* the queue is full */
+     { pthread_mutex_unlock (&sqAccess);
+       return -EAGAIN;
+     }
+  idx = slotIdx[--slotTop];
+  slot[idx].iov.iov_base = buf;
+  slot[idx].iov.iov_len = count;
+  slot[idx].tag = tag;
+  if (count == BLOCK_SIZE)
+     slot[idx].op = (op == ASYNC_READ) ? RAWOP_READ_BLOCK : RAWOP_WRITE_BLOCK;
+     else slot[idx].op = (op == ASYNC_READ) ? RAWOP_READ_CLUSTER : RAWOP_WRITE_CLUSTER;
+  slot[idx].n = n;
+  slot[idx].t0 = soRawStatsClock ();
+
+  /* fill in the submission queue entry and make it visible to the kernel */
+
+  tail = *sqTail;
+  sqe = &sqes[tail & *sqMask];
+  memset (sqe, 0, sizeof (*sqe));
+  sqe->opcode = (op == ASYNC_READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+  sqe->fd = fd;
+  sqe->off = (uint64_t) BLOCK_SIZE * n;
+  sqe->addr = (uint64_t) (uintptr_t) &slot[idx].iov;
+  sqe->len = 1;
+  sqe->user_data = idx;
+  sqArray[tail & *sqMask] = tail & *sqMask;
+  __atomic_store_n (sqTail, tail + 1, __ATOMIC_RELEASE);
+  __atomic_add_fetch (&inFlight, 1, __ATOMIC_RELEASE);
+
+  while ((stat = syscall (__NR_io_uring_enter, ringFd, 1, 0, 0, NULL, 0)) < 0)
+    if (errno != EINTR) break;
+  if (stat < 0)
+     { stat = -errno;                            /* the entry was not consumed: take it back */
+       __atomic_store_n (sqTail, tail, __ATOMIC_RELEASE);
+       __atomic_sub_fetch (&inFlight, 1, __ATOMIC_RELEASE);
+       soRawStatsRecord (slot[idx].op, n, count / BLOCK_SIZE, slot[idx].t0, stat);
+       slotIdx[slotTop++] = idx;
+       pthread_mutex_unlock (&sqAccess);
+       return stat;
+     }
+  pthread_mutex_unlock (&sqAccess);
+
+  return 0;
+}
+
+/**
+ *  \brief Carry out a transfer synchronously and defer its completion.
+ *
+ *  \param op direction of the transfer
+ *  \param n physical number of the first block
+ *  \param buf pointer to the buffer
+ *  \param count number of bytes to be transferred
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success, or a negative error code
+ */
+
+static int submitSync (uint32_t op, uint32_t n, void *buf, size_t count, uint64_t tag)
+{
+  uint32_t idx;                                  /* index of the element of the storage area */
+  int stat;                                      /* status of the transfer */
+
+  if (pthread_mutex_lock (&sqAccess) != 0) return -ENOLCK;
+  if (__atomic_load_n (&inFlight, __ATOMIC_ACQUIRE) == qDepth)   /* the queue is full */
+     { pthread_mutex_unlock (&sqAccess);
+       return -EAGAIN;
+     }
+  __atomic_add_fetch (&inFlight, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&sqAccess);
+
+  if (count == BLOCK_SIZE)
+     stat = (op == ASYNC_READ) ? soReadRawBlock (n, buf) : soWriteRawBlock (n, buf);
+     else stat = (op == ASYNC_READ) ? soReadRawCluster (n, buf) : soWriteRawCluster (n, buf);
+
+  /* append the completion to the FIFO */
+
+  pthread_mutex_lock (&cqAccess);
+  idx = (slotTop + nDone) % qDepth;
+  slot[idx].tag = tag;
+  slot[idx].stat = stat;
+  nDone += 1;
+  pthread_cond_signal (&cqReady);
+  pthread_mutex_unlock (&cqAccess);
+
+  return 0;
+}
+
+/**
+ *  \brief Collect a completion from the io_uring instance.
+ *
+ *  It is supposed that the caller holds the access to the completion side and that there are transfers in flight.
+ *
+ *  \param wait \c true, if the caller is to be blocked until a completion is available
+ *  \param p_tag pointer to a location where the tag of the completed transfer is to be stored
+ *  \param p_stat pointer to a location where the status of the completed transfer is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success, or a negative error code
+ */
+
+static int reapNative (bool wait, uint64_t *p_tag, int *p_stat)
+{
+  struct io_uring_cqe *cqe;                      /* completion queue entry */
+  unsigned head;                                 /* head of the completion queue */
+  uint32_t idx;                                  /* index of the element of the storage area */
+
+  head = *cqHead;
+  while (head == __atomic_load_n (cqTail, __ATOMIC_ACQUIRE))
+  { if (!wait) return -EAGAIN;
+    if ((syscall (__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (errno != EINTR))
+       return -errno;
+  }
+
+  cqe = &cqes[head & *cqMask];
+  idx = (uint32_t) cqe->user_data;
+  *p_tag = slot[idx].tag;
+  if (cqe->res < 0)
+     *p_stat = cqe->res;
+     else *p_stat = ((size_t) cqe->res == slot[idx].iov.iov_len) ? 0 : -EIO;
+  __atomic_store_n (cqHead, head + 1, __ATOMIC_RELEASE);
+  soRawStatsRecord (slot[idx].op, slot[idx].n, slot[idx].iov.iov_len / BLOCK_SIZE, slot[idx].t0, *p_stat);
+
+  /* release the element of the storage area */
+
+  pthread_mutex_lock (&sqAccess);
+  slotIdx[slotTop++] = idx;
+  __atomic_sub_fetch (&inFlight, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&sqAccess);
+
+  return 0;
+}
+
+/**
+ *  \brief Collect a completion from the FIFO of the synchronous engine.
+ *
+ *  It is supposed that the caller holds the access to the completion side and that there are transfers in flight.
+ *  A transfer is in flight, but not yet in the FIFO, while it is being carried out by the thread that submitted it.
+ *
+ *  \param wait \c true, if the caller is to be blocked until a completion is available
+ *  \param p_tag pointer to a location where the tag of the completed transfer is to be stored
+ *  \param p_stat pointer to a location where the status of the completed transfer is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success, or a negative error code
+ */
+
+static int reapSync (bool wait, uint64_t *p_tag, int *p_stat)
+{
+  while (nDone == 0)
+  { if (!wait) return -EAGAIN;
+    pthread_cond_wait (&cqReady, &cqAccess);
+  }
+
+  *p_tag = slot[slotTop].tag;
+  *p_stat = slot[slotTop].stat;
+  slotTop = (slotTop + 1) % qDepth;
+  nDone -= 1;
+
+  pthread_mutex_lock (&sqAccess);
+  __atomic_sub_fetch (&inFlight, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock (&sqAccess);
+
+  return 0;
+}
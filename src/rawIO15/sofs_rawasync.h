@@ -0,0 +1,151 @@
+/**
+ *  \file sofs_rawasync.h (interface file)
+ *
+ *  \brief Asynchronous access to raw disk blocks and clusters.
+ *
+ *  The asynchronous engine shares the communication channel established with the storage device by the raw disk
+ *  module (see sofs_rawdisk.h). Transfers of blocks and clusters are submitted and proceed while the caller goes on;
+ *  their completion is collected later, identified by a tag supplied on submission.
+ *  The number of transfers that may simultaneously be in flight (the queue depth) is fixed when the engine is started.
+ *
+ *  The engine is run by the Linux \e io_uring interface. Whenever this interface is not available, or a synchronous
+ *  engine is explicitly required, the transfers are carried out by the raw disk module at submission time and only
+ *  their completion is deferred, so that the callers are kept unaware of the difference.
+ *
+ *  The following operations are defined:
+ *    \li start the asynchronous engine on the storage device
+ *    \li stop the asynchronous engine, waiting for the transfers in flight
+ *    \li get the type of the asynchronous engine which is running
+ *    \li submit the transfer of a block of data from / to the storage device
+ *    \li submit the transfer of a cluster of data from / to the storage device
+ *    \li collect the completion of a transfer previously submitted.
+ *
+ *  \remarks In case an error occurs, all functions return a negative value which is the symmetric of the system error
+ *           that better represents the error cause.
+ *           (execute command <em>man errno</em> to get the list of system errors)
+ */
+
+#ifndef SOFS_RAWASYNC_H_
+#define SOFS_RAWASYNC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** \brief the engine is run by the io_uring interface, if available, and is synchronous otherwise */
+#define ASYNC_NATIVE   0
+/** \brief the engine is synchronous */
+#define ASYNC_SYNC     1
+
+/** \brief the transfer reads data from the storage device */
+#define ASYNC_READ     0
+/** \brief the transfer writes data to the storage device */
+#define ASYNC_WRITE    1
+
+/** \brief maximum queue depth of the asynchronous engine */
+#define ASYNC_MAX_DEPTH (4096)
+
+/**
+ *  \brief Start the asynchronous engine on the storage device.
+ *
+ *  The storage device must have been previously opened by the raw disk module.
+ *  If the type of engine is \c ASYNC_NATIVE, an \e io_uring instance is set up; when that is not possible, or the
+ *  device is striped over several supporting files, a synchronous engine is started instead. If it is \c ASYNC_SYNC,
+ *  a synchronous engine is always started.
+ *
+ *  \param depth maximum number of transfers simultaneously in flight
+ *  \param type type of the engine that is required (\c ASYNC_NATIVE or \c ASYNC_SYNC)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>queue depth</em> is zero or greater than \c ASYNC_MAX_DEPTH, or the <em>type</em> is
+ *                      invalid
+ *  \return -\c EBUSY, if the engine is already started
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOMEM, if there is no memory for the internal data structures
+ */
+
+extern int soOpenAsyncEngine (uint32_t depth, uint32_t type);
+
+/**
+ *  \brief Stop the asynchronous engine, waiting for the transfers in flight.
+ *
+ *  The completions which were not yet collected are discarded.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the engine is not started
+ */
+
+extern int soCloseAsyncEngine (void);
+
+/**
+ *  \brief Get the type of the asynchronous engine which is running.
+ *
+ *  \return \c ASYNC_NATIVE, if the engine is run by the io_uring interface
+ *  \return \c ASYNC_SYNC, if the engine is synchronous
+ *  \return -\c EBADF, if the engine is not started
+ */
+
+extern int soGetAsyncEngineType (void);
+
+/**
+ *  \brief Submit the transfer of a block of data from / to the storage device.
+ *
+ *  The buffer must remain valid, and unchanged in case of a write, until the completion of the transfer is collected.
+ *
+ *  \param op direction of the transfer (\c ASYNC_READ or \c ASYNC_WRITE)
+ *  \param n physical number of the data block
+ *  \param buf pointer to the buffer where the data must be read into / written from
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>direction</em> is invalid, the <em>buffer pointer</em> is \c NULL or the
+ *                      <em>block number</em> is out of range, or the buffer is not aligned to \c DIRECT_ALIGN while
+ *                      the device is in \c DEV_DIRECT mode and the engine is run by the io_uring interface
+ *  \return -\c EBADF, if the engine is not started or the device is not already opened
+ *  \return -\c EAGAIN, if the queue is full (some completions must be collected first)
+ *  \return -<em>other specific error</em> issued by \e io_uring_enter system call
+ */
+
+extern int soSubmitRawBlock (uint32_t op, uint32_t n, void *buf, uint64_t tag);
+
+/**
+ *  \brief Submit the transfer of a cluster of data from / to the storage device.
+ *
+ *  The buffer must remain valid, and unchanged in case of a write, until the completion of the transfer is collected.
+ *
+ *  \param op direction of the transfer (\c ASYNC_READ or \c ASYNC_WRITE)
+ *  \param n physical number of the first block of the data cluster
+ *  \param buf pointer to the buffer where the data must be read into / written from
+ *  \param tag value that identifies the transfer on completion
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>direction</em> is invalid, the <em>buffer pointer</em> is \c NULL or the
+ *                      <em>block number</em> is out of range, or the buffer is not aligned to \c DIRECT_ALIGN while
+ *                      the device is in \c DEV_DIRECT mode and the engine is run by the io_uring interface
+ *  \return -\c EBADF, if the engine is not started or the device is not already opened
+ *  \return -\c EAGAIN, if the queue is full (some completions must be collected first)
+ *  \return -<em>other specific error</em> issued by \e io_uring_enter system call
+ */
+
+extern int soSubmitRawCluster (uint32_t op, uint32_t n, void *buf, uint64_t tag);
+
+/**
+ *  \brief Collect the completion of a transfer previously submitted.
+ *
+ *  Completions are not necessarily collected in the order of submission.
+ *
+ *  \param wait \c true, if the caller is to be blocked until a completion is available; \c false, otherwise
+ *  \param p_tag pointer to a location where the tag of the completed transfer is to be stored
+ *  \param p_stat pointer to a location where the status of the completed transfer is to be stored (<tt>0 (zero)</tt>,
+ *                on success, -\c EIO, if it was incomplete, or -<em>other specific error</em> issued by the transfer)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the pointers is \c NULL
+ *  \return -\c EBADF, if the engine is not started
+ *  \return -\c EAGAIN, if the caller is not to be blocked and no completion is available yet
+ *  \return -\c ENOENT, if there are no transfers in flight
+ *  \return -<em>other specific error</em> issued by \e io_uring_enter system call
+ */
+
+extern int soReapRawCompletion (bool wait, uint64_t *p_tag, int *p_stat);
+
+#endif /* SOFS_RAWASYNC_H_ */
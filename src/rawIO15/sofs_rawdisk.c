@@ -6,27 +6,77 @@
  *  The storage device is presently a Linux file which simulates a magnetic disk.
  *  The following operations are defined:
  *    \li open a communication channel with the storage device
+ *    \li open a communication channel with a storage device striped over several supporting files
  *    \li close the communication channel previously established
  *    \li read a block of data from the storage device
  *    \li write a block of data to the storage device
  *    \li read a cluster of data from the storage device
- *    \li write a cluster of data to the storage device.
+ *    \li write a cluster of data to the storage device
+ *    \li read a sequence of successive clusters of data from the storage device into a scatter list of buffers
+ *    \li write a sequence of successive clusters of data to the storage device from a gather list of buffers
+ *    \li write a sequence of successive blocks of data to the storage device from a gather list of buffers
+ *    \li get a pointer to a block or a cluster of data of a memory mapped storage device
+ *    \li synchronize the storage device, or a range of its blocks, with the supporting file
+ *    \li discard a range of blocks of the storage device, releasing their storage in the supporting file.
  *
  *  \author Artur Carneiro Pereira - September 2007
  *  \author Miguel Oliveira e Silva - September 2009
  *  \author António Rui Borges - July 2010
+ *
+ *  \remarks Data transfers use positional I/O (\e pread / \e pwrite): there is no shared file position, so the
+ *           read and write operations may be issued concurrently once the device has been opened.
+ *
+ *  \remarks When the device is opened in \c DEV_MMAP mode, the supporting file is mapped into memory: data transfers
+ *           become memory copies and pointers into the mapping may be handed out, so that clusters can be accessed
+ *           without any copy at all.
+ *
+ *  \remarks Every operation is accounted for in the statistics of the accesses to the raw disk (see sofs_rawstats.h).
+ *
+ *  \remarks A storage device may be striped over several supporting files: successive stripe units are placed in
+ *           successive files, in a round-robin fashion. Transfers which span several files are carried out in
+ *           parallel, by a worker thread per file.
+ *
+ *  \remarks When the device is opened in \c DEV_DIRECT mode, the supporting file is accessed bypassing the kernel page
+ *           cache. Buffers aligned to \c DIRECT_ALIGN bytes are transferred as they are; any other buffer is
+ *           transferred through one of a small set of aligned intermediate buffers, allocated when the device is
+ *           opened.
  */
 
+#define _GNU_SOURCE                              /* O_DIRECT */
+
+#include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <errno.h>
-#define __USE_GNU
+#include <pthread.h>
 #include <fcntl.h>
 
 #include "sofs_const.h"
 #include "sofs_probe.h"
+#include "sofs_rawdisk.h"
+#include "sofs_rawdiskinternals.h"
+#include "sofs_rawstats.h"
+
+/** \brief maximum number of elements of a scatter / gather list that may be handled by a single system call */
+#ifdef IOV_MAX
+#define IOV_BATCH (IOV_MAX)
+#else
+#define IOV_BATCH (1024)
+#endif
+
+/** \brief number of aligned intermediate buffers of a device opened in DEV_DIRECT mode */
+#define BOUNCE_BUFFERS  4
+
+/** \brief size of an aligned intermediate buffer (in bytes): longer transfers are carried out in pieces */
+#define BOUNCE_SIZE  (16 * CLUSTER_SIZE)
 
 /*
  *  Internal data structure
@@ -35,6 +85,83 @@
 static int fd = -1;
 /** \brief Number of blocks of the storage device */
 static uint32_t bnmax = 0;
+/** \brief Access mode of the storage device */
+static uint32_t devMode = DEV_STD;
+/** \brief Mapping of the supporting file into memory (DEV_MMAP mode only) */
+static unsigned char *devMap = NULL;
+/** \brief Aligned intermediate buffers, one after the other (DEV_DIRECT mode only) */
+static unsigned char *bounceArea = NULL;
+/** \brief Set of the aligned intermediate buffers which are free (bit \e i stands for buffer \e i) */
+static uint32_t bounceFree = 0;
+/** \brief Access to the set of the free aligned intermediate buffers */
+static pthread_mutex_t bounceAccess = PTHREAD_MUTEX_INITIALIZER;
+/** \brief Signals an aligned intermediate buffer was released */
+static pthread_cond_t bounceReady = PTHREAD_COND_INITIALIZER;
+
+/**
+ *  \brief Definition of the transfer of a striped device carried out by a worker.
+ *
+ *  A transfer is split in parts, one per supporting file, which belong to a single request.
+ */
+
+typedef struct soStripeJob
+{
+   /** \brief \c true, if the blocks are to be written; \c false, if they are to be read */
+    bool wr;
+   /** \brief scatter / gather list of the part of the transfer in the supporting file */
+    const struct iovec *iov;
+   /** \brief number of elements of the scatter / gather list */
+    int iovcnt;
+   /** \brief position in the supporting file */
+    off_t pos;
+   /** \brief number of parts of the request which are not yet completed */
+    uint32_t *p_pending;
+   /** \brief status of the request */
+    int *p_stat;
+   /** \brief next transfer in the queue of the worker */
+    struct soStripeJob *next;
+} SOStripeJob;
+
+/** \brief Number of supporting files the storage device is striped over (0 - not striped) */
+static uint32_t nFilesS = 0;
+/** \brief Stripe unit (number of blocks) */
+static uint32_t stripeUnit = 0;
+/** \brief File descriptors of the supporting files of a striped device */
+static int sfd[STRIPE_MAX_FILES];
+/** \brief Worker threads, one per supporting file of a striped device */
+static pthread_t worker[STRIPE_MAX_FILES];
+/** \brief Heads of the queues of transfers of the workers */
+static SOStripeJob *jobHead[STRIPE_MAX_FILES];
+/** \brief Tails of the queues of transfers of the workers */
+static SOStripeJob *jobTail[STRIPE_MAX_FILES];
+/** \brief Signals the workers a transfer was queued */
+static pthread_cond_t jobReady[STRIPE_MAX_FILES];
+/** \brief Signals the requesters a part of a transfer was completed */
+static pthread_cond_t jobDone = PTHREAD_COND_INITIALIZER;
+/** \brief Access to the queues of transfers */
+static pthread_mutex_t stripeAccess = PTHREAD_MUTEX_INITIALIZER;
+/** \brief The workers are to terminate */
+static bool stopWorkers = false;
+
+/*
+ *  Allusion to internal functions
+ */
+
+static int rawProbeDirect (int dfd);
+static int rawBounced (bool wr, const struct iovec *iov, int iovcnt, uint32_t n);
+static void rawBounceCopy (bool gather, const struct iovec *iov, int *p_i, size_t *p_off, unsigned char *tmp,
+                           size_t len);
+static int rawRead (void *buf, size_t count, uint32_t n);
+static int rawWrite (void *buf, size_t count, uint32_t n);
+static int rawCheckVector (uint32_t n, uint64_t nBlks, const struct iovec *iov, int iovcnt);
+static int rawTransferV (bool wr, const struct iovec *iov, int iovcnt, uint32_t n);
+static int rawTransferAt (int dfd, bool wr, const struct iovec *iov, int iovcnt, off_t pos);
+static int rawStriped (bool wr, const struct iovec *iov, int iovcnt, uint32_t n);
+static void *rawWorker (void *arg);
+static void rawStopWorkers (uint32_t nw);
+static int rawSyncFiles (bool dataOnly);
+static int rawPunch (uint32_t n, uint32_t nBlks);
+static int rawMap (uint32_t n, uint32_t nBlks, void **p_addr);
 
 /**
  *  \brief Open the storage device.
@@ -42,6 +169,7 @@ static uint32_t bnmax = 0;
  *  A communication channel is established with the storage device.
  *  It is supposed that no communication channel was previously established.
  *  The Linux file that simulates the storage device must exist and have a size multiple of the block size.
+ *  The device is opened in \c DEV_STD mode.
  *
  *  \param devname absolute path to the Linux file that simulates the storage device
  *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
@@ -50,29 +178,190 @@ static uint32_t bnmax = 0;
  *  \return -\c EINVAL, if \e devname or \e p_bnmax are \c NULL
  *  \return -\c EBUSY, if the device is already opened
  *  \return -\c ELIBBAD, if the supporting file size is invalid
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e open or \e fstat system calls
  */
 
 int soOpenDevice (const char *devname, uint32_t *p_bnmax)
 {
   soColorProbe (851, "07;31", "soOpenDevice(\"%s\", %p)\n", devname, p_bnmax);
 
+  return soOpenDeviceMode (devname, DEV_STD, p_bnmax);
+}
+
+/**
+ *  \brief Open the storage device in a given access mode.
+ *
+ *  A communication channel is established with the storage device.
+ *  It is supposed that no communication channel was previously established.
+ *  The Linux file that simulates the storage device must exist and have a size multiple of the block size.
+ *  In \c DEV_MMAP mode, the whole supporting file is mapped into memory. In \c DEV_DIRECT mode, the supporting file is
+ *  opened for direct I/O and the file system that holds it must be able to transfer single blocks that way.
+ *
+ *  \param devname absolute path to the Linux file that simulates the storage device
+ *  \param mode access mode of the storage device (\c DEV_STD, \c DEV_MMAP or \c DEV_DIRECT)
+ *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if \e devname or \e p_bnmax are \c NULL or the access mode is invalid
+ *  \return -\c EBUSY, if the device is already opened
+ *  \return -\c ELIBBAD, if the supporting file size is invalid
+ *  \return -\c ENOTSUP, if direct I/O of single blocks is not supported by the file system
+ *  \return -\c ENOMEM, if there is no memory for the intermediate buffers
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat, \e mmap or \e pread system calls
+ */
+
+int soOpenDeviceMode (const char *devname, uint32_t mode, uint32_t *p_bnmax)
+{
+  soColorProbe (859, "07;31", "soOpenDeviceMode(\"%s\", %"PRIu32", %p)\n", devname, mode, p_bnmax);
+
   if ((devname == NULL) || (p_bnmax == NULL))
      return -EINVAL;                             /* checking for null pointers */
+  if ((mode != DEV_STD) && (mode != DEV_MMAP) && (mode != DEV_DIRECT))
+     return -EINVAL;                             /* checking for access mode */
   if (fd != -1) return -EBUSY;                   /* checking for device open state */
 
   /* opening supporting file in async mode for read and write */
 
-  if ((fd = open (devname, O_RDWR)) == -1)
+  int dfd;                                       /* file descriptor of the supporting file */
+
+  if ((dfd = open (devname, (mode == DEV_DIRECT) ? (O_RDWR | O_DIRECT) : O_RDWR)) == -1)
      return -errno;                              /* checking for opening error */
 
   /* checking device for conformity */
 
   struct stat st;
-  if (stat (devname, &st) == -1) return -errno;
-  if ((st.st_size % BLOCK_SIZE) != 0) return -ELIBBAD;
+  if (fstat (dfd, &st) == -1)
+     { int err = errno;
+       close (dfd);
+       return -err;
+     }
+  if ((st.st_size == 0) || ((st.st_size % BLOCK_SIZE) != 0))
+     { close (dfd);
+       return -ELIBBAD;
+     }
+
+  /* mapping the supporting file into memory */
+
+  if (mode == DEV_MMAP)
+     { void *addr = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, dfd, 0);
+       if (addr == MAP_FAILED)
+          { int err = errno;
+            close (dfd);
+            return -err;
+          }
+       devMap = addr;
+     }
+
+  /* allocating the aligned intermediate buffers and checking the supporting file for direct I/O of single blocks */
+
+  if (mode == DEV_DIRECT)
+     { void *area;                               /* aligned intermediate buffers */
+       int stat;                                 /* status of operation */
+
+       if (posix_memalign (&area, DIRECT_ALIGN, (size_t) BOUNCE_BUFFERS * BOUNCE_SIZE) != 0)
+          { close (dfd);
+            return -ENOMEM;
+          }
+       bounceArea = area;
+       if ((stat = rawProbeDirect (dfd)) != 0)
+          { free (bounceArea);
+            bounceArea = NULL;
+            close (dfd);
+            return stat;
+          }
+       bounceFree = (1U << BOUNCE_BUFFERS) - 1;
+     }
 
   bnmax = st.st_size / BLOCK_SIZE;               /* get number of blocks of the device */
+  devMode = mode;
+  soResetRawStats ();
+  fd = dfd;
+  *p_bnmax = bnmax;
+
+  return 0;
+}
+
+/**
+ *  \brief Open a storage device striped over several supporting files.
+ *
+ *  A communication channel is established with the storage device.
+ *  It is supposed that no communication channel was previously established.
+ *  The device is made of successive stripe units placed in the supporting files in a round-robin fashion: stripe unit
+ *  \e k is the unit <em>k / nFiles</em> of file <em>k % nFiles</em>. The files must exist; only as many whole stripe
+ *  units as fit in the smallest of them are used in each one. The device is opened in \c DEV_STD mode and a worker
+ *  thread is started per supporting file.
+ *
+ *  \param nFiles number of supporting files (from 2 up to \c STRIPE_MAX_FILES)
+ *  \param devname array of absolute paths to the Linux files that support the storage device
+ *  \param unit stripe unit (number of clusters)
+ *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the pointers is \c NULL, the <em>number of files</em> is out of range or the
+ *                      <em>stripe unit</em> is zero
+ *  \return -\c EBUSY, if the device is already opened
+ *  \return -\c ELIBBAD, if some supporting file is smaller than a stripe unit
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat or \e pthread_create calls
+ */
+
+int soOpenStripedDevice (uint32_t nFiles, const char *devname[], uint32_t unit, uint32_t *p_bnmax)
+{
+  soColorProbe (898, "07;31", "soOpenStripedDevice(%"PRIu32", %p, %"PRIu32", %p)\n", nFiles, devname, unit, p_bnmax);
+
+  uint64_t minSize = UINT64_MAX;                 /* size of the smallest supporting file */
+  uint64_t nUnits;                               /* number of stripe units used in each supporting file */
+  uint32_t i, nw;
+  int stat;                                      /* status of operation */
+
+  if ((devname == NULL) || (p_bnmax == NULL) || (nFiles < 2) || (nFiles > STRIPE_MAX_FILES) || (unit == 0))
+     return -EINVAL;                             /* checking for arguments */
+  for (i = 0; i < nFiles; i++)
+    if (devname[i] == NULL) return -EINVAL;
+  if (fd != -1) return -EBUSY;                   /* checking for device open state */
+
+  /* opening the supporting files for read and write and finding out the smallest one */
+
+  for (i = 0; i < nFiles; i++)
+  { struct stat st;
+
+    if (((sfd[i] = open (devname[i], O_RDWR)) == -1) || (fstat (sfd[i], &st) == -1))
+       { stat = -errno;
+         if (sfd[i] != -1) close (sfd[i]);
+         while (i > 0) close (sfd[--i]);
+         return stat;
+       }
+    if ((uint64_t) st.st_size < minSize) minSize = st.st_size;
+  }
+  nUnits = minSize / ((uint64_t) unit * CLUSTER_SIZE);
+  if (nUnits > UINT32_MAX / ((uint64_t) unit * BLOCKS_PER_CLUSTER * nFiles))    /* the number of blocks must fit */
+     nUnits = UINT32_MAX / ((uint64_t) unit * BLOCKS_PER_CLUSTER * nFiles);
+  if (nUnits == 0)
+     { for (i = 0; i < nFiles; i++)
+         close (sfd[i]);
+       return -ELIBBAD;
+     }
+
+  /* starting the workers */
+
+  stopWorkers = false;
+  for (nw = 0; nw < nFiles; nw++)
+  { jobHead[nw] = jobTail[nw] = NULL;
+    pthread_cond_init (&jobReady[nw], NULL);
+    if ((stat = pthread_create (&worker[nw], NULL, rawWorker, (void *) (uintptr_t) nw)) != 0)
+       { pthread_cond_destroy (&jobReady[nw]);
+         rawStopWorkers (nw);
+         for (i = 0; i < nFiles; i++)
+           close (sfd[i]);
+         return -stat;
+       }
+  }
+
+  nFilesS = nFiles;
+  stripeUnit = unit * BLOCKS_PER_CLUSTER;
+  bnmax = nUnits * stripeUnit * nFiles;          /* get number of blocks of the device */
+  devMode = DEV_STD;
+  soResetRawStats ();
+  fd = sfd[0];
   *p_bnmax = bnmax;
 
   return 0;
@@ -93,6 +382,26 @@ int soCloseDevice (void)
 
   if (fd == -1) return -EBADF;                   /* checking for device close state */
 
+  soRawStatsDump ();                             /* print the statistics of the accesses to the device */
+  if (devMap != NULL)                            /* flush and remove the mapping of the supporting file */
+     { msync (devMap, (size_t) BLOCK_SIZE * bnmax, MS_SYNC);
+       munmap (devMap, (size_t) BLOCK_SIZE * bnmax);
+       devMap = NULL;
+     }
+  if (bounceArea != NULL)                        /* release the aligned intermediate buffers */
+     { free (bounceArea);
+       bounceArea = NULL;
+       bounceFree = 0;
+     }
+  devMode = DEV_STD;
+  if (nFilesS != 0)                              /* stop the workers and close the supporting files */
+     { uint32_t i;
+
+       rawStopWorkers (nFilesS);
+       for (i = 1; i < nFilesS; i++)
+         close (sfd[i]);
+       nFilesS = stripeUnit = 0;
+     }
   close (fd);                                    /* close the device */
   bnmax = 0;                                     /* reset number of blocks of the storage device */
   fd = -1;                                       /* reset file descriptor of the Linux file that simulates the
@@ -115,7 +424,7 @@ int soCloseDevice (void)
  *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL or the <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on reading
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread system call
  */
 
 int soReadRawBlock (uint32_t n, void *buf)
@@ -126,12 +435,14 @@ int soReadRawBlock (uint32_t n, void *buf)
   if (n >= bnmax) return -EINVAL;                /* checking for block number */
   if (fd == -1) return -EBADF;                   /* checking for device closed state */
 
-  /* set file current position to the required block and read its contents */
+  /* read the contents of the required block at its position in the supporting file */
 
-  if (lseek (fd, BLOCK_SIZE * n, SEEK_SET) == -1) return -errno;
-  if (read (fd, buf, BLOCK_SIZE) != BLOCK_SIZE) return -EIO;
+  uint64_t t0 = soRawStatsClock ();
+  int stat = rawRead (buf, BLOCK_SIZE, n);
 
-  return 0;
+  soRawStatsRecord (RAWOP_READ_BLOCK, n, 1, t0, stat);
+
+  return stat;
 }
 
 /**
@@ -148,7 +459,7 @@ int soReadRawBlock (uint32_t n, void *buf)
  *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
  */
 
 int soWriteRawBlock (uint32_t n, void *buf)
@@ -159,12 +470,14 @@ int soWriteRawBlock (uint32_t n, void *buf)
   if (n >= bnmax) return -EINVAL;                /* checking for block number */
   if (fd == -1) return -EBADF;                   /* checking for device closed state */
 
-  /* set file current position to the required block and write its contents */
+  /* write the contents of the required block at its position in the supporting file */
 
-  if (lseek (fd, BLOCK_SIZE * n, SEEK_SET) == -1) return -errno;
-  if (write (fd, buf, BLOCK_SIZE) != BLOCK_SIZE) return -EIO;
+  uint64_t t0 = soRawStatsClock ();
+  int stat = rawWrite (buf, BLOCK_SIZE, n);
 
-  return 0;
+  soRawStatsRecord (RAWOP_WRITE_BLOCK, n, 1, t0, stat);
+
+  return stat;
 }
 
 /**
@@ -181,7 +494,7 @@ int soWriteRawBlock (uint32_t n, void *buf)
  *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL or the <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on reading
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread system call
  */
 
 int soReadRawCluster (uint32_t n, void *buf)
@@ -193,12 +506,14 @@ int soReadRawCluster (uint32_t n, void *buf)
      return -EINVAL;
   if (fd == -1) return -EBADF;                   /* checking for device closed state */
 
-  /* Set file current position to first block of the required cluster and read blocks contents in succession */
+  /* read blocks contents in succession, starting at the position of the first block of the required cluster */
 
-  if (lseek (fd, BLOCK_SIZE * n, SEEK_SET) == -1) return -errno;
-  if (read (fd, buf, CLUSTER_SIZE) != CLUSTER_SIZE) return -EIO;
+  uint64_t t0 = soRawStatsClock ();
+  int stat = rawRead (buf, CLUSTER_SIZE, n);
 
-  return 0;
+  soRawStatsRecord (RAWOP_READ_CLUSTER, n, BLOCKS_PER_CLUSTER, t0, stat);
+
+  return stat;
 }
 
 /**
@@ -215,7 +530,7 @@ int soReadRawCluster (uint32_t n, void *buf)
  *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
  */
 
 int soWriteRawCluster (uint32_t n, void *buf)
@@ -227,10 +542,910 @@ int soWriteRawCluster (uint32_t n, void *buf)
      return -EINVAL;
   if (fd == -1) return -EBADF;                   /* checking for device closed state */
 
-  /* Set file current position to first block of the required cluster and write blocks contents in succession */
+  /* write blocks contents in succession, starting at the position of the first block of the required cluster */
+
+  uint64_t t0 = soRawStatsClock ();
+  int stat = rawWrite (buf, CLUSTER_SIZE, n);
+
+  soRawStatsRecord (RAWOP_WRITE_CLUSTER, n, BLOCKS_PER_CLUSTER, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Read a sequence of successive clusters of data from the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the first block of the first data cluster to be read, the number of clusters and a scatter
+ *  list of previously allocated buffers are supplied as arguments. The buffers are filled in succession and their
+ *  lengths must add up to the size of the whole sequence of clusters.
+ *  The transfer is carried out, whenever possible, by a single \e preadv system call.
+ *
+ *  \param n physical number of the first block of the first data cluster to be read from
+ *  \param nClust number of successive clusters to be read
+ *  \param iov pointer to the scatter list of buffers where the data must be read into
+ *  \param iovcnt number of elements of the scatter list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>scatter list</em> is \c NULL or empty, its total length does not match the number of
+ *                      clusters or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on reading
+ *  \return -<em>other specific error</em> issued by \e preadv system call
+ */
+
+int soReadRawClusters (uint32_t n, uint32_t nClust, const struct iovec *iov, int iovcnt)
+{
+  soColorProbe (857, "07;31", "soReadRawClusters(%"PRIu32", %"PRIu32", %p, %d)\n", n, nClust, iov, iovcnt);
+
+  int stat;                                      /* status of operation */
+
+  if ((stat = rawCheckVector (n, (uint64_t) nClust * BLOCKS_PER_CLUSTER, iov, iovcnt)) != 0) return stat;
+
+  /* read blocks contents in succession, starting at the position of the first block of the first cluster */
+
+  uint64_t t0 = soRawStatsClock ();
+  stat = rawTransferV (false, iov, iovcnt, n);
+  soRawStatsRecord (RAWOP_READ_CLUSTERS, n, nClust * BLOCKS_PER_CLUSTER, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Write a sequence of successive clusters of data to the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the first block of the first data cluster to be written, the number of clusters and a
+ *  gather list of previously allocated buffers are supplied as arguments. The buffers are written in succession and
+ *  their lengths must add up to the size of the whole sequence of clusters.
+ *  The transfer is carried out, whenever possible, by a single \e pwritev system call.
+ *
+ *  \param n physical number of the first block of the first data cluster to be written into
+ *  \param nClust number of successive clusters to be written
+ *  \param iov pointer to the gather list of buffers containing the data to be written from
+ *  \param iovcnt number of elements of the gather list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>gather list</em> is \c NULL or empty, its total length does not match the number of
+ *                      clusters or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwritev system call
+ */
+
+int soWriteRawClusters (uint32_t n, uint32_t nClust, const struct iovec *iov, int iovcnt)
+{
+  soColorProbe (858, "07;31", "soWriteRawClusters(%"PRIu32", %"PRIu32", %p, %d)\n", n, nClust, iov, iovcnt);
+
+  int stat;                                      /* status of operation */
+
+  if ((stat = rawCheckVector (n, (uint64_t) nClust * BLOCKS_PER_CLUSTER, iov, iovcnt)) != 0) return stat;
+
+  /* write blocks contents in succession, starting at the position of the first block of the first cluster */
+
+  uint64_t t0 = soRawStatsClock ();
+  stat = rawTransferV (true, iov, iovcnt, n);
+  soRawStatsRecord (RAWOP_WRITE_CLUSTERS, n, nClust * BLOCKS_PER_CLUSTER, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Write a sequence of successive blocks of data to the storage device.
+ *
+ *  The device is organized as a linear array of data blocks.
+ *  The physical number of the first block to be written, the number of blocks and a gather list of previously
+ *  allocated buffers are supplied as arguments. The buffers are written in succession and their lengths must add up
+ *  to the size of the whole sequence of blocks.
+ *  The transfer is carried out, whenever possible, by a single \e pwritev system call.
+ *
+ *  \param n physical number of the first block to be written into
+ *  \param nBlks number of successive blocks to be written
+ *  \param iov pointer to the gather list of buffers containing the data to be written from
+ *  \param iovcnt number of elements of the gather list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>gather list</em> is \c NULL or empty, its total length does not match the number of
+ *                      blocks or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwritev system call
+ */
+
+int soWriteRawBlocks (uint32_t n, uint32_t nBlks, const struct iovec *iov, int iovcnt)
+{
+  soColorProbe (887, "07;31", "soWriteRawBlocks(%"PRIu32", %"PRIu32", %p, %d)\n", n, nBlks, iov, iovcnt);
+
+  int stat;                                      /* status of operation */
+
+  if ((stat = rawCheckVector (n, nBlks, iov, iovcnt)) != 0) return stat;
+
+  /* write blocks contents in succession, starting at the position of the first block */
+
+  uint64_t t0 = soRawStatsClock ();
+  stat = rawTransferV (true, iov, iovcnt, n);
+  soRawStatsRecord (RAWOP_WRITE_BLOCKS, n, nBlks, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Get a pointer to a block of data of a memory mapped storage device.
+ *
+ *  The pointer refers to the contents of the block in the mapping of the supporting file: the block may be read and
+ *  modified in place. Modifications are flushed to the supporting file when the device is synchronized or closed.
+ *  The pointer is valid while the device remains open.
+ *
+ *  \param n physical number of the data block
+ *  \param p_addr pointer to a location where the pointer to the contents of the block is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the device was not opened in \c DEV_MMAP mode
+ */
+
+int soMapRawBlock (uint32_t n, void **p_addr)
+{
+  soColorProbe (891, "07;31", "soMapRawBlock(%"PRIu32", %p)\n", n, p_addr);
+
+  uint64_t t0 = soRawStatsClock ();
+  int stat = rawMap (n, 1, p_addr);
+
+  soRawStatsRecord (RAWOP_MAP, n, 1, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Get a pointer to a cluster of data of a memory mapped storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The pointer refers to the contents of the cluster in the mapping of the supporting file: the cluster may be read
+ *  and modified in place. Modifications are flushed to the supporting file when the device is synchronized or closed.
+ *  The pointer is valid while the device remains open.
+ *
+ *  \param n physical number of the first block of the data cluster
+ *  \param p_addr pointer to a location where the pointer to the contents of the cluster is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the device was not opened in \c DEV_MMAP mode
+ */
+
+int soMapRawCluster (uint32_t n, void **p_addr)
+{
+  soColorProbe (892, "07;31", "soMapRawCluster(%"PRIu32", %p)\n", n, p_addr);
+
+  uint64_t t0 = soRawStatsClock ();
+  int stat = rawMap (n, BLOCKS_PER_CLUSTER, p_addr);
+
+  soRawStatsRecord (RAWOP_MAP, n, BLOCKS_PER_CLUSTER, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Synchronize a range of blocks of the storage device with the supporting file.
+ *
+ *  In \c DEV_MMAP mode, the pages of the mapping which hold the blocks are flushed by \e msync; otherwise, the data of
+ *  the supporting files are flushed by \e fdatasync.
+ *
+ *  \param n physical number of the first block of the range
+ *  \param nBlks number of blocks of the range
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -<em>other specific error</em> issued by \e msync or \e fdatasync system calls
+ */
+
+int soSyncRawRange (uint32_t n, uint32_t nBlks)
+{
+  soColorProbe (893, "07;31", "soSyncRawRange(%"PRIu32", %"PRIu32")\n", n, nBlks);
+
+  if (((uint64_t) n + nBlks) > bnmax) return -EINVAL;       /* checking for block number */
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+
+  uint64_t t0 = soRawStatsClock ();
+  int stat = 0;                                  /* status of operation */
+
+  if (devMap != NULL)
+     { size_t page = sysconf (_SC_PAGESIZE);     /* msync requires a page aligned address */
+       size_t start = ((size_t) BLOCK_SIZE * n) / page * page;
+       size_t end = (size_t) BLOCK_SIZE * (n + nBlks);
+
+       if ((end > start) && (msync (devMap + start, end - start, MS_SYNC) == -1)) stat = -errno;
+     }
+     else stat = rawSyncFiles (true);
+  soRawStatsRecord (RAWOP_SYNC, n, nBlks, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Synchronize the storage device with the supporting file.
+ *
+ *  In \c DEV_MMAP mode, the whole mapping is flushed by \e msync; otherwise, the supporting files are flushed by
+ *  \e fsync.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -<em>other specific error</em> issued by \e msync or \e fsync system calls
+ */
+
+int soSyncRawDevice (void)
+{
+  soColorProbe (894, "07;31", "soSyncRawDevice()\n");
+
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+
+  uint64_t t0 = soRawStatsClock ();
+  int stat = 0;                                  /* status of operation */
+
+  if ((devMap != NULL) && (msync (devMap, (size_t) BLOCK_SIZE * bnmax, MS_SYNC) == -1))
+     stat = -errno;
+     else stat = rawSyncFiles (false);
+  soRawStatsRecord (RAWOP_SYNC, 0, bnmax, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Discard a range of blocks of the storage device, releasing their storage in the supporting file.
+ *
+ *  A hole is punched in the supporting file (or files, if the device is striped) by \e fallocate: the size of the
+ *  file is kept, the storage of the blocks is returned to the file system and their contents is read as zeros
+ *  afterwards. Blocks which are only partially covered by a page of the file system hosting the supporting file are
+ *  zeroed, but their storage is kept.
+ *
+ *  \param n physical number of the first block of the range
+ *  \param nBlks number of blocks of the range
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EOPNOTSUPP, if the file system hosting the supporting file does not support punching holes
+ *  \return -<em>other specific error</em> issued by \e fallocate system call
+ */
+
+int soDiscardRawRange (uint32_t n, uint32_t nBlks)
+{
+  soColorProbe (899, "07;31", "soDiscardRawRange(%"PRIu32", %"PRIu32")\n", n, nBlks);
+
+  if (((uint64_t) n + nBlks) > bnmax) return -EINVAL;       /* checking for block number */
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+
+  uint64_t t0 = soRawStatsClock ();
+  int stat = (nBlks == 0) ? 0 : rawPunch (n, nBlks);
+
+  soRawStatsRecord (RAWOP_DISCARD, n, nBlks, t0, stat);
+
+  return stat;
+}
+
+/**
+ *  \brief Get the file descriptor and the number of blocks of the storage device.
+ *
+ *  If the storage device is striped over several supporting files, there is no single file descriptor and -1 is
+ *  stored instead.
+ *
+ *  \param p_fd pointer to a location where the file descriptor of the supporting file is to be stored
+ *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the pointers is \c NULL
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+int soGetRawDevice (int *p_fd, uint32_t *p_bnmax)
+{
+  if ((p_fd == NULL) || (p_bnmax == NULL)) return -EINVAL;  /* checking for null pointers */
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+
+  *p_fd = (nFilesS != 0) ? -1 : fd;
+  *p_bnmax = bnmax;
+
+  return 0;
+}
+
+/**
+ *  \brief Get the access mode of the storage device.
+ *
+ *  \return \c DEV_STD, \c DEV_MMAP or \c DEV_DIRECT, on success
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+int soGetRawDeviceMode (void)
+{
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+
+  return devMode;
+}
+
+/**
+ *  \brief Check whether the supporting file allows direct I/O of single blocks.
+ *
+ *  The first block is read into the first aligned intermediate buffer: file systems whose direct I/O granularity is
+ *  larger than a block reject the transfer.
+ *
+ *  \param dfd file descriptor of the supporting file, opened for direct I/O
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c ENOTSUP, if direct I/O of single blocks is not supported
+ *  \return -<em>other specific error</em> issued by \e pread system call
+ */
+
+static int rawProbeDirect (int dfd)
+{
+  ssize_t nb;                                    /* number of bytes transferred */
+  int stat = 0;                                  /* status of operation */
+
+  while ((nb = pread (dfd, bounceArea, BLOCK_SIZE, 0)) == -1)
+    if (errno != EINTR)
+       { stat = (errno == EINVAL) ? -ENOTSUP : -errno;
+         break;
+       }
+  if ((stat == 0) && (nb != BLOCK_SIZE)) stat = -ENOTSUP;
+
+  return stat;
+}
+
+/**
+ *  \brief Transfer a sequence of successive blocks between the storage device and a scatter / gather list, through
+ *         an aligned intermediate buffer.
+ *
+ *  One of the aligned intermediate buffers of the device is taken, the caller being blocked while all of them are in
+ *  use, and the sequence is transferred through it in pieces of up to \c BOUNCE_SIZE bytes.
+ *
+ *  \param wr \c true, if the blocks are to be written; \c false, if they are to be read
+ *  \param iov pointer to the scatter / gather list of buffers
+ *  \param iovcnt number of elements of the scatter / gather list
+ *  \param n physical number of the first block to be transferred
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EIO, if no progress could be made
+ *  \return -<em>other specific error</em> issued by \e pread or \e pwrite system calls
+ */
+
+static int rawBounced (bool wr, const struct iovec *iov, int iovcnt, uint32_t n)
+{
+  unsigned char *tmp;                            /* aligned intermediate buffer */
+  uint32_t b;                                    /* index of the aligned intermediate buffer */
+  size_t total = 0;                              /* number of bytes still to be transferred */
+  size_t len;                                    /* number of bytes of the current piece */
+  size_t off = 0;                                /* offset within the current element of the list */
+  int i;
+  int stat = 0;                                  /* status of operation */
+
+  for (i = 0; i < iovcnt; i++)
+    total += iov[i].iov_len;
+
+  pthread_mutex_lock (&bounceAccess);
+  while (bounceFree == 0)
+    pthread_cond_wait (&bounceReady, &bounceAccess);
+  b = __builtin_ctz (bounceFree);
+  bounceFree &= ~(1U << b);
+  pthread_mutex_unlock (&bounceAccess);
+  tmp = bounceArea + (size_t) b * BOUNCE_SIZE;
+
+  i = 0;
+  while ((stat == 0) && (total > 0))
+  { len = (total < BOUNCE_SIZE) ? total : BOUNCE_SIZE;
+    if (wr)
+       { rawBounceCopy (true, iov, &i, &off, tmp, len);
+         stat = rawWrite (tmp, len, n);
+       }
+       else if ((stat = rawRead (tmp, len, n)) == 0)
+               rawBounceCopy (false, iov, &i, &off, tmp, len);
+    n += len / BLOCK_SIZE;
+    total -= len;
+  }
+
+  pthread_mutex_lock (&bounceAccess);
+  bounceFree |= 1U << b;
+  pthread_cond_signal (&bounceReady);
+  pthread_mutex_unlock (&bounceAccess);
+
+  return stat;
+}
+
+/**
+ *  \brief Copy a piece of a scatter / gather list to, or from, an aligned intermediate buffer.
+ *
+ *  \param gather \c true, if the piece is to be copied from the list to the buffer; \c false, otherwise
+ *  \param iov pointer to the scatter / gather list of buffers
+ *  \param p_i pointer to the index of the element of the list where the piece starts (it is updated)
+ *  \param p_off pointer to the offset within that element where the piece starts (it is updated)
+ *  \param tmp pointer to the aligned intermediate buffer
+ *  \param len number of bytes of the piece
+ */
+
+static void rawBounceCopy (bool gather, const struct iovec *iov, int *p_i, size_t *p_off, unsigned char *tmp,
+                           size_t len)
+{
+  size_t k;                                      /* number of bytes copied from / to the current element */
+
+  while (len > 0)
+  { k = iov[*p_i].iov_len - *p_off;
+    if (k > len) k = len;
+    if (gather)
+       memcpy (tmp, (unsigned char *) iov[*p_i].iov_base + *p_off, k);
+       else memcpy ((unsigned char *) iov[*p_i].iov_base + *p_off, tmp, k);
+    tmp += k;
+    len -= k;
+    *p_off += k;
+    if (*p_off == iov[*p_i].iov_len)
+       { *p_i += 1;
+         *p_off = 0;
+       }
+  }
+}
+
+/**
+ *  \brief Read a sequence of successive blocks from the supporting file.
+ *
+ *  The transfer is carried out with positional reads, so the file descriptor has no current position that could be
+ *  shared among callers. Short reads are resumed until the whole sequence is transferred.
+ *  If the supporting file is mapped into memory, the data is simply copied from the mapping. In \c DEV_DIRECT mode, a
+ *  buffer which is not aligned is read through an aligned intermediate one.
+ *
+ *  \param buf pointer to the buffer where the data must be read into
+ *  \param count number of bytes to be read (a multiple of the block size)
+ *  \param n physical number of the first block to be read from
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EIO, if the end of the supporting file is reached before the transfer is complete
+ *  \return -<em>other specific error</em> issued by \e pread system call
+ */
+
+static int rawRead (void *buf, size_t count, uint32_t n)
+{
+  unsigned char *p = buf;                        /* current location in the buffer */
+  off_t pos = (off_t) BLOCK_SIZE * n;            /* current position in the supporting file */
+  ssize_t nb;                                    /* number of bytes transferred by the last call */
+
+  if (devMap != NULL)                            /* the supporting file is mapped into memory */
+     { memcpy (p, devMap + pos, count);
+       return 0;
+     }
+  if ((devMode == DEV_DIRECT) && (((uintptr_t) buf % DIRECT_ALIGN) != 0))
+     { struct iovec whole = { .iov_base = buf, .iov_len = count };
+       return rawBounced (false, &whole, 1, n);
+     }
+  if (nFilesS != 0)                              /* the device is striped over several supporting files */
+     { struct iovec whole = { .iov_base = buf, .iov_len = count };
+       return rawStriped (false, &whole, 1, n);
+     }
+
+  while (count > 0)
+  { if ((nb = pread (fd, p, count, pos)) == -1)
+       { if (errno == EINTR) continue;
+         return -errno;
+       }
+    if (nb == 0) return -EIO;                    /* premature end of file */
+    p += nb;
+    pos += nb;
+    count -= nb;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Write a sequence of successive blocks to the supporting file.
+ *
+ *  The transfer is carried out with positional writes, so the file descriptor has no current position that could be
+ *  shared among callers. Short writes are resumed until the whole sequence is transferred.
+ *  If the supporting file is mapped into memory, the data is simply copied into the mapping. In \c DEV_DIRECT mode, a
+ *  buffer which is not aligned is written through an aligned intermediate one.
+ *
+ *  \param buf pointer to the buffer containing the data to be written from
+ *  \param count number of bytes to be written (a multiple of the block size)
+ *  \param n physical number of the first block to be written into
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EIO, if no progress could be made on writing
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
+ */
+
+static int rawWrite (void *buf, size_t count, uint32_t n)
+{
+  unsigned char *p = buf;                        /* current location in the buffer */
+  off_t pos = (off_t) BLOCK_SIZE * n;            /* current position in the supporting file */
+  ssize_t nb;                                    /* number of bytes transferred by the last call */
+
+  if (devMap != NULL)                            /* the supporting file is mapped into memory */
+     { memcpy (devMap + pos, p, count);
+       return 0;
+     }
+  if ((devMode == DEV_DIRECT) && (((uintptr_t) buf % DIRECT_ALIGN) != 0))
+     { struct iovec whole = { .iov_base = buf, .iov_len = count };
+       return rawBounced (true, &whole, 1, n);
+     }
+  if (nFilesS != 0)                              /* the device is striped over several supporting files */
+     { struct iovec whole = { .iov_base = buf, .iov_len = count };
+       return rawStriped (true, &whole, 1, n);
+     }
+
+  while (count > 0)
+  { if ((nb = pwrite (fd, p, count, pos)) == -1)
+       { if (errno == EINTR) continue;
+         return -errno;
+       }
+    if (nb == 0) return -EIO;                    /* no progress */
+    p += nb;
+    pos += nb;
+    count -= nb;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Check the arguments of a vectored transfer of a sequence of successive blocks.
+ *
+ *  \param n physical number of the first block
+ *  \param nBlks number of successive blocks
+ *  \param iov pointer to the scatter / gather list of buffers
+ *  \param iovcnt number of elements of the scatter / gather list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the arguments is invalid
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+static int rawCheckVector (uint32_t n, uint64_t nBlks, const struct iovec *iov, int iovcnt)
+{
+  if ((iov == NULL) || (iovcnt <= 0) || (nBlks == 0))       /* checking for null pointer and empty lists */
+     return -EINVAL;
+  if (((uint64_t) n + nBlks) > bnmax)
+     return -EINVAL;                             /* checking for block numbers */
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+
+  uint64_t total = 0;                            /* total length of the list of buffers */
+  int i;
+
+  for (i = 0; i < iovcnt; i++)
+  { if ((iov[i].iov_base == NULL) && (iov[i].iov_len != 0)) return -EINVAL;
+    total += iov[i].iov_len;
+  }
+  if (total != nBlks * BLOCK_SIZE) return -EINVAL;
+
+  return 0;
+}
+
+/**
+ *  \brief Transfer a sequence of successive blocks between the storage device and a scatter / gather list.
+ *
+ *  If the supporting file is mapped into memory, the data is simply copied from / into the mapping. In \c DEV_DIRECT
+ *  mode, if any of the buffers is not aligned, or its length is not a multiple of the alignment, the whole list is
+ *  transferred through an aligned intermediate buffer. If the device is striped, the transfer is split among the
+ *  supporting files.
+ *
+ *  \param wr \c true, if the blocks are to be written; \c false, if they are to be read
+ *  \param iov pointer to the scatter / gather list of buffers
+ *  \param iovcnt number of elements of the scatter / gather list
+ *  \param n physical number of the first block to be transferred
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EIO, if no progress could be made
+ *  \return -<em>other specific error</em> issued by \e preadv or \e pwritev system calls
+ */
+
+static int rawTransferV (bool wr, const struct iovec *iov, int iovcnt, uint32_t n)
+{
+  off_t pos = (off_t) BLOCK_SIZE * n;            /* current position in the supporting file */
+  int i;
+
+  if (devMap != NULL)                            /* the supporting file is mapped into memory */
+     { for (i = 0; i < iovcnt; i++)
+       { if (wr)
+            memcpy (devMap + pos, iov[i].iov_base, iov[i].iov_len);
+            else memcpy (iov[i].iov_base, devMap + pos, iov[i].iov_len);
+         pos += iov[i].iov_len;
+       }
+       return 0;
+     }
+  if (devMode == DEV_DIRECT)
+     { for (i = 0; i < iovcnt; i++)
+         if ((((uintptr_t) iov[i].iov_base % DIRECT_ALIGN) != 0) || ((iov[i].iov_len % DIRECT_ALIGN) != 0))
+            return rawBounced (wr, iov, iovcnt, n);
+     }
+
+  if (nFilesS != 0)                              /* the device is striped over several supporting files */
+     return rawStriped (wr, iov, iovcnt, n);
+
+  return rawTransferAt (fd, wr, iov, iovcnt, pos);
+}
+
+/**
+ *  \brief Transfer a sequence of successive blocks between a supporting file and a scatter / gather list.
+ *
+ *  The list is processed in batches of at most \c IOV_BATCH elements, each one issued by a single positional vectored
+ *  system call. Short transfers are resumed from the point where they stopped.
+ *
+ *  \param dfd file descriptor of the supporting file
+ *  \param wr \c true, if the blocks are to be written; \c false, if they are to be read
+ *  \param iov pointer to the scatter / gather list of buffers
+ *  \param iovcnt number of elements of the scatter / gather list
+ *  \param pos position in the supporting file
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EIO, if no progress could be made
+ *  \return -<em>other specific error</em> issued by \e preadv or \e pwritev system calls
+ */
+
+static int rawTransferAt (int dfd, bool wr, const struct iovec *iov, int iovcnt, off_t pos)
+{
+  struct iovec batch[IOV_BATCH];                 /* working copy of the batch being transferred */
+  ssize_t nb;                                    /* number of bytes transferred by the last call */
+  int cnt, first;                                /* size and first element of the remaining part of the batch */
+  int i;
+
+  while (iovcnt > 0)
+  { cnt = (iovcnt > IOV_BATCH) ? IOV_BATCH : iovcnt;
+    for (i = 0; i < cnt; i++)
+      batch[i] = iov[i];
+    first = 0;
+    while (first < cnt)
+    { nb = wr ? pwritev (dfd, batch + first, cnt - first, pos) : preadv (dfd, batch + first, cnt - first, pos);
+      if (nb == -1)
+         { if (errno == EINTR) continue;
+           return -errno;
+         }
+      if (nb == 0) return -EIO;                  /* premature end of file or no progress */
+      pos += nb;
+      while ((first < cnt) && ((size_t) nb >= batch[first].iov_len))
+      { nb -= batch[first].iov_len;
+        first += 1;
+      }
+      if (nb > 0)
+         { batch[first].iov_base = (unsigned char *) batch[first].iov_base + nb;
+           batch[first].iov_len -= nb;
+         }
+    }
+    iov += cnt;
+    iovcnt -= cnt;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Transfer a sequence of successive blocks between a striped storage device and a scatter / gather list.
+ *
+ *  The list is split along the stripe units in parts, one per supporting file: since the stripe units of a file which
+ *  belong to a sequence of successive blocks are themselves successive, every part is a single transfer. If only one
+ *  file is involved, the transfer is carried out by the caller; otherwise, the parts are queued to the workers of the
+ *  files and carried out in parallel.
+ *
+ *  \param wr \c true, if the blocks are to be written; \c false, if they are to be read
+ *  \param iov pointer to the scatter / gather list of buffers
+ *  \param iovcnt number of elements of the scatter / gather list
+ *  \param n physical number of the first block to be transferred
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c ENOMEM, if there is no memory for the lists of the parts
+ *  \return -\c EIO, if no progress could be made
+ *  \return -<em>other specific error</em> issued by \e preadv or \e pwritev system calls
+ */
+
+static int rawStriped (bool wr, const struct iovec *iov, int iovcnt, uint32_t n)
+{
+  SOStripeJob job[STRIPE_MAX_FILES];             /* parts of the transfer */
+  int cnt[STRIPE_MAX_FILES] = { 0 };             /* number of elements of the list of each part */
+  size_t unitBytes = (size_t) stripeUnit * BLOCK_SIZE;     /* size of the stripe unit in bytes */
+  uint64_t lpos = (uint64_t) BLOCK_SIZE * n;     /* current position in the storage device */
+  uint64_t total = 0;                            /* total length of the list of buffers */
+  struct iovec *seg;                             /* lists of the parts */
+  size_t cap;                                    /* maximum number of elements of the list of a part */
+  size_t off = 0;                                /* current location in the current buffer */
+  uint32_t pending = 0;                          /* number of parts not yet completed */
+  uint32_t m, last = 0;
+  int stat = 0;                                  /* status of operation */
+  int i;
+
+  for (i = 0; i < iovcnt; i++)
+    total += iov[i].iov_len;
+  cap = iovcnt + ((lpos % unitBytes) + total + unitBytes - 1) / unitBytes;
+  if ((seg = malloc (nFilesS * cap * sizeof (struct iovec))) == NULL) return -ENOMEM;
+
+  /* splitting the list along the stripe units */
+
+  for (i = 0; i < iovcnt; )
+  { uint64_t unit = lpos / unitBytes;            /* stripe unit of the storage device */
+    size_t within = lpos % unitBytes;            /* location in the stripe unit */
+    size_t len = unitBytes - within;             /* length of the element */
+    struct iovec *part;
+
+    m = unit % nFilesS;
+    part = seg + m * cap;
+    if (len > iov[i].iov_len - off) len = iov[i].iov_len - off;
+    if (cnt[m] == 0)
+       job[m].pos = (off_t) (unit / nFilesS) * unitBytes + within;
+    if ((cnt[m] > 0) &&
+        ((unsigned char *) part[cnt[m]-1].iov_base + part[cnt[m]-1].iov_len == (unsigned char *) iov[i].iov_base + off))
+       part[cnt[m]-1].iov_len += len;            /* contiguous in memory to the previous element */
+       else { part[cnt[m]].iov_base = (unsigned char *) iov[i].iov_base + off;
+              part[cnt[m]].iov_len = len;
+              cnt[m] += 1;
+            }
+    lpos += len;
+    off += len;
+    if (off == iov[i].iov_len)
+       { i += 1;
+         off = 0;
+       }
+  }
+
+  for (m = 0; m < nFilesS; m++)
+    if (cnt[m] > 0)
+       { pending += 1;
+         last = m;
+       }
+
+  if (pending == 1)                              /* a single supporting file is involved */
+     stat = rawTransferAt (sfd[last], wr, seg + last * cap, cnt[last], job[last].pos);
+     else { pthread_mutex_lock (&stripeAccess);
+            for (m = 0; m < nFilesS; m++)
+              if (cnt[m] > 0)
+                 { job[m].wr = wr;
+                   job[m].iov = seg + m * cap;
+                   job[m].iovcnt = cnt[m];
+                   job[m].p_pending = &pending;
+                   job[m].p_stat = &stat;
+                   job[m].next = NULL;
+                   if (jobTail[m] != NULL)
+                      jobTail[m]->next = &job[m];
+                      else jobHead[m] = &job[m];
+                   jobTail[m] = &job[m];
+                   pthread_cond_signal (&jobReady[m]);
+                 }
+            while (pending > 0)
+              pthread_cond_wait (&jobDone, &stripeAccess);
+            pthread_mutex_unlock (&stripeAccess);
+          }
+  free (seg);
+
+  return stat;
+}
+
+/**
+ *  \brief Worker of a supporting file of a striped storage device.
+ *
+ *  The transfers queued to the worker are carried out in succession, until the workers are to terminate.
+ *
+ *  \param arg index of the supporting file
+ *
+ *  \return \c NULL
+ */
+
+static void *rawWorker (void *arg)
+{
+  uint32_t m = (uintptr_t) arg;                  /* index of the supporting file */
+  SOStripeJob *job;                              /* transfer being carried out */
+  int stat;                                      /* status of operation */
+
+  pthread_mutex_lock (&stripeAccess);
+  while (true)
+  { while ((jobHead[m] == NULL) && !stopWorkers)
+      pthread_cond_wait (&jobReady[m], &stripeAccess);
+    if ((job = jobHead[m]) == NULL) break;       /* the worker is to terminate */
+    if ((jobHead[m] = job->next) == NULL) jobTail[m] = NULL;
+    pthread_mutex_unlock (&stripeAccess);
+
+    stat = rawTransferAt (sfd[m], job->wr, job->iov, job->iovcnt, job->pos);
+
+    pthread_mutex_lock (&stripeAccess);
+    if ((stat != 0) && (*job->p_stat == 0)) *job->p_stat = stat;
+    *job->p_pending -= 1;
+    if (*job->p_pending == 0) pthread_cond_broadcast (&jobDone);
+  }
+  pthread_mutex_unlock (&stripeAccess);
+
+  return NULL;
+}
+
+/**
+ *  \brief Stop the workers of the supporting files of a striped storage device.
+ *
+ *  The workers finish the transfers already queued before terminating.
+ *
+ *  \param nw number of workers which were started
+ */
+
+static void rawStopWorkers (uint32_t nw)
+{
+  uint32_t m;
+
+  pthread_mutex_lock (&stripeAccess);
+  stopWorkers = true;
+  for (m = 0; m < nw; m++)
+    pthread_cond_signal (&jobReady[m]);
+  pthread_mutex_unlock (&stripeAccess);
+  for (m = 0; m < nw; m++)
+  { pthread_join (worker[m], NULL);
+    pthread_cond_destroy (&jobReady[m]);
+  }
+}
+
+/**
+ *  \brief Flush the supporting files of the storage device.
+ *
+ *  \param dataOnly \c true, if only the data is to be flushed (\e fdatasync); \c false, otherwise (\e fsync)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by \e fdatasync or \e fsync system calls
+ */
+
+static int rawSyncFiles (bool dataOnly)
+{
+  uint32_t m;
+
+  if (nFilesS == 0)
+     return ((dataOnly ? fdatasync (fd) : fsync (fd)) == -1) ? -errno : 0;
+  for (m = 0; m < nFilesS; m++)
+    if ((dataOnly ? fdatasync (sfd[m]) : fsync (sfd[m])) == -1) return -errno;
+
+  return 0;
+}
+
+/**
+ *  \brief Punch a hole in the supporting files of the storage device.
+ *
+ *  If the device is striped, the range is split along the stripe units and a hole is punched in each part.
+ *
+ *  \param n physical number of the first block of the range
+ *  \param nBlks number of blocks of the range
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by \e fallocate system call
+ */
+
+static int rawPunch (uint32_t n, uint32_t nBlks)
+{
+  const int mode = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+  uint32_t len;                                  /* number of blocks of the current part */
+
+  if (nFilesS == 0)
+     return (fallocate (fd, mode, (off_t) BLOCK_SIZE * n, (off_t) BLOCK_SIZE * nBlks) == -1) ? -errno : 0;
+
+  for (; nBlks > 0; n += len, nBlks -= len)
+  { uint32_t unit = n / stripeUnit;              /* stripe unit of the storage device */
+    uint32_t within = n % stripeUnit;            /* location in the stripe unit */
+    off_t pos = ((off_t) (unit / nFilesS) * stripeUnit + within) * BLOCK_SIZE;
+
+    len = stripeUnit - within;
+    if (len > nBlks) len = nBlks;
+    if (fallocate (sfd[unit % nFilesS], mode, pos, (off_t) BLOCK_SIZE * len) == -1) return -errno;
+  }
+
+  return 0;
+}
+
+/**
+ *  \brief Get a pointer to a sequence of successive blocks of a memory mapped storage device.
+ *
+ *  \param n physical number of the first block
+ *  \param nBlks number of blocks of the sequence
+ *  \param p_addr pointer to a location where the pointer to the contents of the first block is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the device was not opened in \c DEV_MMAP mode
+ */
+
+static int rawMap (uint32_t n, uint32_t nBlks, void **p_addr)
+{
+  if (p_addr == NULL) return -EINVAL;            /* checking for null pointer */
+  if (((uint64_t) n + nBlks) > bnmax) return -EINVAL;       /* checking for block number */
+  if (fd == -1) return -EBADF;                   /* checking for device closed state */
+  if (devMap == NULL) return -ENOTSUP;           /* checking for access mode */
 
-  if (lseek (fd, BLOCK_SIZE * n, SEEK_SET) == -1) return -errno;
-  if (write (fd, buf, CLUSTER_SIZE) != CLUSTER_SIZE) return -EIO;
+  *p_addr = devMap + (size_t) BLOCK_SIZE * n;
 
   return 0;
 }
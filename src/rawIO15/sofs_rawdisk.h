@@ -6,16 +6,41 @@
  *  The storage device is presently a Linux file which simulates a magnetic disk.
  *  The following operations are defined:
  *    \li open a communication channel with the storage device
+ *    \li open a communication channel with a storage device striped over several supporting files
  *    \li close the communication channel previously established
  *    \li read a block of data from the storage device
  *    \li write a block of data to the storage device
  *    \li read a cluster of data from the storage device
- *    \li write a cluster of data to the storage device.
+ *    \li write a cluster of data to the storage device
+ *    \li read a sequence of successive clusters of data from the storage device into a scatter list of buffers
+ *    \li write a sequence of successive clusters of data to the storage device from a gather list of buffers
+ *    \li write a sequence of successive blocks of data to the storage device from a gather list of buffers
+ *    \li get a pointer to a block or a cluster of data of a memory mapped storage device
+ *    \li synchronize the storage device, or a range of its blocks, with the supporting file
+ *    \li discard a range of blocks of the storage device, releasing their storage in the supporting file.
  *
  *  \author Artur Carneiro Pereira - September 2007
  *  \author Miguel Oliveira e Silva - September 2009
  *  \author António Rui Borges - July 2010
  *
+ *  \remarks Once the device is opened, read and write operations may be issued concurrently from several threads:
+ *           there is no shared file position.
+ *
+ *  \remarks When the device is opened in \c DEV_MMAP mode, the supporting file is mapped into memory: data transfers
+ *           become memory copies and pointers into the mapping may be handed out, so that clusters can be accessed
+ *           without any copy at all.
+ *
+ *  \remarks Every operation is accounted for in the statistics of the accesses to the raw disk (see sofs_rawstats.h).
+ *
+ *  \remarks A storage device may be striped over several supporting files: successive stripe units are placed in
+ *           successive files, in a round-robin fashion. Transfers which span several files are carried out in
+ *           parallel, by a worker thread per file.
+ *
+ *  \remarks When the device is opened in \c DEV_DIRECT mode, the supporting file is accessed bypassing the kernel page
+ *           cache. Buffers aligned to \c DIRECT_ALIGN bytes are transferred as they are; any other buffer is
+ *           transferred through one of a small set of aligned intermediate buffers, allocated when the device is
+ *           opened.
+ *
  *  \remarks In case an error occurs, all functions return a negative value which is the symmetric of the system error
  *           that better represents the error cause.
  *           (execute command <em>man errno</em> to get the list of system errors)
@@ -25,6 +50,22 @@
 #define SOFS_RAWDISK_H_
 
 #include <stdint.h>
+#include <sys/uio.h>
+
+#include "sofs_const.h"
+
+/** \brief the storage device is accessed through positional read and write system calls */
+#define DEV_STD    0
+/** \brief the supporting file is mapped into memory and the storage device is accessed through the mapping */
+#define DEV_MMAP   1
+/** \brief the storage device is accessed through positional read and write system calls bypassing the page cache */
+#define DEV_DIRECT 2
+
+/** \brief alignment, in bytes, of the buffers which are transferred with no intermediate copy in DEV_DIRECT mode */
+#define DIRECT_ALIGN  BLOCK_SIZE
+
+/** \brief maximum number of supporting files a storage device may be striped over */
+#define STRIPE_MAX_FILES  16
 
 /**
  *  \brief Open the storage device.
@@ -32,6 +73,7 @@
  *  A communication channel is established with the storage device.
  *  It is supposed that no communication channel was previously established.
  *  The Linux file that simulates the storage device must exist and have a size multiple of the block size.
+ *  The device is opened in \c DEV_STD mode.
  *
  *  \param devname absolute path to the Linux file that simulates the storage device
  *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
@@ -40,11 +82,60 @@
  *  \return -\c EINVAL, if \e devname or \e p_bnmax are \c NULL
  *  \return -\c EBUSY, if the device is already opened
  *  \return -\c ELIBBAD, if the supporting file size is invalid
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e open or \e fstat system calls
  */
 
 extern int soOpenDevice (const char *devname, uint32_t *p_bnmax);
 
+/**
+ *  \brief Open the storage device in a given access mode.
+ *
+ *  A communication channel is established with the storage device.
+ *  It is supposed that no communication channel was previously established.
+ *  The Linux file that simulates the storage device must exist and have a size multiple of the block size.
+ *  In \c DEV_MMAP mode, the whole supporting file is mapped into memory. In \c DEV_DIRECT mode, the supporting file is
+ *  opened for direct I/O and the file system that holds it must be able to transfer single blocks that way.
+ *
+ *  \param devname absolute path to the Linux file that simulates the storage device
+ *  \param mode access mode of the storage device (\c DEV_STD, \c DEV_MMAP or \c DEV_DIRECT)
+ *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if \e devname or \e p_bnmax are \c NULL or the access mode is invalid
+ *  \return -\c EBUSY, if the device is already opened
+ *  \return -\c ELIBBAD, if the supporting file size is invalid
+ *  \return -\c ENOTSUP, if direct I/O of single blocks is not supported by the file system
+ *  \return -\c ENOMEM, if there is no memory for the intermediate buffers
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat, \e mmap or \e pread system calls
+ */
+
+extern int soOpenDeviceMode (const char *devname, uint32_t mode, uint32_t *p_bnmax);
+
+/**
+ *  \brief Open a storage device striped over several supporting files.
+ *
+ *  A communication channel is established with the storage device.
+ *  It is supposed that no communication channel was previously established.
+ *  The device is made of successive stripe units placed in the supporting files in a round-robin fashion: stripe unit
+ *  \e k is the unit <em>k / nFiles</em> of file <em>k % nFiles</em>. The files must exist; only as many whole stripe
+ *  units as fit in the smallest of them are used in each one. The device is opened in \c DEV_STD mode and a worker
+ *  thread is started per supporting file.
+ *
+ *  \param nFiles number of supporting files (from 2 up to \c STRIPE_MAX_FILES)
+ *  \param devname array of absolute paths to the Linux files that support the storage device
+ *  \param unit stripe unit (number of clusters)
+ *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the pointers is \c NULL, the <em>number of files</em> is out of range or the
+ *                      <em>stripe unit</em> is zero
+ *  \return -\c EBUSY, if the device is already opened
+ *  \return -\c ELIBBAD, if some supporting file is smaller than a stripe unit
+ *  \return -<em>other specific error</em> issued by \e open, \e fstat or \e pthread_create calls
+ */
+
+extern int soOpenStripedDevice (uint32_t nFiles, const char *devname[], uint32_t unit, uint32_t *p_bnmax);
+
 /**
  *  \brief Close the storage device.
  *
@@ -70,7 +161,7 @@ extern int soCloseDevice (void);
  *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL or the <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on reading
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread system call
  */
 
 extern int soReadRawBlock (uint32_t n, void *buf);
@@ -89,7 +180,7 @@ extern int soReadRawBlock (uint32_t n, void *buf);
  *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
  */
 
 extern int soWriteRawBlock (uint32_t n, void *buf);
@@ -108,7 +199,7 @@ extern int soWriteRawBlock (uint32_t n, void *buf);
  *  \return -\c EINVAL, if the <em>buffer pointer</em> is \c NULL or the <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on reading
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread system call
  */
 
 extern int soReadRawCluster (uint32_t n, void *buf);
@@ -127,9 +218,168 @@ extern int soReadRawCluster (uint32_t n, void *buf);
  *  \return -\c EINVAL, if <em>buffer pointer</em> is \c NULL or <em>block number</em> is out of range
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pwrite system call
  */
 
 extern int soWriteRawCluster (uint32_t n, void *buf);
 
+/**
+ *  \brief Read a sequence of successive clusters of data from the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the first block of the first data cluster to be read, the number of clusters and a scatter
+ *  list of previously allocated buffers are supplied as arguments. The buffers are filled in succession and their
+ *  lengths must add up to the size of the whole sequence of clusters.
+ *  The transfer is carried out, whenever possible, by a single \e preadv system call.
+ *
+ *  \param n physical number of the first block of the first data cluster to be read from
+ *  \param nClust number of successive clusters to be read
+ *  \param iov pointer to the scatter list of buffers where the data must be read into
+ *  \param iovcnt number of elements of the scatter list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>scatter list</em> is \c NULL or empty, its total length does not match the number of
+ *                      clusters or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on reading
+ *  \return -<em>other specific error</em> issued by \e preadv system call
+ */
+
+extern int soReadRawClusters (uint32_t n, uint32_t nClust, const struct iovec *iov, int iovcnt);
+
+/**
+ *  \brief Write a sequence of successive clusters of data to the storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The physical number of the first block of the first data cluster to be written, the number of clusters and a
+ *  gather list of previously allocated buffers are supplied as arguments. The buffers are written in succession and
+ *  their lengths must add up to the size of the whole sequence of clusters.
+ *  The transfer is carried out, whenever possible, by a single \e pwritev system call.
+ *
+ *  \param n physical number of the first block of the first data cluster to be written into
+ *  \param nClust number of successive clusters to be written
+ *  \param iov pointer to the gather list of buffers containing the data to be written from
+ *  \param iovcnt number of elements of the gather list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>gather list</em> is \c NULL or empty, its total length does not match the number of
+ *                      clusters or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwritev system call
+ */
+
+extern int soWriteRawClusters (uint32_t n, uint32_t nClust, const struct iovec *iov, int iovcnt);
+
+/**
+ *  \brief Write a sequence of successive blocks of data to the storage device.
+ *
+ *  The device is organized as a linear array of data blocks.
+ *  The physical number of the first block to be written, the number of blocks and a gather list of previously
+ *  allocated buffers are supplied as arguments. The buffers are written in succession and their lengths must add up
+ *  to the size of the whole sequence of blocks.
+ *  The transfer is carried out, whenever possible, by a single \e pwritev system call.
+ *
+ *  \param n physical number of the first block to be written into
+ *  \param nBlks number of successive blocks to be written
+ *  \param iov pointer to the gather list of buffers containing the data to be written from
+ *  \param iovcnt number of elements of the gather list
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>gather list</em> is \c NULL or empty, its total length does not match the number of
+ *                      blocks or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -<em>other specific error</em> issued by \e pwritev system call
+ */
+
+extern int soWriteRawBlocks (uint32_t n, uint32_t nBlks, const struct iovec *iov, int iovcnt);
+
+/**
+ *  \brief Get a pointer to a block of data of a memory mapped storage device.
+ *
+ *  The pointer refers to the contents of the block in the mapping of the supporting file: the block may be read and
+ *  modified in place. Modifications are flushed to the supporting file when the device is synchronized or closed.
+ *  The pointer is valid while the device remains open.
+ *
+ *  \param n physical number of the data block
+ *  \param p_addr pointer to a location where the pointer to the contents of the block is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the device was not opened in \c DEV_MMAP mode
+ */
+
+extern int soMapRawBlock (uint32_t n, void **p_addr);
+
+/**
+ *  \brief Get a pointer to a cluster of data of a memory mapped storage device.
+ *
+ *  The device is organized as a linear array of data blocks. A cluster is a group of successive blocks.
+ *  The pointer refers to the contents of the cluster in the mapping of the supporting file: the cluster may be read
+ *  and modified in place. Modifications are flushed to the supporting file when the device is synchronized or closed.
+ *  The pointer is valid while the device remains open.
+ *
+ *  \param n physical number of the first block of the data cluster
+ *  \param p_addr pointer to a location where the pointer to the contents of the cluster is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>pointer</em> is \c NULL or the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c ENOTSUP, if the device was not opened in \c DEV_MMAP mode
+ */
+
+extern int soMapRawCluster (uint32_t n, void **p_addr);
+
+/**
+ *  \brief Synchronize a range of blocks of the storage device with the supporting file.
+ *
+ *  In \c DEV_MMAP mode, the pages of the mapping which hold the blocks are flushed by \e msync; otherwise, the data of
+ *  the supporting file is flushed by \e fdatasync.
+ *
+ *  \param n physical number of the first block of the range
+ *  \param nBlks number of blocks of the range
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -<em>other specific error</em> issued by \e msync or \e fdatasync system calls
+ */
+
+extern int soSyncRawRange (uint32_t n, uint32_t nBlks);
+
+/**
+ *  \brief Synchronize the storage device with the supporting file.
+ *
+ *  In \c DEV_MMAP mode, the whole mapping is flushed by \e msync; otherwise, the supporting file is flushed by
+ *  \e fsync.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -<em>other specific error</em> issued by \e msync or \e fsync system calls
+ */
+
+extern int soSyncRawDevice (void);
+
+/**
+ *  \brief Discard a range of blocks of the storage device, releasing their storage in the supporting file.
+ *
+ *  A hole is punched in the supporting file (or files, if the device is striped) by \e fallocate: the size of the
+ *  file is kept, the storage of the blocks is returned to the file system and their contents is read as zeros
+ *  afterwards. Blocks which are only partially covered by a page of the file system hosting the supporting file are
+ *  zeroed, but their storage is kept.
+ *
+ *  \param n physical number of the first block of the range
+ *  \param nBlks number of blocks of the range
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>block number</em> is out of range
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EOPNOTSUPP, if the file system hosting the supporting file does not support punching holes
+ *  \return -<em>other specific error</em> issued by \e fallocate system call
+ */
+
+extern int soDiscardRawRange (uint32_t n, uint32_t nBlks);
+
 #endif /* SOFS_RAWDISK_H_ */
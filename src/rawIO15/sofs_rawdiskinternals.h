@@ -0,0 +1,76 @@
+/**
+ *  \file sofs_rawdiskinternals.h (interface file)
+ *
+ *  \brief Access to the internal state of the raw disk module.
+ *
+ *  One should notice that this module does not stand alone: it supposes a very tight coupling with the raw disk
+ *  implementation and is only meant to be used by the alternative device engines which share its communication
+ *  channel.
+ *
+ *  The following operations are defined:
+ *    \li get the file descriptor and the number of blocks of the storage device
+ *    \li get the access mode of the storage device
+ *    \li read the clock which times the operations
+ *    \li account for a call to an operation of the raw disk module
+ *    \li print the statistics through the probing system.
+ */
+
+#ifndef SOFS_RAWDISKINTERNALS_H_
+#define SOFS_RAWDISKINTERNALS_H_
+
+#include <stdint.h>
+
+/**
+ *  \brief Get the file descriptor and the number of blocks of the storage device.
+ *
+ *  If the storage device is striped over several supporting files, there is no single file descriptor and -1 is
+ *  stored instead.
+ *
+ *  \param p_fd pointer to a location where the file descriptor of the supporting file is to be stored
+ *  \param p_bnmax pointer to a location where the number of blocks of the device is to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if any of the pointers is \c NULL
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+extern int soGetRawDevice (int *p_fd, uint32_t *p_bnmax);
+
+/**
+ *  \brief Get the access mode of the storage device.
+ *
+ *  \return \c DEV_STD, \c DEV_MMAP or \c DEV_DIRECT, on success
+ *  \return -\c EBADF, if the device is not already opened
+ */
+
+extern int soGetRawDeviceMode (void);
+
+/**
+ *  \brief Read the clock which times the operations.
+ *
+ *  \return current value of the monotonic clock (in nanoseconds)
+ */
+
+extern uint64_t soRawStatsClock (void);
+
+/**
+ *  \brief Account for a call to an operation of the raw disk module.
+ *
+ *  \param op operation which was called (RAWOP_*)
+ *  \param n physical number of the first block the operation applied to
+ *  \param nBlks number of blocks the operation applied to
+ *  \param t0 value of the clock when the operation was called
+ *  \param stat status returned by the operation
+ */
+
+extern void soRawStatsRecord (uint32_t op, uint32_t n, uint32_t nBlks, uint64_t t0, int stat);
+
+/**
+ *  \brief Print the statistics through the probing system.
+ *
+ *  The statistics are printed with depth 850.
+ */
+
+extern void soRawStatsDump (void);
+
+#endif /* SOFS_RAWDISKINTERNALS_H_ */
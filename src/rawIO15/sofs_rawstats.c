@@ -0,0 +1,229 @@
+/**
+ *  \file sofs_rawstats.c (implementation file)
+ *
+ *  \brief Statistics of the accesses to the raw disk.
+ *
+ *  Every operation of the raw disk module (see sofs_rawdisk.h) is accounted for: the number of calls with valid
+ *  arguments, the number of those that failed, the number of bytes transferred, the number of transfers which were
+ *  sequential (started at the block following the last one previously transferred) or random, and the time the calls
+ *  took, both as a total and as a histogram on a logarithmic scale.
+ *  The statistics are reset whenever the storage device is opened and are printed through the probing system, with
+ *  depth 850, whenever it is closed.
+ *
+ *  The following operations are defined:
+ *    \li get a copy of the statistics
+ *    \li reset the statistics
+ *    \li print the statistics.
+ *
+ *  \remarks The counters are updated by atomic operations, so that the raw disk operations may go on being issued
+ *           concurrently from several threads.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+
+#include "sofs_const.h"
+#include "sofs_probe.h"
+#include "sofs_rawdiskinternals.h"
+#include "sofs_rawstats.h"
+
+/*
+ *  Internal data structure
+ */
+
+/** \brief statistics of the raw disk module */
+static SORawStats stats;
+/** \brief physical number of the block following the last one transferred */
+static uint32_t nextBlk = 0;
+
+/** \brief names of the operations which are accounted for */
+static const char *opName[RAW_NOPS] = { "read block", "write block", "read cluster", "write cluster",
+                                        "read clusters", "write clusters", "map", "sync",
+                                        "discard", "write blocks" };
+
+/*
+ *  Allusion to internal functions
+ */
+
+static void printStats (FILE *fs);
+
+/**
+ *  \brief Get a copy of the statistics.
+ *
+ *  The statistics remain available after the storage device is closed, until it is opened again.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be copied
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+int soGetRawStats (SORawStats *p_stats)
+{
+  soColorProbe (895, "07;31", "soGetRawStats(%p)\n", p_stats);
+
+  if (p_stats == NULL) return -EINVAL;           /* checking for null pointer */
+
+  const uint64_t *src = (const uint64_t *) &stats;
+  uint64_t *dst = (uint64_t *) p_stats;
+  size_t i;
+
+  for (i = 0; i < sizeof (SORawStats) / sizeof (uint64_t); i++)
+    dst[i] = __atomic_load_n (&src[i], __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+/**
+ *  \brief Reset the statistics.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ */
+
+int soResetRawStats (void)
+{
+  soColorProbe (896, "07;31", "soResetRawStats()\n");
+
+  uint64_t *p = (uint64_t *) &stats;
+  size_t i;
+
+  for (i = 0; i < sizeof (SORawStats) / sizeof (uint64_t); i++)
+    __atomic_store_n (&p[i], 0, __ATOMIC_RELAXED);
+  __atomic_store_n (&nextBlk, 0, __ATOMIC_RELAXED);
+
+  return 0;
+}
+
+/**
+ *  \brief Print the statistics.
+ *
+ *  Only the operations which were called at least once are printed.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the stream is \c NULL
+ */
+
+int soPrintRawStats (FILE *fs)
+{
+  soColorProbe (897, "07;31", "soPrintRawStats(%p)\n", fs);
+
+  if (fs == NULL) return -EINVAL;                /* checking for null pointer */
+
+  printStats (fs);
+
+  return 0;
+}
+
+/**
+ *  \brief Read the clock which times the operations.
+ *
+ *  \return current value of the monotonic clock (in nanoseconds)
+ */
+
+uint64_t soRawStatsClock (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ *  \brief Account for a call to an operation of the raw disk module.
+ *
+ *  \param op operation which was called (RAWOP_*)
+ *  \param n physical number of the first block the operation applied to
+ *  \param nBlks number of blocks the operation applied to
+ *  \param t0 value of the clock when the operation was called
+ *  \param stat status returned by the operation
+ */
+
+void soRawStatsRecord (uint32_t op, uint32_t n, uint32_t nBlks, uint64_t t0, int stat)
+{
+  uint64_t ns = soRawStatsClock () - t0;         /* time taken by the call */
+  SORawOpStats *p;
+  uint64_t max;
+  uint32_t bucket;
+
+  if (op >= RAW_NOPS) return;
+  p = &stats.op[op];
+
+  __atomic_fetch_add (&p->nCalls, 1, __ATOMIC_RELAXED);
+  if (stat != 0)
+     __atomic_fetch_add (&p->nErrors, 1, __ATOMIC_RELAXED);
+     else if ((op <= RAWOP_WRITE_CLUSTERS) || (op == RAWOP_WRITE_BLOCKS))
+             { __atomic_fetch_add (&p->nBytes, (uint64_t) nBlks * BLOCK_SIZE, __ATOMIC_RELAXED);
+               if (__atomic_exchange_n (&nextBlk, n + nBlks, __ATOMIC_RELAXED) == n)
+                  __atomic_fetch_add (&p->nSeq, 1, __ATOMIC_RELAXED);
+                  else __atomic_fetch_add (&p->nRand, 1, __ATOMIC_RELAXED);
+             }
+
+  /* timing */
+
+  __atomic_fetch_add (&p->totalNs, ns, __ATOMIC_RELAXED);
+  max = __atomic_load_n (&p->maxNs, __ATOMIC_RELAXED);
+  while ((ns > max) && !__atomic_compare_exchange_n (&p->maxNs, &max, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) ;
+  bucket = (ns < 2) ? 0 : 63 - __builtin_clzll (ns);
+  if (bucket >= RAW_HIST_BUCKETS) bucket = RAW_HIST_BUCKETS - 1;
+  __atomic_fetch_add (&p->hist[bucket], 1, __ATOMIC_RELAXED);
+}
+
+/**
+ *  \brief Print the statistics through the probing system.
+ *
+ *  The statistics are printed with depth 850.
+ */
+
+void soRawStatsDump (void)
+{
+  char *text = NULL;                             /* the statistics printed as a string */
+  size_t len = 0;
+  FILE *fs;
+
+  if ((fs = open_memstream (&text, &len)) == NULL) return;
+  printStats (fs);
+  fclose (fs);
+  if (len > 0) soProbe (850, "raw disk statistics\n%s", text);
+  free (text);
+}
+
+/**
+ *  \brief Print the statistics.
+ *
+ *  For each operation called at least once, a line with the counters is printed, followed by a line with the non
+ *  empty buckets of the latency histogram, each one identified by the upper bound of the interval it counts (as a power
+ *  of two, in nanoseconds).
+ *
+ *  \param fs the stream where the statistics are to be printed
+ */
+
+static void printStats (FILE *fs)
+{
+  SORawStats s;                                  /* copy of the statistics */
+  uint32_t op, i;
+
+  soGetRawStats (&s);
+  for (op = 0; op < RAW_NOPS; op++)
+  { SORawOpStats *p = &s.op[op];
+
+    if (p->nCalls == 0) continue;
+    fprintf (fs, "%-14s calls %"PRIu64", errors %"PRIu64", bytes %"PRIu64", seq %"PRIu64", rand %"PRIu64
+             ", mean %.1f us, max %.1f us\n", opName[op], p->nCalls, p->nErrors, p->nBytes, p->nSeq, p->nRand,
+             p->totalNs / 1000.0 / p->nCalls, p->maxNs / 1000.0);
+    fprintf (fs, "%-14s", "");
+    for (i = 0; i < RAW_HIST_BUCKETS; i++)
+      if (p->hist[i] != 0)
+         { if (i < RAW_HIST_BUCKETS - 1)
+              fprintf (fs, " <2^%"PRIu32"ns:%"PRIu64, i + 1, p->hist[i]);
+              else fprintf (fs, " >=2^%"PRIu32"ns:%"PRIu64, i, p->hist[i]);
+         }
+    fprintf (fs, "\n");
+  }
+}
@@ -0,0 +1,127 @@
+/**
+ *  \file sofs_rawstats.h (interface file)
+ *
+ *  \brief Statistics of the accesses to the raw disk.
+ *
+ *  Every operation of the raw disk module (see sofs_rawdisk.h) is accounted for: the number of calls with valid
+ *  arguments, the number of those that failed, the number of bytes transferred, the number of transfers which were
+ *  sequential (started at the block following the last one previously transferred) or random, and the time the calls
+ *  took, both as a total and as a histogram on a logarithmic scale.
+ *  The statistics are reset whenever the storage device is opened and are printed through the probing system, with
+ *  depth 850, whenever it is closed.
+ *
+ *  The following operations are defined:
+ *    \li get a copy of the statistics
+ *    \li reset the statistics
+ *    \li print the statistics.
+ *
+ *  \remarks In case an error occurs, all functions return a negative value which is the symmetric of the system error
+ *           that better represents the error cause.
+ *           (execute command <em>man errno</em> to get the list of system errors)
+ */
+
+#ifndef SOFS_RAWSTATS_H_
+#define SOFS_RAWSTATS_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Operations of the raw disk module which are accounted for */
+
+/** \brief read a block of data */
+#define RAWOP_READ_BLOCK       0
+/** \brief write a block of data */
+#define RAWOP_WRITE_BLOCK      1
+/** \brief read a cluster of data */
+#define RAWOP_READ_CLUSTER     2
+/** \brief write a cluster of data */
+#define RAWOP_WRITE_CLUSTER    3
+/** \brief read a sequence of successive clusters of data */
+#define RAWOP_READ_CLUSTERS    4
+/** \brief write a sequence of successive clusters of data */
+#define RAWOP_WRITE_CLUSTERS   5
+/** \brief get a pointer to a block or a cluster of data of a memory mapped device */
+#define RAWOP_MAP              6
+/** \brief synchronize the storage device, or a range of its blocks */
+#define RAWOP_SYNC             7
+/** \brief discard a range of blocks */
+#define RAWOP_DISCARD          8
+/** \brief write a sequence of successive blocks of data */
+#define RAWOP_WRITE_BLOCKS     9
+
+/** \brief number of operations which are accounted for */
+#define RAW_NOPS               10
+
+/** \brief number of buckets of the latency histograms: bucket \e i counts the calls which took
+ *         [2^i, 2^(i+1)[ nanoseconds, the last one counts all the calls which took longer */
+#define RAW_HIST_BUCKETS       32
+
+/**
+ *  \brief Definition of the statistics of an operation of the raw disk module.
+ */
+
+typedef struct soRawOpStats
+{
+   /** \brief number of calls */
+    uint64_t nCalls;
+   /** \brief number of calls which failed */
+    uint64_t nErrors;
+   /** \brief number of bytes transferred by the calls which succeeded */
+    uint64_t nBytes;
+   /** \brief number of calls that started at the block following the last one previously transferred */
+    uint64_t nSeq;
+   /** \brief number of calls that started anywhere else */
+    uint64_t nRand;
+   /** \brief total time taken by the calls (in nanoseconds) */
+    uint64_t totalNs;
+   /** \brief longest time taken by a call (in nanoseconds) */
+    uint64_t maxNs;
+   /** \brief histogram of the time taken by the calls on a logarithmic scale */
+    uint64_t hist[RAW_HIST_BUCKETS];
+} SORawOpStats;
+
+/**
+ *  \brief Definition of the statistics of the raw disk module.
+ */
+
+typedef struct soRawStats
+{
+   /** \brief statistics of each operation, indexed by RAWOP_* */
+    SORawOpStats op[RAW_NOPS];
+} SORawStats;
+
+/**
+ *  \brief Get a copy of the statistics.
+ *
+ *  The statistics remain available after the storage device is closed, until it is opened again.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be copied
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+extern int soGetRawStats (SORawStats *p_stats);
+
+/**
+ *  \brief Reset the statistics.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ */
+
+extern int soResetRawStats (void);
+
+/**
+ *  \brief Print the statistics.
+ *
+ *  Only the operations which were called at least once are printed.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the stream is \c NULL
+ */
+
+extern int soPrintRawStats (FILE *fs);
+
+#endif /* SOFS_RAWSTATS_H_ */
@@ -298,6 +298,16 @@ void printSuperBlock (void *buf)
   if (p_sb->tbfreeclust_tail == NULL_CLUSTER)
      printf ("(nil)\n");
      else printf ("%"PRIu32"\n", p_sb->tbfreeclust_tail);
+
+  /* geometry */
+
+  printf ("Geometry\n");
+  if ((p_sb->block_size == LEGACY_GEOMETRY) && (p_sb->blocks_per_cluster == LEGACY_GEOMETRY))
+     printf ("   Not recorded (block size = %d, number of blocks per cluster = %d)\n",
+             BLOCK_SIZE, BLOCKS_PER_CLUSTER);
+     else { printf ("   Block size (in bytes) = %"PRIu32"\n", p_sb->block_size);
+            printf ("   Number of contiguous blocks in a cluster = %"PRIu32"\n", p_sb->blocks_per_cluster);
+          }
 }
 
 /**
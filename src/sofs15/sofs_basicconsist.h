@@ -119,7 +119,7 @@ extern const char *soGetErrorMessage (int code);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckSuperBlock (SOSuperBlock *p_sb);
@@ -142,7 +142,7 @@ extern int soQCheckSuperBlock (SOSuperBlock *p_sb);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckInT (SOSuperBlock *p_sb);
@@ -167,7 +167,7 @@ extern int soQCheckInT (SOSuperBlock *p_sb);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckDZ (SOSuperBlock *p_sb);
@@ -203,7 +203,7 @@ extern int soQCheckFInode (SOInode *p_inode);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckInodeIU (SOSuperBlock *p_sb, SOInode *p_inode);
@@ -224,7 +224,7 @@ extern int soQCheckInodeIU (SOSuperBlock *p_sb, SOInode *p_inode);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckLRDC (SOSuperBlock *p_sb, SOInode *p_inode);
@@ -249,7 +249,7 @@ extern int soQCheckLRDC (SOSuperBlock *p_sb, SOInode *p_inode);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckStatDC (SOSuperBlock *p_sb, uint32_t nClust, uint32_t *p_stat);
@@ -275,7 +275,7 @@ extern int soQCheckStatDC (SOSuperBlock *p_sb, uint32_t nClust, uint32_t *p_stat
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soQCheckDirCont (SOSuperBlock *p_sb, SOInode *p_inode);
@@ -10,12 +10,14 @@
  *      \li load the contents of the superblock into internal storage
  *      \li get a pointer to the contents of the superblock
  *      \li store the contents of the superblock resident in internal storage to the storage device
+ *      \li write back the contents of the superblock resident in internal storage, if it was stored
  *      \li convert the inode number, which translates to an entry of the inode table, into the logical number (the
  *          ordinal, starting at zero, of the succession blocks that the table of inodes comprises) and the offset of
  *          the block where it is stored
  *      \li load the contents of a specific block of the table of inodes into internal storage
  *      \li get a pointer to the contents of a specific block of the table of inodes
  *      \li store the contents of the block of the table of inodes resident in internal storage to the storage device
+ *      \li write back the blocks of the table of inodes resident in internal storage which were stored
  *      \li convert the index number, which translates to an entry of the references to free data clusters table, into
  *          the logical number (the ordinal, starting at zero, of the succession blocks that the table of references to
  *          free data clusters comprises) and the offset of the block where it is stored
@@ -35,12 +37,17 @@
  *          storage
  *      \li get a pointer to the contents of a specific cluster of the table of direct references to data clusters
  *      \li store the contents of a specific cluster of the table of direct references to data clusters resident in
- *          internal storage to the storage device.
+ *          internal storage to the storage device
+ *      \li set the number of clusters of references of each kind kept in internal storage
+ *      \li get the statistics of the accesses to clusters of references
+ *      \li print the statistics of the accesses to clusters of references.
  *
  *  \author António Rui Borges - August 2010 - August 2012
  */
 
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
 #include <errno.h>
 #include <inttypes.h>
 
@@ -51,6 +58,44 @@
 #include "sofs_inode.h"
 #include "sofs_datacluster.h"
 #include "sofs_direntry.h"
+#include "sofs_basicoper.h"
+
+/** \brief number of blocks of the table of inodes kept in internal storage */
+#define INT_SLOTS  8
+
+/**
+ *  \brief Definition of a slot of the internal storage for blocks of the table of inodes.
+ */
+
+typedef struct soBlockInTSlot
+{
+   /** \brief contents of the block */
+    SOInode inode[IPB];
+   /** \brief the slot holds a block */
+    bool loaded;
+   /** \brief logical block number of the table of inodes */
+    uint32_t nBlk;
+   /** \brief the contents was stored, but was not written back yet */
+    bool dirty;
+   /** \brief time of the last load (sequence number), so that the least recently loaded block is replaced */
+    uint32_t used;
+} SOBlockInTSlot;
+
+/**
+ *  \brief Definition of a slot of the internal storage for clusters of references to data clusters.
+ */
+
+typedef struct soRefClustSlot
+{
+   /** \brief contents of the cluster */
+    SODataClust clust;
+   /** \brief the slot holds a cluster */
+    bool loaded;
+   /** \brief physical number of the cluster */
+    uint32_t nClust;
+   /** \brief time of the last access (sequence number), so that the least recently used cluster is replaced */
+    uint32_t used;
+} SORefClustSlot;
 
 /*
  *  Internal data structure
@@ -65,14 +110,21 @@ static SOSuperBlock sb;
 static int sbLoaded = 0;
 /** \brief status of reading or writing superblock data */
 static int sbError = 0;
-
-/** \brief storage area for one block of the table of inodes */
-static SOInode inode[IPB];
+/** \brief the superblock was stored with a contents which differs from the one of the storage device, but was not
+ *         written back yet */
+static bool sbDirty = false;
+/** \brief contents of the superblock in the storage device (as it was last read or written back) */
+static SOSuperBlock sbDisk;
+
+/** \brief storage area for up to INT_SLOTS blocks of the table of inodes */
+static SOBlockInTSlot inTSlot[INT_SLOTS];
 /** \brief validation area: -2 - an error occurred while reading or writing a data block
  *                          -1 - no block of the table of inodes has been read yet
- *                           * - logical block number of table of inodes that has been read
+ *                           * - slot of the block of the table of inodes that has been read last (the current one)
  */
-static int nBlkInTLoaded = -1;
+static int curInT = -1;
+/** \brief sequence number of the last load of a block of the table of inodes */
+static uint32_t inTClock = 0;
 /** \brief status of reading or writing a data block of the table of inodes */
 static int intError = 0;
 
@@ -86,27 +138,47 @@ static int nBlkFCTLoaded = -1;
 /** \brief status of reading or writing a data block of the table of free data clusters */
 static int fctError = 0;
 
-/** \brief storage area for a cluster of single indirect references to data clusters */
-static SODataClust sngIndRefClust;
+/** \brief storage area for up to REF_SLOTS_MAX clusters of single indirect references to data clusters */
+static SORefClustSlot sngIndSlot[REF_SLOTS_MAX];
 /** \brief validation area: -2 - an error occurred while reading or writing a data cluster
  *                          -1 - no cluster of single indirect references to data clusters has been read yet
- *                           * - physical cluster number of single indirect references to data clusters that has been
- *                               read
+ *                           * - slot of the cluster of single indirect references to data clusters that has been read
+ *                               last (the current one)
  */
-static int nClustSIRef = 0;
+static int curSIRef = -1;
 /** \brief status of reading or writing a cluster of single indirect references to data clusters */
 static int sircError = 0;
 
-/** \brief storage area for a cluster of direct references to data clusters */
-static SODataClust dirRefClust;
+/** \brief storage area for up to REF_SLOTS_MAX clusters of direct references to data clusters */
+static SORefClustSlot dirSlot[REF_SLOTS_MAX];
 /** \brief validation area: -2 - an error occurred while reading or writing a data cluster
  *                          -1 - no cluster of direct references to data clusters has been read yet
- *                           * - physical cluster number of direct references to data clusters that has been read
+ *                           * - slot of the cluster of direct references to data clusters that has been read last
+ *                               (the current one)
  */
-static int nClustDRef = 0;
+static int curDRef = -1;
 /** \brief status of reading or writing a cluster of direct references to data clusters */
 static int drcError = 0;
 
+/** \brief number of slots in use for each kind of cluster of references */
+static uint32_t nRefSlots = REF_SLOTS;
+/** \brief sequence number of the last access to a cluster of references */
+static uint32_t refClock = 0;
+/** \brief statistics of the accesses to clusters of references */
+static SORefClustStats refStats;
+
+/*
+ *  Allusion to internal functions
+ */
+
+static int writeBackSB (void);
+static int writeBackBefore (void);
+static int writeBackInT (SOBlockInTSlot *p_slot);
+static int loadRefClust (SORefClustSlot *slot, uint32_t nClust, uint64_t *p_nHits,
+                         uint64_t *p_nMisses);
+static int writeRefClust (SORefClustSlot *p_slot);
+static double hitRate (uint64_t nHits, uint64_t nMisses);
+
 /**
  *  \brief Load the contents of the superblock into internal storage.
  *
@@ -117,7 +189,7 @@ static int drcError = 0;
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on a previous
  *                       store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soLoadSuperBlock (void)
@@ -130,7 +202,10 @@ int soLoadSuperBlock (void)
   if (sbLoaded == 1) return 0;                   /* superblock has already been read */
   stat = soReadCacheBlock (0, &sb);
   if (stat == 0)
-     sbLoaded = 1;                               /* operation carried out with success */
+     { sbLoaded = 1;                             /* operation carried out with success */
+       sbDisk = sb;
+       soSetCacheRegions (sb.itable_start, sb.tbfreeclust_start, sb.dzone_start);
+     }
      else { sbLoaded = -1;
             sbError = stat;                      /* an error has occurred while reading */
           }
@@ -160,6 +235,14 @@ SOSuperBlock *soGetSuperBlock (void)
 /**
  *  \brief Store the contents of the superblock resident in internal storage to the storage device.
  *
+ *  While the file system is mounted (the superblock is marked \c NPRU, both in internal storage and in the storage
+ *  device), the superblock is only marked as stored, and only if its contents changed: it is written back when the
+ *  superblock is flushed (see soFlushSuperBlock), which the mounting tool does periodically, and before any block of
+ *  the table of inodes, block of the table of references to free data clusters or cluster of references is written,
+ *  since these may refer to the changes. The superblock of the storage device is thus never older than the data
+ *  structures which depend on it. A crash leaves it marked \c NPRU, so that its counters and the ends of the table of
+ *  references to free data clusters are known to be possibly out of date. Otherwise, namely when the file system is
+ *  marked \c PRU, or is marked \c NPRU for the first time, the superblock is written at once.
  *  Any type of previous / current error on loading / storing the superblock data will disable the operation.
  *
  *  \return <tt>0 (zero)</tt>, on success
@@ -167,28 +250,48 @@ SOSuperBlock *soGetSuperBlock (void)
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on the
  *                       current or a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soStoreSuperBlock (void)
 {
   soColorProbe (713, "07;31", "soStoreSuperBlock ()\n");
 
-  int stat;                                      /* status of operation */
-
   if (sbError != 0) return sbError;              /* a previous error has occurred */
   if (sbLoaded == 0)
      { sbLoaded = -1;
        sbError = -ELIBBAD;                       /* superblock has not been read yet */
        return sbError;
      }
-  stat = soWriteCacheBlock (0, &sb);
-  if (stat != 0)
-     { sbLoaded = -1;
-       sbError = stat;                           /* an error has occurred while writing */
+  if ((sb.mstat == NPRU) && (sbDisk.mstat == NPRU)) /* the file system is mounted */
+     { sbDirty = (memcmp (&sb, &sbDisk, sizeof (SOSuperBlock)) != 0); /* it is written back later on */
+       return 0;
      }
 
-  return stat;
+  return writeBackSB ();
+}
+
+/**
+ *  \brief Write back the contents of the superblock resident in internal storage, if it was stored.
+ *
+ *  It must be called when the file system is to be synchronized with the storage device.
+ *  Any type of previous / current error on loading / storing the superblock data will disable the operation.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
+ */
+
+int soFlushSuperBlock (void)
+{
+  soColorProbe (731, "07;31", "soFlushSuperBlock ()\n");
+
+  if (sbError != 0) return sbError;              /* a previous error has occurred */
+  if (!sbDirty) return 0;                        /* the superblock is up to date */
+
+  return writeBackSB ();
 }
 
 /**
@@ -206,7 +309,7 @@ int soStoreSuperBlock (void)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on a previous
  *                       store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soConvertRefInT (uint32_t nInode, uint32_t *p_nBlk, uint32_t *p_offset)
@@ -228,6 +331,9 @@ int soConvertRefInT (uint32_t nInode, uint32_t *p_nBlk, uint32_t *p_offset)
 /**
  *  \brief Load the contents of a specific block of the table of inodes into internal storage.
  *
+ *  The internal storage keeps up to \c INT_SLOTS blocks of the table of inodes, the block which is loaded becoming the
+ *  current one. A block which is already kept is not read again; otherwise, it replaces the block which was least
+ *  recently loaded, whose contents is first written back, if it was stored.
  *  Any type of previous / current error on loading / storing the data block will disable the operation.
  *
  *  \param nBlk logical number of the block to be read
@@ -238,24 +344,51 @@ int soConvertRefInT (uint32_t nInode, uint32_t *p_nBlk, uint32_t *p_offset)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soLoadBlockInT (uint32_t nBlk)
 {
   soColorProbe (715, "07;31", "soLoadBlockInT (%"PRIu32")\n", nBlk);
 
+  SOBlockInTSlot *p_slot;                        /* slot where the block is to be kept */
+  int i;
   int stat;                                      /* status of operation */
 
   if ((stat = soLoadSuperBlock ()) != 0) return stat;
   if (nBlk >= sb.itable_size) return -EINVAL;
 
   if (intError != 0) return intError;            /* a previous error has occurred */
-  if (nBlk == nBlkInTLoaded) return 0;           /* the block has already been read */
-  stat = soReadCacheBlock (sb.itable_start + nBlk, inode);
+  if ((curInT >= 0) && (inTSlot[curInT].nBlk == nBlk)) return 0; /* the block is the current one */
+  for (i = 0; i < INT_SLOTS; i++)
+    if (inTSlot[i].loaded && (inTSlot[i].nBlk == nBlk))
+       { curInT = i;                             /* the block has already been read */
+         inTSlot[i].used = ++inTClock;
+         return 0;
+       }
+
+  p_slot = &inTSlot[0];
+  for (i = 0; i < INT_SLOTS; i++)
+    if (!inTSlot[i].loaded)                      /* an empty slot is used */
+       { p_slot = &inTSlot[i];
+         break;
+       }
+       else if (inTSlot[i].used < p_slot->used)  /* the least recently loaded one is replaced */
+               p_slot = &inTSlot[i];
+  if (p_slot->dirty && ((stat = writeBackInT (p_slot)) != 0))
+     { curInT = -2;
+       intError = stat;                          /* an error has occurred while writing */
+       return stat;
+     }
+  p_slot->loaded = false;
+  stat = soReadCacheBlock (sb.itable_start + nBlk, p_slot->inode);
   if (stat == 0)
-     nBlkInTLoaded = nBlk;                       /* operation carried out with success */
-     else { nBlkInTLoaded = -1;
+     { p_slot->loaded = true;                    /* operation carried out with success */
+       p_slot->nBlk = nBlk;
+       p_slot->used = ++inTClock;
+       curInT = p_slot - inTSlot;
+     }
+     else { curInT = -1;
             intError = stat;                     /* an error has occurred while reading */
           }
 
@@ -265,6 +398,8 @@ int soLoadBlockInT (uint32_t nBlk)
 /**
  *  \brief Get a pointer to the contents of a specific block of the table of inodes.
  *
+ *  The pointer is to the contents of the current block (the one which was last loaded). It stays valid until the block
+ *  is replaced in the internal storage.
  *  Any type of previous / current error on loading / storing the data block will disable the operation.
  *
  *  \return pointer to the specific block , on success
@@ -276,43 +411,72 @@ SOInode *soGetBlockInT (void)
 {
   soColorProbe (716, "07;31", "soGetBlockInT ()\n");
 
-  if (nBlkInTLoaded >= 0)
-     return inode;
+  if (curInT >= 0)
+     return inTSlot[curInT].inode;
      else return NULL;
 }
 
 /**
  *  \brief Store the contents of the block of the table of inodes resident in internal storage to the storage device.
  *
+ *  The current block is only marked as stored: its contents is written back when it is replaced in the internal
+ *  storage, or when the blocks of the table of inodes are flushed (see soFlushBlocksInT), so that successive stores of
+ *  the same block take a single write.
  *  Any type of previous / current error on loading / storing the data block will disable the operation.
  *
  *  \return <tt>0 (zero)</tt>, on success
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no block of the table of inodes was previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soStoreBlockInT (void)
 {
   soColorProbe (717, "07;31", "soStoreBlockInT ()\n");
 
-  int stat;                                      /* status of operation */
-
   if (intError != 0) return intError;            /* a previous error has occurred */
-  if (nBlkInTLoaded < 0)
-     { nBlkInTLoaded = -2;
+  if (curInT < 0)
+     { curInT = -2;
        intError = -ELIBBAD;                      /* no block of the bitmap table of inodes has not been
                                                     read yet */
        return intError;
      }
-  stat = soWriteCacheBlock (sb.itable_start + nBlkInTLoaded, inode);
-  if (stat != 0)
-     { nBlkInTLoaded = -2;
-       intError = stat;                          /* an error has occurred while writing */
-     }
+  inTSlot[curInT].dirty = true;                  /* the block is written back later on */
 
-  return stat;
+  return 0;
+}
+
+/**
+ *  \brief Write back the blocks of the table of inodes resident in internal storage which were stored.
+ *
+ *  It must be called before the blocks of the table of inodes are accessed otherwise than through internal storage,
+ *  namely before they are synchronized with the storage device and before the buffercache is closed.
+ *  Any type of previous / current error on loading / storing the data block will disable the operation.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
+ */
+
+int soFlushBlocksInT (void)
+{
+  soColorProbe (730, "07;31", "soFlushBlocksInT ()\n");
+
+  int i;
+  int stat;                                      /* status of operation */
+
+  if (intError != 0) return intError;            /* a previous error has occurred */
+  for (i = 0; i < INT_SLOTS; i++)
+    if (inTSlot[i].dirty && ((stat = writeBackInT (&inTSlot[i])) != 0))
+       { curInT = -2;
+         intError = stat;                        /* an error has occurred while writing */
+         return stat;
+       }
+
+  return 0;
 }
 
 /**
@@ -330,7 +494,7 @@ int soStoreBlockInT (void)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on a previous
  *                       store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soConvertRefFCT (uint32_t ind, uint32_t *p_nBlk, uint32_t *p_offset)
@@ -362,7 +526,7 @@ int soConvertRefFCT (uint32_t ind, uint32_t *p_nBlk, uint32_t *p_offset)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soLoadBlockFCT (uint32_t nBlk)
@@ -415,7 +579,7 @@ uint32_t *soGetBlockFCT (void)
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no block of the table of inodes was previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soStoreBlockFCT (void)
@@ -431,7 +595,8 @@ int soStoreBlockFCT (void)
                                                     read yet */
        return fctError;
      }
-  stat = soWriteCacheBlock (sb.tbfreeclust_start + nBlkFCTLoaded, ref);
+  if ((stat = writeBackBefore ()) == 0)
+     stat = soWriteCacheBlock (sb.tbfreeclust_start + nBlkFCTLoaded, ref);
   if (stat != 0)
      { nBlkFCTLoaded = -2;
        fctError = stat;                          /* an error has occurred while writing */
@@ -476,6 +641,9 @@ int soConvertBPIDC (uint32_t p, uint32_t *p_clustInd, uint32_t *p_offset)
  *  \brief Load the contents of a specific cluster of the table of single indirect references to data clusters into
  *         internal storage.
  *
+ *  The internal storage keeps up to a configurable number of clusters of single indirect references (see
+ *  soSetRefClustSlots), the cluster which is loaded becoming the current one. A cluster which is already kept is not
+ *  read again; otherwise, it replaces the cluster which was least recently used.
  *  Any type of previous / current error on loading / storing a single indirect references cluster will disable the
  *  operation.
  *
@@ -487,7 +655,7 @@ int soConvertBPIDC (uint32_t p, uint32_t *p_clustInd, uint32_t *p_offset)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soLoadSngIndRefClust (uint32_t nClust)
@@ -502,13 +670,13 @@ int soLoadSngIndRefClust (uint32_t nClust)
      return -EINVAL;
 
   if (sircError != 0) return sircError;          /* a previous error has occurred */
-  if (nClust == nClustSIRef) return 0;           /* the cluster has already been read */
-  stat = soReadCacheCluster (nClust, &sngIndRefClust);
-  if (stat == 0)
-     nClustSIRef = nClust;                       /* operation carried out with success */
-     else { nClustSIRef = -2;
-            sircError = stat;                    /* an error has occurred while reading */
-          }
+  stat = loadRefClust (sngIndSlot, nClust, &refStats.nSIHits, &refStats.nSIMisses);
+  if (stat >= 0)
+     { curSIRef = stat;                          /* operation carried out with success */
+       return 0;
+     }
+  curSIRef = -2;
+  sircError = stat;                              /* an error has occurred while reading */
 
   return stat;
 }
@@ -529,8 +697,8 @@ SODataClust *soGetSngIndRefClust (void)
 {
   soColorProbe (724, "07;31", "soGetSngIndRefClust ()\n");
 
-  if (nClustSIRef >= 0)
-     return &sngIndRefClust;
+  if (curSIRef >= 0)
+     return &sngIndSlot[curSIRef].clust;
      else return NULL;
 }
 
@@ -546,7 +714,7 @@ SODataClust *soGetSngIndRefClust (void)
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no cluster of the table of single indirect references was
  *              previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soStoreSngIndRefClust (void)
@@ -556,16 +724,16 @@ int soStoreSngIndRefClust (void)
   int stat;                                      /* status of operation */
 
   if (sircError != 0) return sircError;          /* a previous error has occurred */
-  if (nClustSIRef < 0)
-     { nClustSIRef = -2;
+  if (curSIRef < 0)
+     { curSIRef = -2;
        sircError = -ELIBBAD;                     /* no cluster of the table of single indirect references has not been
                                                     read yet */
        return sircError;
      }
-  stat = soWriteCacheCluster (nClustSIRef, &sngIndRefClust);
+  stat = writeRefClust (&sngIndSlot[curSIRef]);
   if (stat != 0)
-     { nClustSIRef = -2;
-       sircError = stat;                          /* an error has occurred while writing */
+     { curSIRef = -2;
+       sircError = stat;                         /* an error has occurred while writing */
      }
 
   return stat;
@@ -575,6 +743,9 @@ int soStoreSngIndRefClust (void)
  *  \brief Load the contents of a specific cluster of the table of direct references to data clusters into internal
  *         storage.
  *
+ *  The internal storage keeps up to a configurable number of clusters of direct references (see soSetRefClustSlots),
+ *  the cluster which is loaded becoming the current one. A cluster which is already kept is not read again;
+ *  otherwise, it replaces the cluster which was least recently used.
  *  Any type of previous / current error on loading / storing a direct references cluster will disable the
  *  operation.
  *
@@ -586,7 +757,7 @@ int soStoreSngIndRefClust (void)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soLoadDirRefClust (uint32_t nClust)
@@ -601,13 +772,13 @@ int soLoadDirRefClust (uint32_t nClust)
      return -EINVAL;
 
   if (drcError != 0) return drcError;            /* a previous error has occurred */
-  if (nClust == nClustDRef) return 0;            /* the cluster has already been read */
-  stat = soReadCacheCluster (nClust, &dirRefClust);
-  if (stat == 0)
-	  nClustDRef = nClust;                       /* operation carried out with success */
-     else { nClustDRef = -2;
-            drcError = stat;                     /* an error has occurred while reading */
-          }
+  stat = loadRefClust (dirSlot, nClust, &refStats.nDRHits, &refStats.nDRMisses);
+  if (stat >= 0)
+     { curDRef = stat;                           /* operation carried out with success */
+       return 0;
+     }
+  curDRef = -2;
+  drcError = stat;                               /* an error has occurred while reading */
 
   return stat;
 }
@@ -627,8 +798,8 @@ SODataClust *soGetDirRefClust (void)
 {
   soColorProbe (727, "07;31", "soGetDirRefClust ()\n");
 
-  if (nClustDRef >= 0)
-     return &dirRefClust;
+  if (curDRef >= 0)
+     return &dirSlot[curDRef].clust;
      else return NULL;
 }
 
@@ -644,7 +815,7 @@ SODataClust *soGetDirRefClust (void)
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no cluster of the table of direct references was
  *              previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soStoreDirRefClust (void)
@@ -654,17 +825,253 @@ int soStoreDirRefClust (void)
   int stat;                                      /* status of operation */
 
   if (drcError != 0) return drcError;            /* a previous error has occurred */
-  if (nClustDRef < 0)
-     { nClustDRef = -2;
+  if (curDRef < 0)
+     { curDRef = -2;
        drcError = -ELIBBAD;                      /* no cluster of the table of direct references has not been
                                                     read yet */
        return sircError;
      }
-  stat = soWriteCacheCluster (nClustDRef, &dirRefClust);
+  stat = writeRefClust (&dirSlot[curDRef]);
   if (stat != 0)
-     { nClustDRef = -2;
+     { curDRef = -2;
        drcError = stat;                          /* an error has occurred while writing */
      }
 
   return stat;
 }
+
+/**
+ *  \brief Set the number of clusters of references of each kind kept in internal storage.
+ *
+ *  Up to \e n clusters of single indirect references and \e n clusters of direct references are kept in internal
+ *  storage, so that the clusters of references of large files, or of several files accessed alternately, are not read
+ *  again on every access. The clusters which no longer fit are dropped: their contents was already
+ *  written, since every store operation is carried out at once. The default number is \c REF_SLOTS.
+ *
+ *  \param n number of clusters of each kind
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the number is zero or greater than \c REF_SLOTS_MAX
+ */
+
+int soSetRefClustSlots (uint32_t n)
+{
+  soColorProbe (735, "07;31", "soSetRefClustSlots (%"PRIu32")\n", n);
+
+  uint32_t i;
+
+  if ((n == 0) || (n > REF_SLOTS_MAX)) return -EINVAL;
+  for (i = n; i < REF_SLOTS_MAX; i++)
+  { sngIndSlot[i].loaded = false;
+    dirSlot[i].loaded = false;
+  }
+  if (curSIRef >= (int) n) curSIRef = -1;
+  if (curDRef >= (int) n) curDRef = -1;
+  nRefSlots = n;
+
+  return 0;
+}
+
+/**
+ *  \brief Get the statistics of the accesses to clusters of references.
+ *
+ *  Every load of a cluster of references is a hit, if the cluster is kept in internal storage, or a miss, otherwise.
+ *  The statistics are kept since the process was started.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+int soGetRefClustStats (SORefClustStats *p_stats)
+{
+  soColorProbe (736, "07;31", "soGetRefClustStats (%p)\n", p_stats);
+
+  if (p_stats == NULL) return -EINVAL;
+  *p_stats = refStats;
+
+  return 0;
+}
+
+/**
+ *  \brief Print the statistics of the accesses to clusters of references.
+ *
+ *  A line with the counters and the hit rate is printed for each kind of cluster of references.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the stream is \c NULL
+ */
+
+int soPrintRefClustStats (FILE *fs)
+{
+  soColorProbe (737, "07;31", "soPrintRefClustStats (%p)\n", fs);
+
+  SORefClustStats *p_stats = &refStats;          /* statistics of the accesses */
+
+  if (fs == NULL) return -EINVAL;
+  fprintf (fs, "single indirect references: %"PRIu64" hits, %"PRIu64" misses (%.1f%% hit rate)\n",
+           p_stats->nSIHits, p_stats->nSIMisses, hitRate (p_stats->nSIHits, p_stats->nSIMisses));
+  fprintf (fs, "direct references: %"PRIu64" hits, %"PRIu64" misses (%.1f%% hit rate)\n",
+           p_stats->nDRHits, p_stats->nDRMisses, hitRate (p_stats->nDRHits, p_stats->nDRMisses));
+
+  return 0;
+}
+
+/**
+ *  \brief Write back the contents of the superblock kept in internal storage.
+ *
+ *  The superblock is written through to the storage device, so that it reaches it before any block which depends on
+ *  it and was left changed in the buffercache (see soStoreSuperBlock).
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the buffercache on writing
+ */
+
+static int writeBackSB (void)
+{
+  int stat;                                      /* status of operation */
+
+  stat = soFlushCacheBlock (0, &sb);
+  if (stat != 0)
+     { sbLoaded = -1;
+       sbError = stat;                           /* an error has occurred while writing */
+     }
+     else { sbDirty = false;
+            sbDisk = sb;
+            soSetCacheRegions (sb.itable_start, sb.tbfreeclust_start, sb.dzone_start);
+          }
+
+  return stat;
+}
+
+/**
+ *  \brief Write back the contents of the superblock kept in internal storage, if it was stored, before a data structure
+ *         which may depend on it is written.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the buffercache on writing
+ */
+
+static int writeBackBefore (void)
+{
+  if (sbError != 0) return sbError;              /* a previous error has occurred */
+  if (!sbDirty) return 0;                        /* the superblock is up to date */
+
+  return writeBackSB ();
+}
+
+/**
+ *  \brief Write back the contents of a block of the table of inodes kept in internal storage.
+ *
+ *  The block is written on behalf of no owner, since it holds the inodes of several files (see soSetCacheOwner).
+ *
+ *  \param p_slot pointer to the slot where the block is kept
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the buffercache on writing
+ */
+
+static int writeBackInT (SOBlockInTSlot *p_slot)
+{
+  uint32_t owner;                                /* owner of the changes made by the calling thread */
+  int stat;                                      /* status of operation */
+
+  if ((stat = writeBackBefore ()) != 0) return stat;
+  owner = soSetCacheOwner (CACHE_NO_OWNER);
+  stat = soWriteCacheBlock (sb.itable_start + p_slot->nBlk, p_slot->inode);
+  soSetCacheOwner (owner);
+  if (stat == 0) p_slot->dirty = false;
+
+  return stat;
+}
+
+/**
+ *  \brief Load a cluster of references into a set of slots of the internal storage.
+ *
+ *  If the cluster is not kept in any of the slots in use, it replaces the cluster which was least recently used. The
+ *  cluster is read through the metadata partition of the buffercache (see soSetCacheMetadata).
+ *
+ *  \param slot pointer to the set of slots
+ *  \param nClust physical number of the cluster
+ *  \param p_nHits pointer to the counter of hits
+ *  \param p_nMisses pointer to the counter of misses
+ *
+ *  \return index of the slot where the cluster is kept, on success
+ *  \return -<em>specific error</em> issued by the buffercache on reading
+ */
+
+static int loadRefClust (SORefClustSlot *slot, uint32_t nClust, uint64_t *p_nHits,
+                         uint64_t *p_nMisses)
+{
+  SORefClustSlot *p_slot;                        /* slot where the cluster is to be read */
+  uint32_t i;
+  int stat;                                      /* status of operation */
+
+  for (i = 0; i < nRefSlots; i++)
+    if (slot[i].loaded && (slot[i].nClust == nClust))
+       { slot[i].used = ++refClock;              /* the cluster has already been read */
+         *p_nHits += 1;
+         return i;
+       }
+  *p_nMisses += 1;
+
+  p_slot = &slot[0];
+  for (i = 0; i < nRefSlots; i++)
+    if (!slot[i].loaded)                         /* an empty slot is used */
+       { p_slot = &slot[i];
+         break;
+       }
+       else if (slot[i].used < p_slot->used)     /* the least recently used one is replaced */
+               p_slot = &slot[i];
+  p_slot->loaded = false;
+  soSetCacheMetadata (true);                     /* the cluster is stored in the metadata partition */
+  stat = soReadCacheCluster (nClust, &p_slot->clust);
+  soSetCacheMetadata (false);
+  if (stat != 0) return stat;
+  p_slot->loaded = true;
+  p_slot->nClust = nClust;
+  p_slot->used = ++refClock;
+
+  return p_slot - slot;
+}
+
+/**
+ *  \brief Write the contents of a cluster of references kept in internal storage.
+ *
+ *  The cluster is written at once, through the metadata partition of the buffercache (see soSetCacheMetadata), since
+ *  the clusters of references which are freed are reused by operations that do not go through the internal storage.
+ *
+ *  \param p_slot pointer to the slot where the cluster is kept
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em> issued by the buffercache on writing
+ */
+
+static int writeRefClust (SORefClustSlot *p_slot)
+{
+  int stat;                                      /* status of operation */
+
+  if ((stat = writeBackBefore ()) != 0) return stat;
+  soSetCacheMetadata (true);                     /* the cluster is stored in the metadata partition */
+  stat = soWriteCacheCluster (p_slot->nClust, &p_slot->clust);
+  soSetCacheMetadata (false);
+
+  return stat;
+}
+
+/**
+ *  \brief Compute a hit rate.
+ *
+ *  \param nHits number of hits
+ *  \param nMisses number of misses
+ *
+ *  \return percentage of hits, or <tt>0 (zero)</tt> if there were no accesses
+ */
+
+static double hitRate (uint64_t nHits, uint64_t nMisses)
+{
+  return ((nHits + nMisses) == 0) ? 0.0 : (100.0 * nHits) / (nHits + nMisses);
+}
@@ -10,12 +10,14 @@
  *      \li load the contents of the superblock into internal storage
  *      \li get a pointer to the contents of the superblock
  *      \li store the contents of the superblock resident in internal storage to the storage device
+ *      \li write back the contents of the superblock resident in internal storage, if it was stored
  *      \li convert the inode number, which translates to an entry of the inode table, into the logical number (the
  *          ordinal, starting at zero, of the succession blocks that the table of inodes comprises) and the offset of
  *          the block where it is stored
  *      \li load the contents of a specific block of the table of inodes into internal storage
  *      \li get a pointer to the contents of a specific block of the table of inodes
  *      \li store the contents of the block of the table of inodes resident in internal storage to the storage device
+ *      \li write back the blocks of the table of inodes resident in internal storage which were stored
  *      \li convert the index number, which translates to an entry of the references to free data clusters table, into
  *          the logical number (the ordinal, starting at zero, of the succession blocks that the table of references to
  *          free data clusters comprises) and the offset of the block where it is stored
@@ -35,7 +37,10 @@
  *          storage
  *      \li get a pointer to the contents of a specific cluster of the table of direct references to data clusters
  *      \li store the contents of a specific cluster of the table of direct references to data clusters resident in
- *          internal storage to the storage device.
+ *          internal storage to the storage device
+ *      \li set the number of clusters of references of each kind kept in internal storage
+ *      \li get the statistics of the accesses to clusters of references
+ *      \li print the statistics of the accesses to clusters of references.
  *
  *  \author António Rui Borges - August 2010 - August 2011
  *
@@ -47,11 +52,33 @@
 #ifndef SOFS_BASICOPER_H_
 #define SOFS_BASICOPER_H_
 
+#include <stdio.h>
 #include <stdint.h>
 
 #include "sofs_superblock.h"
 #include "sofs_inode.h"
 
+/** \brief default number of clusters of references of each kind kept in internal storage */
+#define REF_SLOTS      8
+/** \brief maximum number of clusters of references of each kind kept in internal storage */
+#define REF_SLOTS_MAX  32
+
+/**
+ *  \brief Definition of the statistics of the accesses to clusters of references.
+ */
+
+typedef struct soRefClustStats
+{
+   /** \brief number of loads of clusters of single indirect references which were kept in internal storage */
+    uint64_t nSIHits;
+   /** \brief number of loads of clusters of single indirect references which had to be read */
+    uint64_t nSIMisses;
+   /** \brief number of loads of clusters of direct references which were kept in internal storage */
+    uint64_t nDRHits;
+   /** \brief number of loads of clusters of direct references which had to be read */
+    uint64_t nDRMisses;
+} SORefClustStats;
+
 /**
  *  \brief Load the contents of the superblock into internal storage.
  *
@@ -62,7 +89,7 @@
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on a previous
  *                       store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soLoadSuperBlock (void);
@@ -82,6 +109,14 @@ extern SOSuperBlock *soGetSuperBlock (void);
 /**
  *  \brief Store the contents of the superblock resident in internal storage to the storage device.
  *
+ *  While the file system is mounted (the superblock is marked \c NPRU, both in internal storage and in the storage
+ *  device), the superblock is only marked as stored, and only if its contents changed: it is written back when the
+ *  superblock is flushed (see soFlushSuperBlock), which the mounting tool does periodically, and before any block of
+ *  the table of inodes, block of the table of references to free data clusters or cluster of references is written,
+ *  since these may refer to the changes. The superblock of the storage device is thus never older than the data
+ *  structures which depend on it. A crash leaves it marked \c NPRU, so that its counters and the ends of the table of
+ *  references to free data clusters are known to be possibly out of date. Otherwise, namely when the file system is
+ *  marked \c PRU, or is marked \c NPRU for the first time, the superblock is written at once.
  *  Any type of previous / current error on loading / storing the superblock data will disable the operation.
  *
  *  \return <tt>0 (zero)</tt>, on success
@@ -89,11 +124,26 @@ extern SOSuperBlock *soGetSuperBlock (void);
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on the
  *                       current or a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soStoreSuperBlock (void);
 
+/**
+ *  \brief Write back the contents of the superblock resident in internal storage, if it was stored.
+ *
+ *  It must be called when the file system is to be synchronized with the storage device.
+ *  Any type of previous / current error on loading / storing the superblock data will disable the operation.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
+ */
+
+extern int soFlushSuperBlock (void);
+
 /**
  *  \brief Convert the inode number, which translates to an entry of the inode table, into the logical number (the
  *         ordinal, starting at zero, of the succession blocks that the table of inodes comprises) and the offset of
@@ -109,7 +159,7 @@ extern int soStoreSuperBlock (void);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on a previous
  *                       store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soConvertRefInT (uint32_t nInode, uint32_t *p_nBlk, uint32_t *p_offset);
@@ -117,6 +167,9 @@ extern int soConvertRefInT (uint32_t nInode, uint32_t *p_nBlk, uint32_t *p_offse
 /**
  *  \brief Load the contents of a specific block of the table of inodes into internal storage.
  *
+ *  The internal storage keeps up to \c INT_SLOTS blocks of the table of inodes, the block which is loaded becoming the
+ *  current one. A block which is already kept is not read again; otherwise, it replaces the block which was least
+ *  recently loaded, whose contents is first written back, if it was stored.
  *  Any type of previous / current error on loading / storing the data block will disable the operation.
  *
  *  \param nBlk logical number of the block to be read
@@ -127,7 +180,7 @@ extern int soConvertRefInT (uint32_t nInode, uint32_t *p_nBlk, uint32_t *p_offse
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soLoadBlockInT (uint32_t nBlk);
@@ -135,6 +188,8 @@ extern int soLoadBlockInT (uint32_t nBlk);
 /**
  *  \brief Get a pointer to the contents of a specific block of the table of inodes.
  *
+ *  The pointer is to the contents of the current block (the one which was last loaded). It stays valid until the block
+ *  is replaced in the internal storage.
  *  Any type of previous / current error on loading / storing the data block will disable the operation.
  *
  *  \return pointer to the specific block , on success
@@ -147,17 +202,36 @@ extern SOInode *soGetBlockInT (void);
 /**
  *  \brief Store the contents of the block of the table of inodes resident in internal storage to the storage device.
  *
+ *  The current block is only marked as stored: its contents is written back when it is replaced in the internal
+ *  storage, or when the blocks of the table of inodes are flushed (see soFlushBlocksInT), so that successive stores of
+ *  the same block take a single write.
  *  Any type of previous / current error on loading / storing the data block will disable the operation.
  *
  *  \return <tt>0 (zero)</tt>, on success
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no block of the table of inodes was previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soStoreBlockInT (void);
 
+/**
+ *  \brief Write back the blocks of the table of inodes resident in internal storage which were stored.
+ *
+ *  It must be called before the blocks of the table of inodes are accessed otherwise than through internal storage,
+ *  namely before they are synchronized with the storage device and before the buffercache is closed.
+ *  Any type of previous / current error on loading / storing the data block will disable the operation.
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails on writing
+ *  \return -\c ELIBBAD, if the buffercache is inconsistent
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
+ */
+
+extern int soFlushBlocksInT (void);
+
 /**
  *  \brief Convert the index number, which translates to an entry of the references to free data clusters table, into the
  *         logical number (the ordinal, starting at zero, of the succession blocks that the table of references to free
@@ -173,7 +247,7 @@ extern int soStoreBlockInT (void);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock was not previously loaded on a previous
  *                       store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soConvertRefFCT (uint32_t ind, uint32_t *p_nBlk, uint32_t *p_offset);
@@ -191,7 +265,7 @@ extern int soConvertRefFCT (uint32_t ind, uint32_t *p_nBlk, uint32_t *p_offset);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soLoadBlockFCT (uint32_t nBlk);
@@ -218,7 +292,7 @@ extern uint32_t *soGetBlockFCT (void);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no block of the table of inodes was previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soStoreBlockFCT (void);
@@ -248,6 +322,9 @@ extern int soConvertBPIDC (uint32_t p, uint32_t *p_clustInd, uint32_t *p_offset)
  *  \brief Load the contents of a specific cluster of the table of single indirect references to data clusters into
  *         internal storage.
  *
+ *  The internal storage keeps up to a configurable number of clusters of single indirect references (see
+ *  soSetRefClustSlots), the cluster which is loaded becoming the current one. A cluster which is already kept is not
+ *  read again; otherwise, it replaces the cluster which was least recently used.
  *  Any type of previous / current error on loading / storing a single indirect references cluster will disable the
  *  operation.
  *
@@ -259,7 +336,7 @@ extern int soConvertBPIDC (uint32_t p, uint32_t *p_clustInd, uint32_t *p_offset)
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soLoadSngIndRefClust (uint32_t nClust);
@@ -290,7 +367,7 @@ extern SODataClust *soGetSngIndRefClust (void);
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no cluster of the table of single indirect references was
  *              previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soStoreSngIndRefClust (void);
@@ -299,6 +376,9 @@ extern int soStoreSngIndRefClust (void);
  *  \brief Load the contents of a specific cluster of the table of direct references to data clusters into internal
  *         storage.
  *
+ *  The internal storage keeps up to a configurable number of clusters of direct references (see soSetRefClustSlots),
+ *  the cluster which is loaded becoming the current one. A cluster which is already kept is not read again;
+ *  otherwise, it replaces the cluster which was least recently used.
  *  Any type of previous / current error on loading / storing a direct references cluster will disable the
  *  operation.
  *
@@ -310,7 +390,7 @@ extern int soStoreSngIndRefClust (void);
  *  \return -\c EIO, if it fails on reading or writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or the superblock or a data block was not previously loaded
  *                       on a previous store operation
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soLoadDirRefClust (uint32_t nClust);
@@ -340,9 +420,52 @@ extern SODataClust *soGetDirRefClust (void);
  *  \return -\c EIO, if it fails on writing
  *  \return -\c ELIBBAD, if the buffercache is inconsistent or no cluster of the table of direct references was
  *              previously loaded
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soStoreDirRefClust (void);
 
+/**
+ *  \brief Set the number of clusters of references of each kind kept in internal storage.
+ *
+ *  Up to \e n clusters of single indirect references and \e n clusters of direct references are kept in internal
+ *  storage, so that the clusters of references of large files, or of several files accessed alternately, are not read
+ *  again on every access. The clusters which no longer fit are dropped: their contents was already
+ *  written, since every store operation is carried out at once. The default number is \c REF_SLOTS.
+ *
+ *  \param n number of clusters of each kind
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the number is zero or greater than \c REF_SLOTS_MAX
+ */
+
+extern int soSetRefClustSlots (uint32_t n);
+
+/**
+ *  \brief Get the statistics of the accesses to clusters of references.
+ *
+ *  Every load of a cluster of references is a hit, if the cluster is kept in internal storage, or a miss, otherwise.
+ *  The statistics are kept since the process was started.
+ *
+ *  \param p_stats pointer to a location where the statistics are to be stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the pointer is \c NULL
+ */
+
+extern int soGetRefClustStats (SORefClustStats *p_stats);
+
+/**
+ *  \brief Print the statistics of the accesses to clusters of references.
+ *
+ *  A line with the counters and the hit rate is printed for each kind of cluster of references.
+ *
+ *  \param fs the stream where the statistics are to be printed
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the stream is \c NULL
+ */
+
+extern int soPrintRefClustStats (FILE *fs);
+
 #endif /* SOFS_BASICOPER_H_ */
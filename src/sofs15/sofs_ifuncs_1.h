@@ -52,7 +52,7 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soAllocInode (uint32_t type, uint32_t* p_nInode);
@@ -83,7 +83,7 @@ extern int soAllocInode (uint32_t type, uint32_t* p_nInode);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soFreeInode (uint32_t nInode);
@@ -105,7 +105,7 @@ extern int soFreeInode (uint32_t nInode);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soAllocDataCluster (uint32_t *p_nClust);
@@ -129,7 +129,7 @@ extern int soAllocDataCluster (uint32_t *p_nClust);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soFreeDataCluster (uint32_t nClust);
@@ -41,7 +41,7 @@ int soDeplete (SOSuperBlock *p_sb);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 
@@ -110,7 +110,7 @@ int soAllocDataCluster (uint32_t *p_nClust)
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soReplenish (SOSuperBlock *p_sb)
@@ -5,6 +5,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <time.h>
@@ -22,6 +23,8 @@
 /* Allusion to internal functions */
 
 int soDeplete (SOSuperBlock *p_sb);
+static int soDiscardDepleted (SOSuperBlock *p_sb);
+static int cmpRef (const void *a, const void *b);
 
 /**
  *  \brief Free the referenced data cluster.
@@ -42,7 +45,7 @@ int soDeplete (SOSuperBlock *p_sb);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soFreeDataCluster (uint32_t nClust)
@@ -76,13 +79,16 @@ int soFreeDataCluster (uint32_t nClust)
 /**
  *  \brief Deplete the insertion cache of references to free data clusters.
  *
+ *  In discard mode (see soSetDiscardMode), the storage of the data clusters whose references are in the cache is
+ *  released before they are transferred to the table of references to free data clusters.
+ *
  *  \param p_sb pointer to a buffer where the superblock data is stored
  *
  *  \return <tt>0 (zero)</tt>, on success
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soDeplete (SOSuperBlock *p_sb)
@@ -94,6 +100,9 @@ int soDeplete (SOSuperBlock *p_sb)
   	uint32_t *ref;								// ponteiro para o bloco de referencias
   	uint32_t status;							// variavel de erro
 
+  	if (soGetDiscardMode () && ((status = soDiscardDepleted (p_sb)) != 0))
+  		return status;
+
   	index = p_sb->tbfreeclust_tail;				// index do array de elementos da tabela de referências de free data clusters
 
   	for (n = 0; n < p_sb->dzone_insert.cache_idx; n++)
@@ -128,3 +137,50 @@ int soDeplete (SOSuperBlock *p_sb)
 
 	return 0;
 }
+
+/**
+ *  \brief Release the storage of the data clusters whose references are in the insertion cache.
+ *
+ *  The references are sorted, so that runs of successive data clusters are released by a single operation.
+ *  The release is only advisory: if the storage device does not support it, nothing is done.
+ *
+ *  \param p_sb pointer to a buffer where the superblock data is stored
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -<em>other specific error</em> issued by \e fallocate system call
+ */
+
+static int soDiscardDepleted (SOSuperBlock *p_sb)
+{
+	uint32_t ref[DZONE_CACHE_SIZE];				// sorted copy of the references in the cache
+	uint32_t n, first;
+	int status;
+
+	for (n = 0; n < p_sb->dzone_insert.cache_idx; n++)
+		ref[n] = p_sb->dzone_insert.cache[n];
+	qsort (ref, p_sb->dzone_insert.cache_idx, sizeof (uint32_t), cmpRef);
+
+	for (first = 0; first < p_sb->dzone_insert.cache_idx; first = n)
+	{
+		// extend the run while the references are successive
+		for (n = first + 1; (n < p_sb->dzone_insert.cache_idx) && (ref[n] == ref[n-1] + 1); n++) ;
+
+		status = soDiscardCacheClusters (p_sb->dzone_start + ref[first] * BLOCKS_PER_CLUSTER, n - first);
+		if (status == -EOPNOTSUPP) return 0;	// the device does not support it
+		if (status != 0) return status;
+	}
+
+	return 0;
+}
+
+/**
+ *  \brief Compare two references to data clusters (qsort).
+ */
+
+static int cmpRef (const void *a, const void *b)
+{
+	uint32_t ra = *(const uint32_t *) a, rb = *(const uint32_t *) b;
+
+	return (ra > rb) - (ra < rb);
+}
@@ -49,7 +49,7 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soReadInode (SOInode *p_inode, uint32_t nInode);
@@ -71,7 +71,7 @@ extern int soReadInode (SOInode *p_inode, uint32_t nInode);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soWriteInode (SOInode *p_inode, uint32_t nInode);
@@ -98,7 +98,7 @@ extern int soWriteInode (SOInode *p_inode, uint32_t nInode);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soAccessGranted (uint32_t nInode, uint32_t opRequested);
@@ -51,7 +51,7 @@ int soReadInode (SOInode *p_inode, uint32_t nInode);
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soAccessGranted (uint32_t nInode, uint32_t opRequested)
@@ -7,6 +7,7 @@
  *
  *  The operations are:
  *      \li read a specific data cluster
+ *      \li read a sequence of successive data clusters
  *      \li write to a specific data cluster
  *      \li handle a file data cluster
  *      \li free all data clusters from the list of references starting at a given point.
@@ -58,11 +59,42 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soReadFileCluster (uint32_t nInode, uint32_t clustInd, void *buff);
 
+/**
+ *  \brief Read a sequence of successive data clusters.
+ *
+ *  Data is read from a sequence of successive data clusters of the data continuum of a file (a regular file, a
+ *  directory or a symbolic link), starting at the data cluster whose index to the list of direct references is given.
+ *  Thus, the inode must be in use and belong to one of the legal file types.
+ *
+ *  Data clusters which are physically adjacent in the data zone are grouped together and each group is read from the
+ *  buffercache in a single operation. Data clusters which have not been allocated yet will consist of a byte stream
+ *  filled with the character null (ascii code 0).
+ *
+ *  \param nInode number of the inode associated to the file
+ *  \param clustInd index to the list of direct references belonging to the inode where the reference to the first data
+ *                  cluster whose contents is to be read is stored
+ *  \param nClust number of data clusters to be read
+ *  \param buff pointer to the buffer where data must be read into (it must be large enough to hold all of them)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>inode number</em> or the <em>index to the list of direct references</em> are out of
+ *                      range, the <em>number of data clusters</em> is zero or the <em>pointer to the buffer area</em>
+ *                      is \c NULL
+ *  \return -\c EIUININVAL, if the inode in use is inconsistent
+ *  \return -\c ELDCININVAL, if the list of data cluster references belonging to an inode is inconsistent
+ *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails reading or writing
+ *  \return -<em>other specific error</em> issued by \e preadv, \e pread or \e pwrite system calls
+ */
+
+extern int soReadFileClusters (uint32_t nInode, uint32_t clustInd, uint32_t nClust, void *buff);
+
 /**
  *  \brief Write a specific data cluster.
  *
@@ -86,7 +118,7 @@ extern int soReadFileCluster (uint32_t nInode, uint32_t clustInd, void *buff);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soWriteFileCluster (uint32_t nInode, uint32_t clustInd, void *buff);
@@ -130,7 +162,7 @@ extern int soWriteFileCluster (uint32_t nInode, uint32_t clustInd, void *buff);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soHandleFileCluster (uint32_t nInode, uint32_t clustInd, uint32_t op, uint32_t *p_outVal);
@@ -161,7 +193,7 @@ extern int soHandleFileCluster (uint32_t nInode, uint32_t clustInd, uint32_t op,
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 extern int soHandleFileClusters (uint32_t nInode, uint32_t clustIndIn);
@@ -126,7 +126,7 @@ int soHandleDIndirect (SOSuperBlock *p_sb, SOInode *p_inode, uint32_t nClust, ui
 
  *  \return -\c EIO, if it fails reading or writing
 
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
 
  */
 
@@ -201,9 +201,9 @@ int soHandleFileCluster (uint32_t nInode, uint32_t clustInd, uint32_t op, uint32
     //writes the inode 
     if ((status = soWriteInode(&iNode,nInode)) != 0)
         return status;
-    }
-    //Stores the contents of the superblock into internal storage
+    //Stores the contents of the superblock into internal storage (a GET leaves it unchanged)
     if ((status = soStoreSuperBlock()) != 0) return status;
+    }
     
     //SUCCESS
     return 0;
@@ -243,7 +243,7 @@ int soHandleFileCluster (uint32_t nInode, uint32_t clustInd, uint32_t op, uint32
 
  *  \return -\c EIO, if it fails reading or writing
 
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
 
  */
 
@@ -339,7 +339,7 @@ int soHandleDirect (SOSuperBlock *p_sb, SOInode *p_inode, uint32_t clustInd, uin
 
  *  \return -\c EIO, if it fails reading or writing
 
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
 
  */
 
@@ -532,7 +532,7 @@ int soHandleSIndirect (SOSuperBlock *p_sb, SOInode *p_inode, uint32_t clustInd,
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soHandleDIndirect (SOSuperBlock *p_sb, SOInode *p_inode, uint32_t clustInd, uint32_t op, uint32_t *p_outVal)
@@ -54,7 +54,7 @@ int directas(SOInode* p_Inode, uint32_t* i, uint32_t nInode);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soHandleFileClusters (uint32_t nInode, uint32_t clustIndIn){
@@ -53,7 +53,7 @@ int soHandleFileCluster (uint32_t nInode, uint32_t clustInd, uint32_t op, uint32
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soReadFileCluster (uint32_t nInode, uint32_t clustInd, void *buff)
@@ -98,10 +98,8 @@ int stat;								//usado em testes
 	if ((stat = soLoadDirRefClust(p_sb->dzone_start + logicClust * BLOCKS_PER_CLUSTER)) != 0) return stat;
 	SODataClust *data = soGetDirRefClust();	*/
 
-	SODataClust data;
-	if((stat = soReadCacheCluster(p_sb->dzone_start + logicClust * BLOCKS_PER_CLUSTER, &data)) != 0)	// reads data cluster from buffercache to the data cluster created
+	if((stat = soReadCacheCluster(p_sb->dzone_start + logicClust * BLOCKS_PER_CLUSTER, buff)) != 0)	// reads data cluster from buffercache straight into the buffer
       return stat;
-	memcpy(buff, data.data, CLUSTER_SIZE);
 
 	return 0;
 
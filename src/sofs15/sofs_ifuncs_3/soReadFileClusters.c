@@ -0,0 +1,99 @@
+/**
+ *  \file soReadFileClusters.c (implementation file)
+ *
+ *  \author ---
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+
+#include "sofs_probe.h"
+#include "sofs_buffercache.h"
+#include "sofs_superblock.h"
+#include "sofs_inode.h"
+#include "sofs_datacluster.h"
+#include "sofs_basicoper.h"
+#include "sofs_basicconsist.h"
+#include "sofs_ifuncs_1.h"
+#include "sofs_ifuncs_2.h"
+#include "sofs_ifuncs_3.h"
+
+/**
+ *  \brief Read a sequence of successive data clusters.
+ *
+ *  Data is read from a sequence of successive data clusters of the data continuum of a file (a regular file, a
+ *  directory or a symbolic link), starting at the data cluster whose index to the list of direct references is given.
+ *  Thus, the inode must be in use and belong to one of the legal file types.
+ *
+ *  Data clusters which are physically adjacent in the data zone are grouped together and each group is read from the
+ *  buffercache in a single operation. Data clusters which have not been allocated yet will consist of a byte stream
+ *  filled with the character null (ascii code 0).
+ *
+ *  \param nInode number of the inode associated to the file
+ *  \param clustInd index to the list of direct references belonging to the inode where the reference to the first data
+ *                  cluster whose contents is to be read is stored
+ *  \param nClust number of data clusters to be read
+ *  \param buff pointer to the buffer where data must be read into (it must be large enough to hold all of them)
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -\c EINVAL, if the <em>inode number</em> or the <em>index to the list of direct references</em> are out of
+ *                      range, the <em>number of data clusters</em> is zero or the <em>pointer to the buffer area</em>
+ *                      is \c NULL
+ *  \return -\c EIUININVAL, if the inode in use is inconsistent
+ *  \return -\c ELDCININVAL, if the list of data cluster references belonging to an inode is inconsistent
+ *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
+ *  \return -\c EBADF, if the device is not already opened
+ *  \return -\c EIO, if it fails reading or writing
+ *  \return -<em>other specific error</em> issued by \e preadv, \e pread or \e pwrite system calls
+ */
+
+int soReadFileClusters (uint32_t nInode, uint32_t clustInd, uint32_t nClust, void *buff)
+{
+  soColorProbe (415, "07;31", "soReadFileClusters (%"PRIu32", %"PRIu32", %"PRIu32", %p)\n",
+                nInode, clustInd, nClust, buff);
+
+  SOSuperBlock *p_sb;                            /* pointer to the superblock */
+  unsigned char *p = buff;                       /* location in the buffer of the first cluster of the current group */
+  uint32_t first;                                /* logical number of the first data cluster of the current group */
+  uint32_t run;                                  /* number of data clusters of the current group */
+  uint32_t logicClust;                           /* logical number of the data cluster under inspection */
+  int stat;                                      /* status of operation */
+
+  if ((buff == NULL) || (nClust == 0) || (clustInd >= MAX_FILE_CLUSTERS) ||
+      (nClust > MAX_FILE_CLUSTERS - clustInd))
+     return -EINVAL;
+  if ((stat = soLoadSuperBlock ()) != 0) return stat;
+  if ((p_sb = soGetSuperBlock ()) == NULL) return -ELIBBAD;
+
+  first = NULL_CLUSTER;
+  run = 0;
+  while (nClust > 0)
+  { if ((stat = soHandleFileCluster (nInode, clustInd, GET, &logicClust)) != 0) return stat;
+
+    /* close the current group if the data cluster is not physically adjacent to it */
+
+    if ((run > 0) && ((logicClust == NULL_CLUSTER) || (logicClust != first + run)))
+       { if ((stat = soReadCacheClusters (p_sb->dzone_start + first * BLOCKS_PER_CLUSTER, run, p)) != 0)
+            return stat;
+         p += run * CLUSTER_SIZE;
+         run = 0;
+       }
+
+    if (logicClust == NULL_CLUSTER)
+       { memset (p, '\0', CLUSTER_SIZE);         /* the data cluster has not been allocated yet */
+         p += CLUSTER_SIZE;
+       }
+       else { if (run == 0) first = logicClust;
+              run += 1;
+            }
+    clustInd += 1;
+    nClust -= 1;
+  }
+  if ((run > 0) &&
+      ((stat = soReadCacheClusters (p_sb->dzone_start + first * BLOCKS_PER_CLUSTER, run, p)) != 0))
+     return stat;
+
+  return 0;
+}
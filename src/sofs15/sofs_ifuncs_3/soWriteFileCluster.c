@@ -52,7 +52,7 @@ extern void *memcpy(void *dest, void *src, size_t count);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soWriteFileCluster (uint32_t nInode, uint32_t clustInd, void *buff)
@@ -60,11 +60,9 @@ int soWriteFileCluster (uint32_t nInode, uint32_t clustInd, void *buff)
   soColorProbe (412, "07;31", "soWriteFileCluster (%"PRIu32", %"PRIu32", %p)\n", nInode, clustInd, buff);
 
   SOSuperBlock *p_sb;     /*pointer to superblock*/
-  SODataClust datcl;      /*data cluster*/
   SOInode inode;        /*inode*/
   uint32_t nClust;      /*cluster number*/
   int stat;         /*status of operation*/
-  int i;            /*for loop*/
   
   /*load superblock*/
   if ((stat = soLoadSuperBlock()) != 0)
@@ -94,10 +92,8 @@ int soWriteFileCluster (uint32_t nInode, uint32_t clustInd, void *buff)
     if ((stat = soHandleFileCluster(nInode,clustInd,ALLOC,&nClust)) != 0)
       return stat;
         
-  for (i=0 ; i<BSLPC ; i++)
-    datcl.data[i] = ((char*)buff)[i];
-      
-  if ((stat = soWriteCacheCluster(p_sb->dzone_start+(nClust*BLOCKS_PER_CLUSTER),&datcl)) != 0)
+  /*write the cluster straight from the buffer*/
+  if ((stat = soWriteCacheCluster(p_sb->dzone_start+(nClust*BLOCKS_PER_CLUSTER),buff)) != 0)
     return stat;
   
   /*Update times*/  
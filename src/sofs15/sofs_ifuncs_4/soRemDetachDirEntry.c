@@ -79,7 +79,7 @@ int soCheckDirectoryEmptiness (uint32_t nInodeDir);
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails reading or writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
  
 int soRemDetachDirEntry (uint32_t nInodeDir, const char *eName, uint32_t op)
@@ -38,6 +38,10 @@
 /** \brief size of cache */
 #define DZONE_CACHE_SIZE  (50)
 
+/** \brief contents of the geometry fields of a superblock formatted before the geometry was recorded (they were part
+ *         of the reserved area, which is filled with 0xEE bytes); such a file system has the fixed geometry */
+#define LEGACY_GEOMETRY ((uint32_t) 0xEEEEEEEE)
+
 /**
  *  \brief Definition of the reference cache data type.
  *
@@ -70,7 +74,10 @@ struct fCNode
  *         storage of references (static structures resident within the superblock itself) and the location and size in
  *         number of blocks of the table of references to free data clusters, organized as a static linear FIFO that
  *         links together all the free data clusters whose references are not in the caches - the insertion and retrieval
- *         points are also provided.
+ *         points are also provided
+ *     \li <em>geometry</em> - the block size and the number of blocks per cluster the file system was formatted with
+ *         (they are placed after the remaining fields, in what used to be the reserved area, so that the location of
+ *         every other field is kept).
  */
 
 typedef struct soSuperBlock
@@ -128,10 +135,17 @@ typedef struct soSuperBlock
    /** \brief number of free data clusters */
     uint32_t dzone_free;
 
+  /* Geometry of the storage device */
+
+   /** \brief block size (in bytes) */
+    uint32_t block_size;
+   /** \brief number of contiguous blocks in a cluster */
+    uint32_t blocks_per_cluster;
+
   /* Padded area to ensure superblock structure is BLOCK_SIZE bytes long */
 
    /** \brief reserved area */
-    unsigned char reserved[BLOCK_SIZE - PARTITION_NAME_SIZE - 1 - 16 * sizeof(uint32_t) - 2 * sizeof(struct fCNode)];
+    unsigned char reserved[BLOCK_SIZE - PARTITION_NAME_SIZE - 1 - 18 * sizeof(uint32_t) - 2 * sizeof(struct fCNode)];
 } SOSuperBlock;
 
 #endif /* SOFS_SUPERBLOCK_H_ */
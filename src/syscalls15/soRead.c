@@ -61,7 +61,7 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soRead (const char *ePath, void *buff, uint32_t count, int32_t pos)
@@ -72,6 +72,12 @@ int soRead (const char *ePath, void *buff, uint32_t count, int32_t pos)
   uint32_t nInode,nInodeDir,nBlk,off;
   int transfer = 0;         //n de bytes transferidos
   SOInode iNode;
+  SOSuperBlock *p_sb;
+
+  if((stat = soLoadSuperBlock()) != 0)
+    return stat;
+  if((p_sb = soGetSuperBlock()) == NULL)
+    return -EIO;
 
   if ((stat = soGetDirEntryByPath(ePath,&nInodeDir,&nInode)) != 0){
     return stat;
@@ -90,27 +96,56 @@ int soRead (const char *ePath, void *buff, uint32_t count, int32_t pos)
   if((iNode.mode & INODE_TYPE_MASK) == INODE_DIR)
     return -EISDIR;
 
+  if ((uint32_t) pos >= iNode.size)
+    return 0;                                        // posicao inicial no fim ou depois do fim do ficheiro
+
   if (count + pos > iNode.size)
     count = iNode.size - pos;                        // atualizar o n de bytes a ser transferidos se o ultimo byte estiver fora do limite do ficheiro
 
   while(count > 0){
+    uint32_t len;             //n de bytes transferidos nesta iteracao
+
     if((stat = soConvertBPIDC(pos,&nBlk,&off)) != 0){
             return stat;
     }        //obter posição no continuum
 
-    SODataClust cluster;
-    if((stat = soReadFileCluster(nInode, nBlk, &cluster)) != 0){
-            return stat;
-    }                //ler cluster
-
-    if(count > CLUSTER_SIZE - off)
-            memcpy(buff+transfer, &cluster.data[off], CLUSTER_SIZE - off); //copiar porcao do cluster
-    else
-            memcpy(buff+transfer, &cluster.data[off], count);
-
-    transfer += CLUSTER_SIZE - off;
-    count -= CLUSTER_SIZE - off;
-    pos += CLUSTER_SIZE - off;
+    if((off == 0) && (count >= CLUSTER_SIZE)){
+      len = (count / CLUSTER_SIZE) * CLUSTER_SIZE;
+      if((stat = soReadFileClusters(nInode, nBlk, len / CLUSTER_SIZE, buff+transfer)) != 0){
+              return stat;
+      }              //ler clusters completos diretamente para o buffer, agrupando os que sao contiguos no disco
+    }
+    else{
+      uint32_t logicClust;
+      void *p_clust;          //conteudo do cluster fixado na buffercache
+
+      len = (count > CLUSTER_SIZE - off) ? CLUSTER_SIZE - off : count;
+      if((stat = soHandleFileCluster(nInode, nBlk, GET, &logicClust)) != 0){
+              return stat;
+      }              //obter n logico do cluster
+
+      if(logicClust == NULL_CLUSTER)
+        memset(buff+transfer, '\0', len);           //cluster por alocar: le-se como zeros
+      else if((stat = soPinCacheCluster(p_sb->dzone_start + logicClust * BLOCKS_PER_CLUSTER, true, &p_clust)) == 0){
+        memcpy(buff+transfer, (unsigned char *) p_clust + off, len); //copiar porcao do cluster diretamente da buffercache
+        if((stat = soUnpinCache(p_clust)) != 0){
+                return stat;
+        }
+      }
+      else if(stat == -ENOTSUP){
+        SODataClust cluster;
+        if((stat = soReadFileCluster(nInode, nBlk, &cluster)) != 0){
+                return stat;
+        }            //canal sem buffercache: ler cluster
+
+        memcpy(buff+transfer, &cluster.data[off], len); //copiar porcao do cluster
+      }
+      else return stat;
+    }
+
+    transfer += len;
+    count -= len;
+    pos += len;
 	}  
 
   return transfer;
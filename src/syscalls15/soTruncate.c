@@ -34,6 +34,10 @@
 #include "sofs_ifuncs_3.h"
 #include "sofs_ifuncs_4.h"
 
+/* Allusion to internal functions */
+
+static int resizeFile (uint32_t p_nInodeEnt, off_t length);
+
 /**
  *  \brief Truncate a regular file to a specified length.
  *
@@ -58,7 +62,7 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soTruncate (const char *ePath, off_t length)
@@ -74,6 +78,27 @@ int soTruncate (const char *ePath, off_t length)
   if((status = soAccessGranted (p_nInodeEnt, R)) != 0) return status;
   if((status = soAccessGranted (p_nInodeEnt, W)) != 0) return status;
 
+  // the changes are tagged with the inode, so that syncing it does not write those of other files
+  soSetCacheOwner(p_nInodeEnt);
+  status = resizeFile(p_nInodeEnt, length);
+  soSetCacheOwner(CACHE_NO_OWNER);
+
+  return status;
+}
+
+/**
+ *  \brief Resize the data clusters of a regular file, on behalf of soTruncate.
+ *
+ *  \param p_nInodeEnt number of the inode associated to the file
+ *  \param length new size for the regular file
+ *
+ *  \return <tt>0 (zero)</tt>, on success
+ *  \return -<em>specific error</em>, as described for soTruncate
+ */
+
+static int resizeFile (uint32_t p_nInodeEnt, off_t length)
+{
+  int status;
   SOInode p_inode;
   // get file inode
   if((status=soReadInode (&p_inode,p_nInodeEnt))!=0) return status;
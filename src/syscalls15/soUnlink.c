@@ -56,7 +56,7 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific stator</em> issued by \e lseek system call
+ *  \return -<em>other specific stator</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soUnlink (const char *ePath)
@@ -34,6 +34,10 @@
 #include "sofs_ifuncs_3.h"
 #include "sofs_ifuncs_4.h"
 
+/* Allusion to internal functions */
+
+static int writeData (SOSuperBlock *p_sb, uint32_t nInodeEnt, void *buff, uint32_t count, int32_t pos);
+
 /**
  *  \brief Write data into an open regular file.
  *
@@ -61,7 +65,7 @@
  *  \return -\c ELIBBAD, if some kind of inconsistency was detected at some internal storage lower level
  *  \return -\c EBADF, if the device is not already opened
  *  \return -\c EIO, if it fails on writing
- *  \return -<em>other specific error</em> issued by \e lseek system call
+ *  \return -<em>other specific error</em> issued by \e pread, \e pwrite, \e preadv or \e pwritev system calls
  */
 
 int soWrite (const char *ePath, void *buff, uint32_t count, int32_t pos)
@@ -72,11 +76,6 @@ int soWrite (const char *ePath, void *buff, uint32_t count, int32_t pos)
   SOSuperBlock *p_sb;
   uint32_t nInodeDir; // localização do numero do inode associado ao diretorio que tem a entrada que vai ser guardada
   uint32_t nInodeEnt; // localização do numero do inode associado a entrada que vai ser guardada
-  uint32_t offset; // byte dentro do cluster de dados a escrever
-  uint32_t clustInd; // posiçao da tabela de referencias diretas onde se encontra o cluster de dados onde esta o primeiro byte a escrever
-  SOInode iNode;
-  char buff_temp[BSLPC]; //buffer contendo os bytes residentes num determinado cluster
-  char* aux;
 
 
   if((status = soLoadSuperBlock()) != 0)
@@ -90,6 +89,36 @@ int soWrite (const char *ePath, void *buff, uint32_t count, int32_t pos)
   if((status = soGetDirEntryByPath(ePath,&nInodeDir,&nInodeEnt)) != 0)
   	return status;
 
+  // as alterações ficam associadas ao nó-i, para que a sua sincronização não tenha de escrever as dos outros
+  soSetCacheOwner(nInodeEnt);
+  status = writeData(p_sb, nInodeEnt, buff, count, pos);
+  soSetCacheOwner(CACHE_NO_OWNER);
+
+  return status;
+}
+
+/**
+ *  \brief Write data into the clusters of an open regular file, on behalf of soWrite.
+ *
+ *  \param p_sb pointer to the superblock
+ *  \param nInodeEnt number of the inode associated to the file
+ *  \param buff pointer to the buffer where data to be written is stored
+ *  \param count number of bytes to be written
+ *  \param pos starting [byte] position in the file data continuum where data is to be written into
+ *
+ *  \return <em>number of bytes effectively written</em>, on success
+ *  \return -<em>specific error</em>, as described for soWrite
+ */
+
+static int writeData (SOSuperBlock *p_sb, uint32_t nInodeEnt, void *buff, uint32_t count, int32_t pos)
+{
+  int status;
+  uint32_t offset; // byte dentro do cluster de dados a escrever
+  uint32_t clustInd; // posiçao da tabela de referencias diretas onde se encontra o cluster de dados onde esta o primeiro byte a escrever
+  SOInode iNode;
+  char buff_temp[BSLPC]; //buffer contendo os bytes residentes num determinado cluster
+  char* aux;
+
   // se o ficheiro passar o tamanho maximo
   if((pos + count)>=MAX_FILE_SIZE)
   	return -EFBIG;
@@ -120,26 +149,48 @@ int soWrite (const char *ePath, void *buff, uint32_t count, int32_t pos)
 
   aux = buff;
   int wBtyes = 0;
-  int i;
 
-  for(i = 0; i < count; i++){
-  	if(offset == BSLPC ){
-  		if((status = soWriteFileCluster(nInodeEnt, clustInd, &buff_temp)) != 0)
+  while(count > 0){
+  	uint32_t len = (count > BSLPC - offset) ? BSLPC - offset : count; // n de bytes escritos neste cluster
+  	uint32_t nClust; // n logico do cluster de dados
+  	bool fresh; // o cluster de dados acabou de ser alocado
+  	void *p_clust; // conteudo do cluster fixado na buffercache
+
+  	if((status = soHandleFileCluster(nInodeEnt, clustInd, GET, &nClust)) != 0)
+  		return status;
+  	if((fresh = (nClust == NULL_CLUSTER)) && ((status = soHandleFileCluster(nInodeEnt, clustInd, ALLOC, &nClust)) != 0))
+  		return status;
+
+  	// o cluster e alterado diretamente na buffercache, so sendo lido do disco se for escrito parcialmente
+  	status = soPinCacheCluster(p_sb->dzone_start + nClust * BLOCKS_PER_CLUSTER, !fresh && (len < BSLPC), &p_clust);
+  	if(status == 0){
+  		if(fresh && (len < BSLPC))
+  			memset(p_clust, 0, BSLPC);
+  		memcpy((unsigned char *) p_clust + offset, aux + wBtyes, len);
+  		if((status = soMarkCacheChanged(p_clust)) != 0){
+  			soUnpinCache(p_clust);
   			return status;
-  		clustInd++;
-  		if((status = soReadFileCluster(nInodeEnt,clustInd,&buff_temp)) != 0)
+  		}
+  		if((status = soUnpinCache(p_clust)) != 0)
   			return status;
-  		offset = 0;
   	}
+  	else if(status == -ENOTSUP){
+  		// canal sem buffercache: ler, alterar e escrever o cluster
+  		if(fresh)
+  			memset(buff_temp, 0, BSLPC);
+  		else if((len < BSLPC) && ((status = soReadFileCluster(nInodeEnt, clustInd, &buff_temp)) != 0))
+  			return status;
+  		memcpy(buff_temp + offset, aux + wBtyes, len);
+  		if((status = soWriteFileCluster(nInodeEnt, clustInd, &buff_temp)) != 0)
+  			return status;
+  	}
+  	else return status;
 
-  	buff_temp[offset] = aux[i];
-  	offset++;
-  	wBtyes++;
+  	wBtyes += len;
+  	count -= len;
+  	clustInd++;
+  	offset = 0;
   }
 
-  if((status = soWriteFileCluster(nInodeEnt,clustInd,&buff_temp)) != 0)
-  	return status;
-
-
   return wBtyes;
 }
@@ -271,7 +271,10 @@ int main (int argc, char *argv[])
 
   if (cmdNumb == 0) break;
   if ((cmdNumb > 0) && (cmdNumb < HDL_LEN))
-     hdl[cmdNumb]();
+     { hdl[cmdNumb]();
+       soFlushBlocksInT ();                      /* the device is kept up to date after each command */
+       soFlushSuperBlock ();
+     }
      else { notUsed();
             if (batch != 0) break;
           }